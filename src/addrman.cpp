@@ -56,7 +56,7 @@ static constexpr size_t ADDRMAN_SET_TRIED_COLLISION_SIZE{10};
 static constexpr int64_t ADDRMAN_TEST_WINDOW{40 * 60};
 
 int AddrInfo::GetTriedBucket(const uint256 &nKey,
-                             const std::vector<bool> &asmap) const {
+                             const CompiledAsmap &asmap) const {
     uint64_t hash1 =
         (CHashWriter(SER_GETHASH, 0) << nKey << GetKey()).GetCheapHash();
     uint64_t hash2 = (CHashWriter(SER_GETHASH, 0)
@@ -67,7 +67,7 @@ int AddrInfo::GetTriedBucket(const uint256 &nKey,
 }
 
 int AddrInfo::GetNewBucket(const uint256 &nKey, const CNetAddr &src,
-                           const std::vector<bool> &asmap) const {
+                           const CompiledAsmap &asmap) const {
     std::vector<uint8_t> vchSourceGroupKey = src.GetGroup(asmap);
     uint64_t hash1 = (CHashWriter(SER_GETHASH, 0)
                       << nKey << GetGroup(asmap) << vchSourceGroupKey)
@@ -135,8 +135,16 @@ double AddrInfo::GetChance(int64_t nNow) const {
 
 AddrManImpl::AddrManImpl(std::vector<bool> &&asmap,
                          int32_t consistency_check_ratio)
-    : m_consistency_check_ratio{consistency_check_ratio}, m_asmap{std::move(
-                                                              asmap)} {}
+    : m_consistency_check_ratio{consistency_check_ratio},
+      m_asmap{std::move(asmap)}, m_compiled_asmap{m_asmap} {
+    // The compiled asmap must map every address like the asmap interpreter
+    if (m_consistency_check_ratio != 0 &&
+        !m_compiled_asmap.CheckEquivalence(m_asmap)) {
+        LogPrintf("ADDRMAN CONSISTENCY CHECK FAILED!!! compiled asmap "
+                  "differs from the asmap\n");
+        assert(false);
+    }
+}
 
 AddrManImpl::~AddrManImpl() {
     nKey.SetNull();
@@ -322,7 +330,7 @@ template <typename Stream> void AddrManImpl::Unserialize(Stream &s_) {
     for (int n = 0; n < nTried; n++) {
         AddrInfo info;
         s >> info;
-        int nKBucket = info.GetTriedBucket(nKey, m_asmap);
+        int nKBucket = info.GetTriedBucket(nKey, m_compiled_asmap);
         int nKBucketPos = info.GetBucketPosition(nKey, false, nKBucket);
         if (vvTried[nKBucket][nKBucketPos] == -1) {
             info.nRandomPos = vRandom.size();
@@ -399,7 +407,7 @@ template <typename Stream> void AddrManImpl::Unserialize(Stream &s_) {
             // In case the new table data cannot be used (bucket count
             // wrong or new asmap), try to give them a reference based on
             // their primary source address.
-            bucket = info.GetNewBucket(nKey, m_asmap);
+            bucket = info.GetNewBucket(nKey, m_compiled_asmap);
             bucket_position = info.GetBucketPosition(nKey, true, bucket);
             if (vvNew[bucket][bucket_position] == -1) {
                 vvNew[bucket][bucket_position] = entry_index;
@@ -527,7 +535,7 @@ void AddrManImpl::MakeTried(AddrInfo &info, int nId) {
     AssertLockHeld(cs);
 
     // remove the entry from all new buckets
-    const int start_bucket{info.GetNewBucket(nKey, m_asmap)};
+    const int start_bucket{info.GetNewBucket(nKey, m_compiled_asmap)};
     for (int n = 0; n < ADDRMAN_NEW_BUCKET_COUNT; ++n) {
         const int bucket{(start_bucket + n) % ADDRMAN_NEW_BUCKET_COUNT};
         const int pos{info.GetBucketPosition(nKey, true, bucket)};
@@ -544,7 +552,7 @@ void AddrManImpl::MakeTried(AddrInfo &info, int nId) {
     assert(info.nRefCount == 0);
 
     // which tried bucket to move the entry to
-    int nKBucket = info.GetTriedBucket(nKey, m_asmap);
+    int nKBucket = info.GetTriedBucket(nKey, m_compiled_asmap);
     int nKBucketPos = info.GetBucketPosition(nKey, false, nKBucket);
 
     // first make space to add it (the existing tried entry there is moved to
@@ -561,7 +569,7 @@ void AddrManImpl::MakeTried(AddrInfo &info, int nId) {
         nTried--;
 
         // find which new bucket it belongs to
-        int nUBucket = infoOld.GetNewBucket(nKey, m_asmap);
+        int nUBucket = infoOld.GetNewBucket(nKey, m_compiled_asmap);
         int nUBucketPos = infoOld.GetBucketPosition(nKey, true, nUBucket);
         ClearNew(nUBucket, nUBucketPos);
         assert(vvNew[nUBucket][nUBucketPos] == -1);
@@ -617,7 +625,7 @@ void AddrManImpl::Good_(const CService &addr, bool test_before_evict,
     }
 
     // which tried bucket to move the entry to
-    int tried_bucket = info.GetTriedBucket(nKey, m_asmap);
+    int tried_bucket = info.GetTriedBucket(nKey, m_compiled_asmap);
     int tried_bucket_pos = info.GetBucketPosition(nKey, false, tried_bucket);
 
     // Will moving this address into tried evict another entry?
@@ -639,7 +647,8 @@ void AddrManImpl::Good_(const CService &addr, bool test_before_evict,
         // move nId to the tried tables
         MakeTried(info, nId);
         LogPrint(BCLog::ADDRMAN, "Moved %s mapped to AS%i to tried[%i][%i]\n",
-                 addr.ToString(), addr.GetMappedAS(m_asmap), tried_bucket,
+                 addr.ToString(), addr.GetMappedAS(m_compiled_asmap),
+                 tried_bucket,
                  tried_bucket_pos);
     }
 }
@@ -707,7 +716,7 @@ bool AddrManImpl::Add_(const CAddress &addr, const CNetAddr &source,
         fNew = true;
     }
 
-    int nUBucket = pinfo->GetNewBucket(nKey, source, m_asmap);
+    int nUBucket = pinfo->GetNewBucket(nKey, source, m_compiled_asmap);
     int nUBucketPos = pinfo->GetBucketPosition(nKey, true, nUBucket);
     if (vvNew[nUBucket][nUBucketPos] != nId) {
         bool fInsert = vvNew[nUBucket][nUBucketPos] == -1;
@@ -724,7 +733,8 @@ bool AddrManImpl::Add_(const CAddress &addr, const CNetAddr &source,
             pinfo->nRefCount++;
             vvNew[nUBucket][nUBucketPos] = nId;
             LogPrint(BCLog::ADDRMAN, "Added %s mapped to AS%i to new[%i][%i]\n",
-                     addr.ToString(), addr.GetMappedAS(m_asmap), nUBucket,
+                     addr.ToString(), addr.GetMappedAS(m_compiled_asmap),
+                     nUBucket,
                      nUBucketPos);
         } else if (pinfo->nRefCount == 0) {
             Delete(nId);
@@ -945,7 +955,8 @@ void AddrManImpl::ResolveCollisions_() {
             AddrInfo &info_new = mapInfo[id_new];
 
             // Which tried bucket to move the entry to.
-            int tried_bucket = info_new.GetTriedBucket(nKey, m_asmap);
+            int tried_bucket =
+                info_new.GetTriedBucket(nKey, m_compiled_asmap);
             int tried_bucket_pos =
                 info_new.GetBucketPosition(nKey, false, tried_bucket);
             if (!info_new.IsValid()) {
@@ -1029,7 +1040,7 @@ std::pair<CAddress, int64_t> AddrManImpl::SelectTriedCollision_() {
     const AddrInfo &newInfo = id_new_it->second;
 
     // which tried bucket to move the entry to
-    int tried_bucket = newInfo.GetTriedBucket(nKey, m_asmap);
+    int tried_bucket = newInfo.GetTriedBucket(nKey, m_compiled_asmap);
     int tried_bucket_pos = newInfo.GetBucketPosition(nKey, false, tried_bucket);
 
     const AddrInfo &info_old = mapInfo[vvTried[tried_bucket][tried_bucket_pos]];
@@ -1120,7 +1131,7 @@ int AddrManImpl::CheckAddrman() const {
                 }
                 const auto it{mapInfo.find(vvTried[n][i])};
                 if (it == mapInfo.end() ||
-                    it->second.GetTriedBucket(nKey, m_asmap) != n) {
+                    it->second.GetTriedBucket(nKey, m_compiled_asmap) != n) {
                     return -17;
                 }
                 if (it->second.GetBucketPosition(nKey, false, n) != i) {
@@ -1248,8 +1259,8 @@ void AddrManImpl::SetServices(const CService &addr, ServiceFlags nServices) {
     Check();
 }
 
-const std::vector<bool> &AddrManImpl::GetAsmap() const {
-    return m_asmap;
+const CompiledAsmap &AddrManImpl::GetAsmap() const {
+    return m_compiled_asmap;
 }
 
 void AddrManImpl::Clear() {
@@ -1355,7 +1366,7 @@ void AddrMan::SetServices(const CService &addr, ServiceFlags nServices) {
     m_impl->SetServices(addr, nServices);
 }
 
-const std::vector<bool> &AddrMan::GetAsmap() const {
+const CompiledAsmap &AddrMan::GetAsmap() const {
     return m_impl->GetAsmap();
 }
 
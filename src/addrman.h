@@ -23,6 +23,7 @@ public:
 };
 
 class AddrManImpl;
+class CompiledAsmap;
 
 /** Default for -checkaddrman */
 static constexpr int32_t DEFAULT_ADDRMAN_CONSISTENCY_CHECKS{0};
@@ -147,7 +148,7 @@ public:
     //! Update an entry's service bits.
     void SetServices(const CService &addr, ServiceFlags nServices);
 
-    const std::vector<bool> &GetAsmap() const;
+    const CompiledAsmap &GetAsmap() const;
 
     void Clear();
 
@@ -12,6 +12,7 @@
 #include <serialize.h>
 #include <sync.h>
 #include <uint256.h>
+#include <util/asmap.h>
 
 #include <cstdint>
 #include <optional>
@@ -75,18 +76,16 @@ public:
     AddrInfo() : CAddress(), source() {}
 
     //! Calculate in which "tried" bucket this entry belongs
-    int GetTriedBucket(const uint256 &nKey,
-                       const std::vector<bool> &asmap) const;
+    int GetTriedBucket(const uint256 &nKey, const CompiledAsmap &asmap) const;
 
     //! Calculate in which "new" bucket this entry belongs, given a certain
     //! source
     int GetNewBucket(const uint256 &nKey, const CNetAddr &src,
-                     const std::vector<bool> &asmap) const;
+                     const CompiledAsmap &asmap) const;
 
     //! Calculate in which "new" bucket this entry belongs, using its default
     //! source
-    int GetNewBucket(const uint256 &nKey,
-                     const std::vector<bool> &asmap) const {
+    int GetNewBucket(const uint256 &nKey, const CompiledAsmap &asmap) const {
         return GetNewBucket(nKey, source, asmap);
     }
 
@@ -143,7 +142,7 @@ public:
     void SetServices(const CService &addr, ServiceFlags nServices)
         EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
-    const std::vector<bool> &GetAsmap() const;
+    const CompiledAsmap &GetAsmap() const;
 
     void Clear() EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
@@ -245,6 +244,8 @@ private:
     // If a new asmap was provided, the existing records
     // would be re-bucketed accordingly.
     const std::vector<bool> m_asmap;
+    //! m_asmap compiled for the lookups
+    const CompiledAsmap m_compiled_asmap;
 
     //! Use deterministic bucket selection and inner loops randomization.
     //! For testing purpose only.
@@ -5,9 +5,11 @@
 #include <addrman.h>
 #include <bench/bench.h>
 #include <random.h>
+#include <util/asmap.h>
 #include <util/check.h>
 #include <util/time.h>
 
+#include <cassert>
 #include <optional>
 #include <vector>
 
@@ -68,6 +70,101 @@ static void FillAddrMan(AddrMan &addrman) {
     AddAddressesToAddrMan(addrman);
 }
 
+/**
+ * Append val to the asmap bytecode, in the variable length encoding read by
+ * DecodeBits() in util/asmap.cpp.
+ */
+static void EncodeAsmapBits(std::vector<bool> &asmap, uint32_t val,
+                            uint32_t minval,
+                            const std::vector<uint8_t> &bit_sizes) {
+    val -= minval;
+    for (size_t i = 0; i < bit_sizes.size(); ++i) {
+        const bool last = i + 1 == bit_sizes.size();
+        if (val >= (uint32_t(1) << bit_sizes[i])) {
+            assert(!last);
+            asmap.push_back(true);
+            val -= uint32_t(1) << bit_sizes[i];
+            continue;
+        }
+        if (!last) {
+            asmap.push_back(false);
+        }
+        for (int bit = bit_sizes[i] - 1; bit >= 0; --bit) {
+            asmap.push_back((val >> bit) & 1);
+        }
+        return;
+    }
+}
+
+static void EncodeReturn(std::vector<bool> &asmap, uint32_t asn) {
+    // Opcode 0
+    asmap.push_back(false);
+    EncodeAsmapBits(asmap, asn, 1, {15, 16, 17, 18, 19, 20, 21, 22, 23, 24});
+}
+
+static void EncodeMatchByte(std::vector<bool> &asmap, uint8_t byte) {
+    // Opcode 2
+    asmap.insert(asmap.end(), {true, true, false});
+    EncodeAsmapBits(asmap, 0x100 | byte, 2, {1, 2, 3, 4, 5, 6, 7, 8});
+}
+
+/**
+ * Encode a complete tree of jumps over the next depth bits of the address,
+ * with leaves encoded by encode_leaf(prefix).
+ */
+template <typename F>
+static std::vector<bool> EncodeJumpTree(int depth, uint32_t prefix,
+                                        F encode_leaf) {
+    std::vector<bool> asmap;
+    if (depth == 0) {
+        encode_leaf(asmap, prefix);
+        return asmap;
+    }
+    const std::vector<bool> zero =
+        EncodeJumpTree(depth - 1, prefix << 1, encode_leaf);
+    const std::vector<bool> one =
+        EncodeJumpTree(depth - 1, (prefix << 1) | 1, encode_leaf);
+    // Opcode 1, then the offset of the subtree taken when the bit is set
+    asmap.insert(asmap.end(), {true, false});
+    EncodeAsmapBits(asmap, zero.size(), 17,
+                    {5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16, 17,
+                     18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30});
+    asmap.insert(asmap.end(), zero.begin(), zero.end());
+    asmap.insert(asmap.end(), one.begin(), one.end());
+    return asmap;
+}
+
+/**
+ * An asmap mapping every IPv6 /16 and every IPv4 /16 to its own AS, a few
+ * hundred kB in size like the asmaps used on the network.
+ */
+static std::vector<bool> MakeAsmap() {
+    const auto asn = [](uint32_t prefix) {
+        return 1 + (prefix * 2654435761U) % 400000;
+    };
+    std::vector<bool> ipv4_tree = EncodeJumpTree(
+        16, 0, [&](std::vector<bool> &asmap, uint32_t prefix) {
+            EncodeReturn(asmap, asn(0x10000 | prefix));
+        });
+    std::vector<bool> asmap = EncodeJumpTree(
+        16, 0, [&](std::vector<bool> &asmap, uint32_t prefix) {
+            if (prefix != 0) {
+                EncodeReturn(asmap, asn(prefix));
+                return;
+            }
+            // The rest of the IPv4-in-IPv6 prefix ::ffff:0:0/96
+            for (int i = 2; i < 12; ++i) {
+                EncodeMatchByte(asmap, i < 10 ? 0x00 : 0xff);
+            }
+            asmap.insert(asmap.end(), ipv4_tree.begin(), ipv4_tree.end());
+        });
+    while (asmap.size() % 8 != 0) {
+        asmap.push_back(false);
+    }
+    assert(SanityCheckASMap(asmap, 128));
+    return asmap;
+}
+
 /* Benchmarks */
 
 static void AddrManAdd(benchmark::Bench &bench) {
@@ -82,6 +179,49 @@ static void AddrManAdd(benchmark::Bench &bench) {
     });
 }
 
+static void AddrManAddWithAsmap(benchmark::Bench &bench) {
+    CreateAddresses();
+
+    AddrMan addrman(MakeAsmap(), /* consistency_check_ratio= */ 0);
+
+    bench.run([&] {
+        AddAddressesToAddrMan(addrman);
+        addrman.Clear();
+    });
+}
+
+/** Map all the addresses with the asmap interpreter. */
+static void AsmapInterpret(benchmark::Bench &bench) {
+    CreateAddresses();
+
+    const std::vector<bool> asmap = MakeAsmap();
+    bench.run([&] {
+        uint64_t sum = 0;
+        for (const std::vector<CAddress> &addresses : g_addresses) {
+            for (const CAddress &addr : addresses) {
+                sum += addr.GetMappedAS(asmap);
+            }
+        }
+        assert(sum > 0);
+    });
+}
+
+/** Same as AsmapInterpret, with the compiled asmap. */
+static void AsmapLookup(benchmark::Bench &bench) {
+    CreateAddresses();
+
+    const CompiledAsmap asmap{MakeAsmap()};
+    bench.run([&] {
+        uint64_t sum = 0;
+        for (const std::vector<CAddress> &addresses : g_addresses) {
+            for (const CAddress &addr : addresses) {
+                sum += addr.GetMappedAS(asmap);
+            }
+        }
+        assert(sum > 0);
+    });
+}
+
 static void AddrManSelect(benchmark::Bench &bench) {
     AddrMan addrman(/* asmap= */ std::vector<bool>(),
                     /* consistency_check_ratio= */ 0);
@@ -138,7 +278,27 @@ static void AddrManAddThenGood(benchmark::Bench &bench) {
     });
 }
 
+static void AddrManAddThenGoodWithAsmap(benchmark::Bench &bench) {
+    CreateAddresses();
+
+    const std::vector<bool> asmap = MakeAsmap();
+    bench.run([&] {
+        AddrMan addrman(asmap, /*consistency_check_ratio=*/0);
+        AddAddressesToAddrMan(addrman);
+        for (size_t source_i = 0; source_i < NUM_SOURCES; ++source_i) {
+            for (size_t addr_i = 0; addr_i < NUM_ADDRESSES_PER_SOURCE;
+                 ++addr_i) {
+                addrman.Good(g_addresses[source_i][addr_i]);
+            }
+        }
+    });
+}
+
 BENCHMARK(AddrManAdd);
+BENCHMARK(AddrManAddWithAsmap);
 BENCHMARK(AddrManSelect);
 BENCHMARK(AddrManGetAddr);
 BENCHMARK(AddrManAddThenGood);
+BENCHMARK(AddrManAddThenGoodWithAsmap);
+BENCHMARK(AsmapInterpret);
+BENCHMARK(AsmapLookup);
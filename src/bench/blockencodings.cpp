@@ -0,0 +1,91 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <blockencodings.h>
+#include <config.h>
+#include <consensus/amount.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+
+#include <vector>
+
+//! Number of mempool transactions that are included in the compact block
+static constexpr size_t BLOCK_TX_COUNT = 2000;
+
+static void AddTx(const CTransactionRef &tx, CTxMemPool &pool)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs) {
+    LockPoints lp;
+    pool.addUnchecked(CTxMemPoolEntry(tx, 1000 * SATOSHI, /*time=*/0,
+                                      /*entry_height=*/1,
+                                      /*spends_coinbase=*/false,
+                                      /*sigchecks=*/1, lp));
+}
+
+/**
+ * Reconstruct a compact block against a mempool of mempool_size transactions,
+ * which is dominated by the computation of the mempool shortids.
+ */
+static void InitData(benchmark::Bench &bench, size_t mempool_size) {
+    const BasicTestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+
+    CTxMemPool pool;
+    CBlock block;
+    {
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vout.resize(1);
+        coinbase.vout[0].nValue = 50 * COIN;
+        block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+    }
+    block.nBits = 0x207fffff;
+
+    {
+        LOCK2(cs_main, pool.cs);
+        for (size_t i = 0; i < mempool_size; i++) {
+            CMutableTransaction tx;
+            tx.vin.resize(1);
+            tx.vin[0].scriptSig = CScript() << int64_t(i);
+            tx.vout.resize(1);
+            tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+            tx.vout[0].nValue = 10 * COIN;
+            CTransactionRef txref = MakeTransactionRef(std::move(tx));
+            AddTx(txref, pool);
+            if (i % (mempool_size / BLOCK_TX_COUNT) == 0 &&
+                block.vtx.size() <= BLOCK_TX_COUNT) {
+                block.vtx.push_back(txref);
+            }
+        }
+    }
+
+    const CBlockHeaderAndShortTxIDs cmpctblock{block};
+    const std::vector<std::pair<TxHash, CTransactionRef>> extra_txn;
+
+    bench.run([&] {
+        PartiallyDownloadedBlock partial_block(GetConfig(), &pool);
+        const ReadStatus status = partial_block.InitData(cmpctblock, extra_txn);
+        assert(status == READ_STATUS_OK);
+        assert(partial_block.IsTxAvailable(BLOCK_TX_COUNT));
+    });
+}
+
+static void InitDataMempool100k(benchmark::Bench &bench) {
+    InitData(bench, 100000);
+}
+
+static void InitDataMempool500k(benchmark::Bench &bench) {
+    InitData(bench, 500000);
+}
+
+BENCHMARK(InitDataMempool100k);
+BENCHMARK(InitDataMempool500k);
@@ -0,0 +1,119 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <blockencodings.h>
+#include <blockreconciliation.h>
+#include <chainparams.h>
+#include <config.h>
+#include <consensus/amount.h>
+#include <consensus/merkle.h>
+#include <hash.h>
+#include <pow/pow.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <txmempool.h>
+
+#include <algorithm>
+#include <vector>
+
+static CTransactionRef MakeTx(uint64_t n) {
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(TxId(SerializeHash(n)), 0);
+    tx.vin[0].scriptSig = CScript() << int64_t(n);
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+    tx.vout[0].nValue = 10 * COIN;
+    return MakeTransactionRef(std::move(tx));
+}
+
+/**
+ * Rebuild a block of block_size transactions from a mempool holding the whole
+ * block plus 50% unrelated transactions. The bench name is updated with the
+ * size of the reconblock and cmpctblock messages.
+ */
+static void ReconcileBlock(benchmark::Bench &bench, size_t block_size) {
+    const BasicTestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+    const Config &config = GetConfig();
+
+    CBlock block;
+    {
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vin[0].scriptSig = CScript() << OP_0 << OP_0;
+        coinbase.vout.resize(1);
+        coinbase.vout[0].nValue = 50 * COIN;
+        block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+    }
+    block.nBits = 0x207fffff;
+
+    CTxMemPool pool;
+    {
+        LOCK2(cs_main, pool.cs);
+        for (size_t i = 0; i < block_size * 3 / 2; i++) {
+            const CTransactionRef tx = MakeTx(i);
+            LockPoints lp;
+            pool.addUnchecked(CTxMemPoolEntry(tx, 1000 * SATOSHI, /*time=*/0,
+                                              /*entry_height=*/1,
+                                              /*spends_coinbase=*/false,
+                                              /*sigchecks=*/1, lp));
+            if (i < block_size) {
+                block.vtx.push_back(tx);
+            }
+        }
+    }
+
+    std::sort(block.vtx.begin() + 1, block.vtx.end(),
+              [](const CTransactionRef &a, const CTransactionRef &b) {
+                  return a->GetId() < b->GetId();
+              });
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    while (!CheckProofOfWork(block.GetHash(), block.nBits,
+                             config.GetChainParams().GetConsensus())) {
+        ++block.nNonce;
+    }
+
+    const CBlockHeaderAndShortTxIDs cmpctblock{block};
+    const CBlockHeaderAndReconciliation reconblock{cmpctblock, pool.size()};
+    bench.name(strprintf("ReconcileBlock%u (reconblock: %u bytes, "
+                         "cmpctblock: %u bytes)",
+                         block_size,
+                         GetSerializeSize(reconblock, PROTOCOL_VERSION),
+                         GetSerializeSize(cmpctblock, PROTOCOL_VERSION)));
+
+    const std::vector<std::pair<TxHash, CTransactionRef>> extra_txn;
+    bench.unit("block").run([&] {
+        CBlock reconstructed;
+        const ReadStatus status =
+            reconblock.FillBlock(config, pool, extra_txn, reconstructed);
+        assert(status == READ_STATUS_OK);
+    });
+}
+
+static void ReconcileBlock1000(benchmark::Bench &bench) {
+    ReconcileBlock(bench, 1000);
+}
+
+static void ReconcileBlock10000(benchmark::Bench &bench) {
+    ReconcileBlock(bench, 10000);
+}
+
+static void ReconcileBlock100000(benchmark::Bench &bench) {
+    ReconcileBlock(bench, 100000);
+}
+
+BENCHMARK(ReconcileBlock1000);
+BENCHMARK(ReconcileBlock10000);
+BENCHMARK(ReconcileBlock100000);
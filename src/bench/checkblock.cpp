@@ -7,10 +7,18 @@
 
 #include <chainparams.h>
 #include <config.h>
+#include <consensus/amount.h>
+#include <consensus/merkle.h>
 #include <consensus/validation.h>
+#include <hash.h>
+#include <script/script.h>
 #include <streams.h>
+#include <util/system.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <map>
+
 // These are the two major time-sinks which happen after we have fully received
 // a block off the wire, but before we can relay the block on to peers using
 // compact block relay.
@@ -29,6 +37,42 @@ static void DeserializeBlockTest(benchmark::Bench &bench) {
     });
 }
 
+/**
+ * Deserialize the same block when all its transactions are already known, as
+ * when they are in the mempool, so only the header and the transaction
+ * boundaries and hashes need to be read.
+ */
+static void DeserializeBlockKnownTxsTest(benchmark::Bench &bench) {
+    CDataStream stream(benchmark::data::block413567, SER_NETWORK,
+                       PROTOCOL_VERSION);
+    char a = '\0';
+    stream.write(&a, 1); // Prevent compaction
+
+    std::map<TxId, CTransactionRef> known;
+    {
+        CBlock block;
+        stream >> block;
+        bool rewound = stream.Rewind(benchmark::data::block413567.size());
+        assert(rewound);
+        for (const CTransactionRef &tx : block.vtx) {
+            known.emplace(tx->GetId(), tx);
+        }
+    }
+    const TransactionLookup lookup = [&](const std::vector<TxId> &txids,
+                                         std::vector<CTransactionRef> &txs) {
+        for (size_t i = 0; i < txids.size(); i++) {
+            txs[i] = known.at(txids[i]);
+        }
+    };
+
+    bench.unit("block").run([&] {
+        CBlock block;
+        UnserializeBlock(stream, block, lookup);
+        bool rewound = stream.Rewind(benchmark::data::block413567.size());
+        assert(rewound);
+    });
+}
+
 static void DeserializeAndCheckBlockTest(benchmark::Bench &bench) {
     CDataStream stream(benchmark::data::block413567, SER_NETWORK,
                        PROTOCOL_VERSION);
@@ -52,5 +96,59 @@ static void DeserializeAndCheckBlockTest(benchmark::Bench &bench) {
     });
 }
 
+/**
+ * Check a synthesized block of 100,000 transactions, about 14MB, using the
+ * given number of script check threads on top of the calling thread.
+ */
+static void CheckLargeBlock(benchmark::Bench &bench, int threads) {
+    SelectParams(CBaseChainParams::MAIN);
+
+    CBlock block;
+    for (uint32_t i = 0; i < 100000; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].scriptSig = CScript() << OP_0 << OP_0;
+        if (i > 0) {
+            tx.vin[0].prevout = COutPoint(TxId(SerializeHash(i)), 0);
+            tx.vin[0].scriptSig = CScript() << std::vector<uint8_t>(72)
+                                            << std::vector<uint8_t>(33);
+        }
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+        tx.vout[0].nValue = 10 * COIN;
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+    }
+    std::sort(block.vtx.begin() + 1, block.vtx.end(),
+              [](const CTransactionRef &a, const CTransactionRef &b) {
+                  return a->GetId() < b->GetId();
+              });
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+
+    const Config &config = GetConfig();
+    const Consensus::Params params = config.GetChainParams().GetConsensus();
+    const BlockValidationOptions options =
+        BlockValidationOptions(config).withCheckPoW(false);
+
+    StartScriptCheckWorkerThreads(threads);
+    bench.unit("block").run([&] {
+        BlockValidationState validationState;
+        bool checked = CheckBlock(block, validationState, params, options);
+        assert(checked);
+    });
+    StopScriptCheckWorkerThreads();
+}
+
+static void CheckLargeBlockSingleThread(benchmark::Bench &bench) {
+    CheckLargeBlock(bench, 0);
+}
+
+static void CheckLargeBlockAllThreads(benchmark::Bench &bench) {
+    CheckLargeBlock(bench, std::min(GetNumCores() - 1,
+                                    MAX_SCRIPTCHECK_THREADS));
+}
+
 BENCHMARK(DeserializeBlockTest);
+BENCHMARK(DeserializeBlockKnownTxsTest);
 BENCHMARK(DeserializeAndCheckBlockTest);
+BENCHMARK(CheckLargeBlockSingleThread);
+BENCHMARK(CheckLargeBlockAllThreads);
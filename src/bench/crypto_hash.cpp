@@ -59,6 +59,50 @@ static void SHA256D64_1024(benchmark::Bench &bench) {
         [&] { SHA256D64(in.data(), in.data(), 1024); });
 }
 
+static std::vector<Span<const uint8_t>>
+SplitMessages(const std::vector<uint8_t> &in, size_t msg_size) {
+    std::vector<Span<const uint8_t>> msgs;
+    for (size_t pos = 0; pos + msg_size <= in.size(); pos += msg_size) {
+        msgs.emplace_back(in.data() + pos, msg_size);
+    }
+    return msgs;
+}
+
+/** Hash 1024 messages of msg_size bytes one at a time. */
+static void SHA256DOneByOne(benchmark::Bench &bench, size_t msg_size) {
+    std::vector<uint8_t> in(msg_size * 1024, 0);
+    const auto msgs = SplitMessages(in, msg_size);
+    std::vector<uint8_t> out(32 * msgs.size());
+    bench.batch(in.size()).unit("byte").run([&] {
+        for (size_t i = 0; i < msgs.size(); ++i) {
+            CHash256().Write(msgs[i]).Finalize({out.data() + 32 * i, 32});
+        }
+    });
+}
+
+/** Hash 1024 messages of msg_size bytes with SHA256DMulti. */
+static void SHA256DMultiMessage(benchmark::Bench &bench, size_t msg_size) {
+    std::vector<uint8_t> in(msg_size * 1024, 0);
+    const auto msgs = SplitMessages(in, msg_size);
+    std::vector<uint8_t> out(32 * msgs.size());
+    bench.batch(in.size()).unit("byte").run(
+        [&] { SHA256DMulti(out.data(), msgs.data(), msgs.size()); });
+}
+
+// 250 bytes is about the size of a typical transaction.
+static void SHA256D_250b_1024(benchmark::Bench &bench) {
+    SHA256DOneByOne(bench, 250);
+}
+static void SHA256DMulti_250b_1024(benchmark::Bench &bench) {
+    SHA256DMultiMessage(bench, 250);
+}
+static void SHA256D_1000b_1024(benchmark::Bench &bench) {
+    SHA256DOneByOne(bench, 1000);
+}
+static void SHA256DMulti_1000b_1024(benchmark::Bench &bench) {
+    SHA256DMultiMessage(bench, 1000);
+}
+
 static void SHA512(benchmark::Bench &bench) {
     uint8_t hash[CSHA512::OUTPUT_SIZE];
     std::vector<uint8_t> in(BUFFER_SIZE, 0);
@@ -128,6 +172,10 @@ BENCHMARK(SHA3_256_1M);
 BENCHMARK(SHA256_32b);
 BENCHMARK(SipHash_32b);
 BENCHMARK(SHA256D64_1024);
+BENCHMARK(SHA256D_250b_1024);
+BENCHMARK(SHA256DMulti_250b_1024);
+BENCHMARK(SHA256D_1000b_1024);
+BENCHMARK(SHA256DMulti_1000b_1024);
 BENCHMARK(FastRandom_32bit);
 BENCHMARK(FastRandom_1bit);
 
@@ -0,0 +1,74 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <logging.h>
+#include <test/util/setup_common.h>
+
+#include <cassert>
+
+//! Number of messages logged per iteration by the throughput benches
+static constexpr size_t NUM_MESSAGES = 1000;
+
+/**
+ * Log to a file, synchronously or from the background writer. With flush set,
+ * the bench waits for the messages to be written after each iteration, so it
+ * measures the logging throughput, otherwise only the time spent by the
+ * logging thread.
+ */
+static void Logging(benchmark::Bench &bench, bool async, bool flush) {
+    const BasicTestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+
+    BCLog::Logger logger;
+    logger.m_print_to_file = true;
+    logger.m_file_path = test_setup.m_path_root / "bench.log";
+    logger.m_log_timestamps = true;
+    logger.m_log_time_micros = true;
+    const bool started = logger.StartLogging();
+    assert(started);
+    if (async) {
+        logger.StartAsyncLogging();
+    }
+
+    const std::string msg{"Logging a message of a typical size to the log\n"};
+    const auto log = [&] {
+        logger.LogPrintStr(msg, __func__, __FILE__, __LINE__);
+    };
+    if (flush) {
+        bench.batch(NUM_MESSAGES).unit("message").run([&] {
+            for (size_t i = 0; i < NUM_MESSAGES; i++) {
+                log();
+            }
+            logger.Flush();
+        });
+    } else {
+        bench.unit("message").run(log);
+    }
+
+    logger.StopAsyncLogging();
+}
+
+static void LoggingSync(benchmark::Bench &bench) {
+    Logging(bench, /*async=*/false, /*flush=*/false);
+}
+
+static void LoggingAsync(benchmark::Bench &bench) {
+    Logging(bench, /*async=*/true, /*flush=*/false);
+}
+
+static void LoggingAsyncFlushed(benchmark::Bench &bench) {
+    Logging(bench, /*async=*/true, /*flush=*/true);
+}
+
+BENCHMARK(LoggingSync);
+BENCHMARK(LoggingAsync);
+BENCHMARK(LoggingAsyncFlushed);
@@ -0,0 +1,162 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <addrman.h>
+#include <chain.h>
+#include <config.h>
+#include <consensus/amount.h>
+#include <hash.h>
+#include <net.h>
+#include <net_processing.h>
+#include <netmessagemaker.h>
+#include <pow/pow.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <protocol.h>
+#include <script/script.h>
+#include <test/util/net.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <validation.h>
+#include <version.h>
+
+#include <atomic>
+#include <cassert>
+#include <vector>
+
+//! Number of transactions received ahead of the block announcement
+static constexpr size_t TX_FLOOD_SIZE = 1000;
+static constexpr size_t NUM_ITERATIONS = 10;
+
+/**
+ * Receive a flood of transactions from a peer followed by a headers
+ * announcement, and process the messages of the peer until the headers have
+ * been processed. This is the latency added to the block relay by the
+ * transactions waiting ahead of it, with and without -prioritymessages. The
+ * bench name is updated with the number of messages processed per pass.
+ */
+static void BlockBehindTxFlood(benchmark::Bench &bench, bool prioritize) {
+    const TestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+    const Config &config = GetConfig();
+
+    AddrMan addrman(/*asmap=*/{}, /*consistency_check_ratio=*/0);
+    ConnmanTestMsg connman(config, 0x1337, 0x1337, addrman);
+    connman.SetPeerConnectTimeout(99999s);
+    connman.SetPriorityMessages(prioritize);
+    const std::unique_ptr<PeerManager> peerman = PeerManager::make(
+        config.GetChainParams(), connman, addrman,
+        /*banman=*/nullptr, *test_setup.m_node.chainman,
+        *test_setup.m_node.mempool, /*ignore_incoming_txs=*/false);
+
+    CNode *node = new CNode(
+        0, NODE_NETWORK, INVALID_SOCKET, CAddress(), /*nKeyedNetGroupIn=*/0,
+        /*nLocalHostNonceIn=*/0, /*nLocalExtraEntropyIn=*/0, CAddress(),
+        /*pszDest=*/"", ConnectionType::OUTBOUND_FULL_RELAY,
+        /*inbound_onion=*/false);
+    node->SetCommonVersion(PROTOCOL_VERSION);
+    peerman->InitializeNode(config, node);
+    node->fSuccessfullyConnected = true;
+    connman.AddTestNode(*node);
+
+    // The transactions spend unknown outputs, so each one goes through the
+    // mempool acceptance up to the missing inputs and ends in the orphanage.
+    std::vector<CTransactionRef> txs;
+    for (size_t i = 0; i < (NUM_ITERATIONS + 1) * TX_FLOOD_SIZE; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(TxId(SerializeHash(i)), 0);
+        tx.vin[0].scriptSig = CScript() << OP_1;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        tx.vout[0].nValue = 10 * COIN;
+        txs.push_back(MakeTransactionRef(std::move(tx)));
+    }
+
+    CBlockHeader header;
+    {
+        LOCK(cs_main);
+        const CBlockIndex *tip =
+            test_setup.m_node.chainman->ActiveChain().Tip();
+        header.nVersion = tip->nVersion;
+        header.hashPrevBlock = tip->GetBlockHash();
+        header.nTime = tip->GetBlockTime() + 1;
+        header.nBits = tip->nBits;
+    }
+    while (!CheckProofOfWork(header.GetHash(), header.nBits,
+                             config.GetChainParams().GetConsensus())) {
+        ++header.nNonce;
+    }
+
+    const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    std::atomic<bool> interrupt{false};
+    // With the prioritization, the headers jump ahead of the transactions
+    const size_t expected_processed = prioritize ? 1 : TX_FLOOD_SIZE + 1;
+    bench.name(strprintf("BlockBehindTxFlood%s (%u messages processed)",
+                         prioritize ? "Prioritized" : "Unprioritized",
+                         expected_processed));
+
+    size_t next_tx = 0;
+    bench.epochs(NUM_ITERATIONS).epochIterations(1).run([&] {
+        assert(next_tx + TX_FLOOD_SIZE <= txs.size());
+        for (size_t i = 0; i < TX_FLOOD_SIZE; i++, next_tx++) {
+            CSerializedNetMsg msg =
+                msgMaker.Make(NetMsgType::TX, *txs[next_tx]);
+            connman.ReceiveMsgFrom(*node, msg);
+        }
+        CSerializedNetMsg msg = msgMaker.Make(
+            NetMsgType::HEADERS, std::vector<CBlockHeader>{header});
+        connman.ReceiveMsgFrom(*node, msg);
+
+        // ProcessMessages handles one message per call
+        size_t processed = 0;
+        bool headers_processed = false;
+        while (!headers_processed) {
+            headers_processed = WITH_LOCK(
+                node->cs_vProcessMsg,
+                return node->vProcessMsg.front().m_command ==
+                       NetMsgType::HEADERS);
+            // Nothing is sent until the headers, so the messages are never
+            // held back by a full send buffer.
+            assert(!node->fDisconnect && !node->fPauseSend);
+            peerman->ProcessMessages(config, node, interrupt);
+            ++processed;
+        }
+        assert(processed == expected_processed);
+
+        // Drop the remaining messages and the replies
+        {
+            LOCK(node->cs_vProcessMsg);
+            node->vProcessMsg.clear();
+            node->nProcessQueueSize = 0;
+            node->fPauseRecv = false;
+        }
+        LOCK(node->cs_vSend);
+        node->vSendMsg.clear();
+        node->nSendSize = 0;
+        node->fPauseSend = false;
+    });
+
+    peerman->FinalizeNode(config, *node);
+    connman.ClearTestNodes();
+}
+
+static void BlockBehindTxFloodPrioritized(benchmark::Bench &bench) {
+    BlockBehindTxFlood(bench, /*prioritize=*/true);
+}
+
+static void BlockBehindTxFloodUnprioritized(benchmark::Bench &bench) {
+    BlockBehindTxFlood(bench, /*prioritize=*/false);
+}
+
+BENCHMARK(BlockBehindTxFloodPrioritized);
+BENCHMARK(BlockBehindTxFloodUnprioritized);
@@ -0,0 +1,111 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+
+#include <config.h>
+#include <net.h>
+#include <netmessagemaker.h>
+#include <primitives/block.h>
+#include <protocol.h>
+#include <span.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <version.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+//! Size of the chunks the data is received by, as in CConnman
+static constexpr size_t RECV_CHUNK_SIZE = 0x10000;
+
+/**
+ * Receive the transactions of block 413567 followed by the block itself, in
+ * chunks of RECV_CHUNK_SIZE bytes. The bench name is updated with the number
+ * of receive buffers allocated per pass, once the pool is warm.
+ */
+static void ReceiveMessages(benchmark::Bench &bench, bool pooled) {
+    const BasicTestingSetup test_setup{
+        CBaseChainParams::MAIN,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+    const Config &config = GetConfig();
+
+    CBlock block;
+    CDataStream stream(benchmark::data::block413567, SER_NETWORK,
+                       PROTOCOL_VERSION);
+    stream >> block;
+
+    const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    V1TransportSerializer serializer;
+    std::vector<uint8_t> wire;
+    size_t num_messages = 0;
+    const auto append = [&](CSerializedNetMsg msg) {
+        std::vector<uint8_t> header;
+        serializer.prepareForTransport(config, msg, header);
+        wire.insert(wire.end(), header.begin(), header.end());
+        wire.insert(wire.end(), msg.data.begin(), msg.data.end());
+        ++num_messages;
+    };
+    for (const CTransactionRef &tx : block.vtx) {
+        append(msgMaker.Make(NetMsgType::TX, *tx));
+    }
+    append(msgMaker.Make(NetMsgType::BLOCK, block));
+
+    RecvBufferPool pool(pooled ? RecvBufferPool::MAX_POOLED_BYTES : 0);
+    V1TransportDeserializer deserializer(config.GetChainParams().NetMagic(),
+                                         SER_NETWORK, PROTOCOL_VERSION,
+                                         pool);
+    const auto receive = [&] {
+        size_t received = 0;
+        Span<const uint8_t> remaining{wire};
+        while (!remaining.empty()) {
+            Span<const uint8_t> chunk =
+                remaining.first(std::min(remaining.size(), RECV_CHUNK_SIZE));
+            remaining = remaining.subspan(chunk.size());
+            while (!chunk.empty()) {
+                if (deserializer.Read(config, chunk) < 0) {
+                    assert(!"invalid message");
+                }
+                if (deserializer.Complete()) {
+                    // The buffer is returned to the pool as the message is
+                    // destroyed.
+                    const CNetMessage msg = deserializer.GetMessage(
+                        config, std::chrono::microseconds{0});
+                    assert(msg.m_valid_checksum);
+                    ++received;
+                }
+            }
+        }
+        assert(received == num_messages);
+    };
+
+    receive();
+    const uint64_t allocated = pool.GetStats().allocated;
+    receive();
+    bench.name(strprintf("ReceiveMessages%s (%u messages, %u buffer "
+                         "allocations)",
+                         pooled ? "Pooled" : "Unpooled", num_messages,
+                         pool.GetStats().allocated - allocated));
+
+    bench.unit("pass").run(receive);
+}
+
+static void ReceiveMessagesPooled(benchmark::Bench &bench) {
+    ReceiveMessages(bench, /*pooled=*/true);
+}
+
+static void ReceiveMessagesUnpooled(benchmark::Bench &bench) {
+    ReceiveMessages(bench, /*pooled=*/false);
+}
+
+BENCHMARK(ReceiveMessagesPooled);
+BENCHMARK(ReceiveMessagesUnpooled);
@@ -0,0 +1,132 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+
+#include <addrman.h>
+#include <config.h>
+#include <net.h>
+#include <netmessagemaker.h>
+#include <primitives/block.h>
+#include <protocol.h>
+#include <streams.h>
+#include <test/util/net.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <version.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// socketpair is not available on Windows
+#ifndef WIN32
+#include <sys/socket.h>
+#include <unistd.h>
+
+//! Number of peers the block is relayed to
+static constexpr size_t NUM_PEERS = 16;
+
+/**
+ * Relay block 413567 to NUM_PEERS peers connected through socketpairs, either
+ * serializing the block for each peer or sharing a single serialization. The
+ * bench name is updated with the send system calls and the bytes serialized
+ * per relayed block.
+ */
+static void RelayBlock(benchmark::Bench &bench, bool shared) {
+    const BasicTestingSetup test_setup{
+        CBaseChainParams::MAIN,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+    const Config &config = GetConfig();
+
+    CBlock block;
+    CDataStream stream(benchmark::data::block413567, SER_NETWORK,
+                       PROTOCOL_VERSION);
+    stream >> block;
+
+    AddrMan addrman(/*asmap=*/{}, /*consistency_check_ratio=*/0);
+    ConnmanTestMsg connman(config, 0x1337, 0x1337, addrman);
+
+    std::vector<std::unique_ptr<CNode>> nodes;
+    std::vector<int> receivers;
+    for (size_t i = 0; i < NUM_PEERS; i++) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            assert(!"socketpair failed");
+        }
+        nodes.push_back(std::make_unique<CNode>(
+            i, NODE_NETWORK, fds[0], CAddress(), /*nKeyedNetGroupIn=*/0,
+            /*nLocalHostNonceIn=*/0, /*nLocalExtraEntropyIn=*/0, CAddress(),
+            /*pszDest=*/"", ConnectionType::INBOUND,
+            /*inbound_onion=*/false));
+        receivers.push_back(fds[1]);
+    }
+
+    const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    uint64_t serialized_bytes = 0;
+    std::array<uint8_t, 1 << 16> buffer;
+    const auto relay = [&] {
+        std::shared_ptr<const SharedNetPayload> payload;
+        if (shared) {
+            payload = std::make_shared<const SharedNetPayload>(
+                msgMaker.Make(NetMsgType::BLOCK, block).data);
+            serialized_bytes += payload->data.size();
+        }
+        for (const auto &node : nodes) {
+            CSerializedNetMsg msg =
+                shared ? CSerializedNetMsg(NetMsgType::BLOCK, payload)
+                       : msgMaker.Make(NetMsgType::BLOCK, block);
+            serialized_bytes += msg.data.size();
+            connman.PushMessage(node.get(), std::move(msg));
+        }
+
+        // Drain the receiving ends until everything is sent.
+        bool pending = true;
+        while (pending) {
+            pending = false;
+            for (size_t i = 0; i < NUM_PEERS; i++) {
+                while (recv(receivers[i], buffer.data(), buffer.size(),
+                            MSG_DONTWAIT) > 0) {
+                }
+                LOCK(nodes[i]->cs_vSend);
+                connman.SocketSendData(*nodes[i]);
+                pending |= !nodes[i]->vSendMsg.empty();
+            }
+        }
+    };
+
+    relay();
+    uint64_t send_calls = 0;
+    for (const auto &node : nodes) {
+        send_calls += WITH_LOCK(node->cs_vSend, return node->nSendCalls);
+    }
+    bench.name(strprintf("RelayBlock%s (%u send calls, %u bytes serialized)",
+                         shared ? "Shared" : "Copied", send_calls,
+                         serialized_bytes));
+
+    bench.unit("block").run(relay);
+
+    for (const int fd : receivers) {
+        close(fd);
+    }
+}
+
+static void RelayBlockCopied(benchmark::Bench &bench) {
+    RelayBlock(bench, /*shared=*/false);
+}
+
+static void RelayBlockShared(benchmark::Bench &bench) {
+    RelayBlock(bench, /*shared=*/true);
+}
+
+BENCHMARK(RelayBlockCopied);
+BENCHMARK(RelayBlockShared);
+
+#endif // WIN32
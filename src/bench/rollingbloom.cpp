@@ -4,9 +4,12 @@
 
 #include <bench/bench.h>
 #include <bloom.h>
+#include <crypto/common.h>
+#include <uint256.h>
 
-static void RollingBloom(benchmark::Bench &bench) {
-    CRollingBloomFilter filter(120000, 0.000001);
+template <typename Filter>
+static void RollingBloomBench(benchmark::Bench &bench) {
+    Filter filter(120000, 0.000001);
     std::vector<uint8_t> data(32);
     uint32_t count = 0;
     bench.run([&] {
@@ -25,10 +28,50 @@ static void RollingBloom(benchmark::Bench &bench) {
     });
 }
 
-static void RollingBloomReset(benchmark::Bench &bench) {
-    CRollingBloomFilter filter(120000, 0.000001);
+/** Same as RollingBloom, keyed by hashes as for transactions. */
+template <typename Filter>
+static void RollingBloomHashBench(benchmark::Bench &bench) {
+    Filter filter(120000, 0.000001);
+    uint256 hash;
+    uint32_t count = 0;
+    bench.run([&] {
+        count++;
+        WriteLE32(hash.begin(), count);
+        filter.insert(hash);
+
+        WriteBE32(hash.begin(), count);
+        filter.contains(hash);
+    });
+}
+
+template <typename Filter>
+static void RollingBloomResetBench(benchmark::Bench &bench) {
+    Filter filter(120000, 0.000001);
     bench.run([&] { filter.reset(); });
 }
 
+static void RollingBloom(benchmark::Bench &bench) {
+    RollingBloomBench<CRollingBloomFilter>(bench);
+}
+static void RollingBloomHash(benchmark::Bench &bench) {
+    RollingBloomHashBench<CRollingBloomFilter>(bench);
+}
+static void RollingBloomReset(benchmark::Bench &bench) {
+    RollingBloomResetBench<CRollingBloomFilter>(bench);
+}
+static void BlockedRollingBloom(benchmark::Bench &bench) {
+    RollingBloomBench<CBlockedRollingBloomFilter>(bench);
+}
+static void BlockedRollingBloomHash(benchmark::Bench &bench) {
+    RollingBloomHashBench<CBlockedRollingBloomFilter>(bench);
+}
+static void BlockedRollingBloomReset(benchmark::Bench &bench) {
+    RollingBloomResetBench<CBlockedRollingBloomFilter>(bench);
+}
+
 BENCHMARK(RollingBloom);
+BENCHMARK(RollingBloomHash);
 BENCHMARK(RollingBloomReset);
+BENCHMARK(BlockedRollingBloom);
+BENCHMARK(BlockedRollingBloomHash);
+BENCHMARK(BlockedRollingBloomReset);
@@ -0,0 +1,120 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <addrman.h>
+#include <config.h>
+#include <consensus/amount.h>
+#include <hash.h>
+#include <net.h>
+#include <net_processing.h>
+#include <primitives/transaction.h>
+#include <protocol.h>
+#include <script/script.h>
+#include <test/util/net.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <version.h>
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+//! Number of peers the transactions are announced to
+static constexpr size_t NUM_PEERS = 125;
+//! Number of transactions relayed per second
+static constexpr size_t TX_PER_SECOND = 1000;
+static constexpr size_t NUM_ITERATIONS = 10;
+
+/**
+ * Relay a second worth of transactions, then run SendMessages() once for each
+ * peer so that they are all announced.
+ */
+static void AnnounceTransactions(benchmark::Bench &bench) {
+    const TestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+    const Config &config = GetConfig();
+    CTxMemPool &mempool = *test_setup.m_node.mempool;
+
+    AddrMan addrman(/*asmap=*/{}, /*consistency_check_ratio=*/0);
+    ConnmanTestMsg connman(config, 0x1337, 0x1337, addrman);
+    connman.SetPeerConnectTimeout(99999s);
+    const std::unique_ptr<PeerManager> peerman =
+        PeerManager::make(config.GetChainParams(), connman, addrman,
+                          /*banman=*/nullptr, *test_setup.m_node.chainman,
+                          mempool, /*ignore_incoming_txs=*/false);
+
+    std::vector<CNode *> nodes;
+    for (size_t i = 0; i < NUM_PEERS; i++) {
+        CNode *node = new CNode(
+            i, NODE_NETWORK, INVALID_SOCKET, CAddress(), /*nKeyedNetGroupIn=*/0,
+            /*nLocalHostNonceIn=*/0, /*nLocalExtraEntropyIn=*/0, CAddress(),
+            /*pszDest=*/"", ConnectionType::OUTBOUND_FULL_RELAY,
+            /*inbound_onion=*/false);
+        node->SetCommonVersion(PROTOCOL_VERSION);
+        peerman->InitializeNode(config, node);
+        node->fSuccessfullyConnected = true;
+        WITH_LOCK(node->m_tx_relay->cs_filter,
+                  node->m_tx_relay->fRelayTxes = true);
+        connman.AddTestNode(*node);
+        nodes.push_back(node);
+    }
+
+    // Get the initial messages out of the way.
+    const auto send_messages = [&] {
+        for (CNode *node : nodes) {
+            LOCK(node->cs_sendProcessing);
+            peerman->SendMessages(config, node);
+
+            LOCK(node->cs_vSend);
+            node->vSendMsg.clear();
+            node->nSendSize = 0;
+        }
+    };
+    send_messages();
+
+    // Each iteration relays new transactions, which the peers don't know yet.
+    std::vector<CTransactionRef> txs;
+    for (size_t i = 0; i < (NUM_ITERATIONS + 1) * TX_PER_SECOND; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(TxId(SerializeHash(i)), 0);
+        tx.vin[0].scriptSig = CScript() << OP_1;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        tx.vout[0].nValue = 10 * COIN;
+        txs.push_back(MakeTransactionRef(std::move(tx)));
+    }
+
+    TestMemPoolEntryHelper entry;
+    size_t next_tx = 0;
+    bench.epochs(NUM_ITERATIONS).epochIterations(1).run([&] {
+        assert(next_tx + TX_PER_SECOND <= txs.size());
+        for (size_t i = 0; i < TX_PER_SECOND; i++, next_tx++) {
+            {
+                // Give the transactions a mix of fee rates
+                LOCK2(cs_main, mempool.cs);
+                mempool.addUnchecked(
+                    entry.Fee(int64_t(1000 + next_tx % 997) * SATOSHI)
+                        .FromTx(txs[next_tx]));
+            }
+            peerman->RelayTransaction(txs[next_tx]->GetId());
+        }
+        send_messages();
+    });
+
+    for (CNode *node : nodes) {
+        peerman->FinalizeNode(config, *node);
+    }
+    connman.ClearTestNodes();
+}
+
+BENCHMARK(AnnounceTransactions);
@@ -7,9 +7,11 @@
 #if defined(HAVE_CONSENSUS_LIB)
 #include <script/bitcoinconsensus.h>
 #endif
+#include <policy/policy.h>
 #include <script/interpreter.h>
 #include <script/script.h>
 #include <script/script_error.h>
+#include <script/sighashtype.h>
 #include <script/standard.h>
 #include <streams.h>
 #include <test/util/transaction_utils.h>
@@ -39,3 +41,43 @@ static void VerifyNestedIfScript(benchmark::Bench &bench) {
 }
 
 BENCHMARK(VerifyNestedIfScript);
+
+// Cost of verifying a single standard pay-to-pubkey-hash input, including the
+// signature check.
+static void VerifyScriptP2PKH(benchmark::Bench &bench) {
+    const ECCVerifyHandle verify_handle;
+    ECC_Start();
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    const CScript scriptPubKey = GetScriptForDestination(PKHash(pubkey));
+    const Amount amount = 1 * COIN;
+
+    const CMutableTransaction txCredit =
+        BuildCreditingTransaction(scriptPubKey, amount);
+    CMutableTransaction txSpend =
+        BuildSpendingTransaction(CScript(), CTransaction(txCredit));
+
+    const SigHashType sigHashType = SigHashType().withForkId();
+    const uint256 sighash =
+        SignatureHash(scriptPubKey, txSpend, 0, sigHashType, amount);
+    std::vector<uint8_t> sig;
+    bool signed_ok = key.SignECDSA(sighash, sig);
+    assert(signed_ok);
+    sig.push_back(uint8_t(sigHashType.getRawSigHashType()));
+    txSpend.vin[0].scriptSig << sig << ToByteVector(pubkey);
+
+    const MutableTransactionSignatureChecker checker(&txSpend, 0, amount);
+    bench.run([&] {
+        ScriptExecutionMetrics metrics = {};
+        ScriptError error;
+        bool ret = VerifyScript(txSpend.vin[0].scriptSig, scriptPubKey,
+                                STANDARD_SCRIPT_VERIFY_FLAGS, checker, metrics,
+                                &error);
+        assert(ret);
+    });
+    ECC_Stop();
+}
+
+BENCHMARK(VerifyScriptP2PKH);
@@ -25,10 +25,12 @@ CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock &block)
     // TODO: Use our mempool prior to block acceptance to predictively fill more
     // than just the coinbase.
     prefilledtxn[0] = {0, block.vtx[0]};
+    std::vector<uint256> txhashes;
+    txhashes.reserve(shorttxids.size());
     for (size_t i = 1; i < block.vtx.size(); i++) {
-        const CTransaction &tx = *block.vtx[i];
-        shorttxids[i - 1] = GetShortID(tx.GetHash());
+        txhashes.push_back(block.vtx[i]->GetHash());
     }
+    GetShortIDs(txhashes.data(), txhashes.size(), shorttxids.data());
 }
 
 void CBlockHeaderAndShortTxIDs::FillShortTxIDSelector() const {
@@ -48,6 +50,17 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const TxHash &txhash) const {
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
 }
 
+void CBlockHeaderAndShortTxIDs::GetShortIDs(const uint256 *txhashes,
+                                            size_t count,
+                                            uint64_t *shortids) const {
+    static_assert(SHORTTXIDS_LENGTH == 6,
+                  "shorttxids calculation assumes 6-byte shorttxids");
+    SipHashUint256Multi(shorttxidk0, shorttxidk1, txhashes, count, shortids);
+    for (size_t i = 0; i < count; i++) {
+        shortids[i] &= 0xffffffffffffL;
+    }
+}
+
 ReadStatus PartiallyDownloadedBlock::InitData(
     const CBlockHeaderAndShortTxIDs &cmpctblock,
     const std::vector<std::pair<TxHash, CTransactionRef>> &extra_txns) {
@@ -96,16 +109,39 @@ ReadStatus PartiallyDownloadedBlock::InitData(
         return READ_STATUS_FAILED;
     }
 
+    // Only hold the mempool lock long enough to snapshot the tx hashes, the
+    // shortids are computed in batch without it. The few candidates that
+    // match are then looked up again, skipping the ones that were removed in
+    // the meantime.
+    std::vector<uint256> txhashes;
     {
         LOCK(pool->cs);
-        auto it = pool->mapTx.begin();
-        while (it != pool->mapTx.end()) {
-            uint64_t shortid = cmpctblock.GetShortID(it->GetTx().GetHash());
+        txhashes.reserve(pool->vTxHashes.size());
+        for (const auto &txhash : pool->vTxHashes) {
+            txhashes.push_back(txhash.first);
+        }
+    }
 
-            mempool_count +=
-                shortidProcessor->matchKnownItem(shortid, it->GetSharedTx());
-            it++;
+    std::vector<uint64_t> shortids(txhashes.size());
+    cmpctblock.GetShortIDs(txhashes.data(), txhashes.size(), shortids.data());
+
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < shortids.size(); i++) {
+        if (shortidProcessor->hasShortId(shortids[i])) {
+            candidates.push_back(i);
+        }
+    }
+
+    if (!candidates.empty()) {
+        LOCK(pool->cs);
+        for (const size_t i : candidates) {
+            // The txid and the hash of a transaction are the same.
+            CTransactionRef tx = pool->get(TxId(txhashes[i]));
+            if (!tx) {
+                continue;
+            }
 
+            mempool_count += shortidProcessor->matchKnownItem(shortids[i], tx);
             if (mempool_count == shortidProcessor->getShortIdCount()) {
                 break;
             }
@@ -85,6 +85,7 @@ private:
     void FillShortTxIDSelector() const;
 
     friend class PartiallyDownloadedBlock;
+    friend class CBlockHeaderAndReconciliation;
 
 protected:
     std::vector<uint64_t> shorttxids;
@@ -102,6 +103,13 @@ public:
 
     uint64_t GetShortID(const TxHash &txhash) const;
 
+    /**
+     * Compute the shortids of count tx hashes at once, which is several times
+     * faster than calling GetShortID() in a loop on CPUs with vector units.
+     */
+    void GetShortIDs(const uint256 *txhashes, size_t count,
+                     uint64_t *shortids) const;
+
     size_t BlockTxCount() const {
         return shorttxids.size() + prefilledtxn.size();
     }
@@ -138,19 +146,19 @@ public:
     }
 };
 
-class PartiallyDownloadedBlock {
-    struct CTransactionRefCompare {
-        bool operator()(const CTransactionRef &lhs,
-                        const CTransactionRef &rhs) const {
-            return lhs->GetHash() == rhs->GetHash();
-        }
-    };
+struct CTransactionRefCompare {
+    bool operator()(const CTransactionRef &lhs,
+                    const CTransactionRef &rhs) const {
+        return lhs->GetHash() == rhs->GetHash();
+    }
+};
 
-    using TransactionShortIdProcessor =
-        ShortIdProcessor<PrefilledTransaction,
-                         ShortIdProcessorPrefilledTransactionAdapter,
-                         CTransactionRefCompare>;
+using TransactionShortIdProcessor =
+    ShortIdProcessor<PrefilledTransaction,
+                     ShortIdProcessorPrefilledTransactionAdapter,
+                     CTransactionRefCompare>;
 
+class PartiallyDownloadedBlock {
     // FIXME This better fits a unique_ptr, but the unit tests needs a copy
     // operator for this class. It can be trivially changed when the unit tests
     // are refactored.
@@ -4,6 +4,8 @@
 
 #include <blockindex.h>
 
+#include <memusage.h>
+
 /**
  * Turn the lowest '1' bit in the binary representation of a number into a '0'.
  */
@@ -78,3 +80,27 @@ void CBlockIndex::BuildSkip() {
         pskip = pprev->GetAncestor(GetSkipHeight(nHeight));
     }
 }
+
+CBlockIndex *BlockIndexArena::Allocate() {
+    Reserve(m_size + 1);
+    CBlockIndex *entry = &m_chunks[m_size / CHUNK_SIZE][m_size % CHUNK_SIZE];
+    m_size++;
+    return entry;
+}
+
+void BlockIndexArena::Reserve(size_t n) {
+    while (m_chunks.size() * CHUNK_SIZE < n) {
+        m_chunks.emplace_back(new CBlockIndex[CHUNK_SIZE]);
+    }
+}
+
+void BlockIndexArena::Clear() {
+    m_chunks.clear();
+    m_size = 0;
+}
+
+size_t BlockIndexArena::DynamicMemoryUsage() const {
+    return memusage::DynamicUsage(m_chunks) +
+           m_chunks.size() *
+               memusage::MallocUsage(CHUNK_SIZE * sizeof(CBlockIndex));
+}
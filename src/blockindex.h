@@ -12,6 +12,9 @@
 #include <tinyformat.h>
 #include <uint256.h>
 
+#include <memory>
+#include <vector>
+
 struct BlockHash;
 
 /**
@@ -74,6 +77,10 @@ public:
     //! @sa ActivateSnapshot
     unsigned int nChainTx{0};
 
+    //! (memory only) Maximum nTime in the chain up to and including this block.
+    //! Kept next to nChainTx so that it fills what would otherwise be padding.
+    unsigned int nTimeMax{0};
+
 private:
     //! (memory only) Size of all blocks in the chain up to and including this
     //! block. This value will be non-zero only if and only if transactions for
@@ -98,9 +105,6 @@ public:
     //! (memory only) block header metadata
     uint64_t nTimeReceived{0};
 
-    //! (memory only) Maximum nTime in the chain up to and including this block.
-    unsigned int nTimeMax{0};
-
     explicit CBlockIndex() = default;
 
     explicit CBlockIndex(const CBlockHeader &block)
@@ -239,4 +243,34 @@ public:
     const CBlockIndex *GetAncestor(int height) const;
 };
 
+/**
+ * Owns the block index entries. Entries are carved out of large contiguous
+ * chunks instead of being allocated one by one, which removes the per-entry
+ * allocator overhead and keeps entries loaded together close in memory.
+ * Entries have a stable address for the lifetime of the arena and are only
+ * released all at once by Clear().
+ */
+class BlockIndexArena {
+public:
+    //! Number of entries per chunk (about 640KiB of entries).
+    static constexpr size_t CHUNK_SIZE = 4096;
+
+    //! Return a default constructed entry.
+    CBlockIndex *Allocate();
+
+    //! Preallocate enough chunks to hold n entries in total.
+    void Reserve(size_t n);
+
+    //! Destroy all the entries.
+    void Clear();
+
+    size_t size() const { return m_size; }
+
+    size_t DynamicMemoryUsage() const;
+
+private:
+    std::vector<std::unique_ptr<CBlockIndex[]>> m_chunks;
+    size_t m_size{0};
+};
+
 #endif // BITCOIN_BLOCKINDEX_H
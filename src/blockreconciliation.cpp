@@ -0,0 +1,375 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockreconciliation.h>
+
+#include <chainparams.h>
+#include <config.h>
+#include <consensus/consensus.h>
+#include <consensus/validation.h>
+#include <logging.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <cmath>
+
+//! Serialized size of a ShortIdIBLT::Cell
+static constexpr size_t IBLT_CELL_SIZE = 12;
+
+static constexpr uint64_t SHORTID_MASK = 0xffffffffffffULL;
+
+static constexpr double LN2 = 0.6931471805599453094;
+
+/**
+ * The shortids are already uniformly distributed, but they are remixed so the
+ * bloom filter and the IBLT subtables use independent bits.
+ */
+static uint64_t Mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+//! Map x uniformly into [0, n)
+static uint32_t MapIntoRange(uint32_t x, uint32_t n) {
+    return (uint64_t(x) * uint64_t(n)) >> 32;
+}
+
+ShortIdBloomFilter::ShortIdBloomFilter(size_t nElements, double fpRate) {
+    const double nBits = std::min<double>(
+        std::ceil(-double(nElements) * std::log(fpRate) / (LN2 * LN2)),
+        std::numeric_limits<uint32_t>::max());
+    vData.resize(std::max<size_t>(1, (size_t(nBits) + 7) / 8));
+    nHashFuncs = std::clamp<int>(
+        std::lround(vData.size() * 8 * LN2 / std::max<size_t>(1, nElements)),
+        1, MAX_HASH_FUNCS);
+}
+
+void ShortIdBloomFilter::insert(uint64_t shortid) {
+    if (vData.empty()) {
+        return;
+    }
+
+    const uint64_t h = Mix(shortid);
+    const uint32_t nBits = std::min<uint64_t>(
+        vData.size() * 8, std::numeric_limits<uint32_t>::max());
+    for (uint32_t i = 0, p = h, d = (h >> 32) | 1; i < nHashFuncs;
+         i++, p += d) {
+        const uint32_t nIndex = MapIntoRange(p, nBits);
+        vData[nIndex >> 3] |= (1 << (7 & nIndex));
+    }
+}
+
+bool ShortIdBloomFilter::contains(uint64_t shortid) const {
+    if (vData.empty()) {
+        return true;
+    }
+
+    const uint64_t h = Mix(shortid);
+    const uint32_t nBits = std::min<uint64_t>(
+        vData.size() * 8, std::numeric_limits<uint32_t>::max());
+    for (uint32_t i = 0, p = h, d = (h >> 32) | 1; i < nHashFuncs;
+         i++, p += d) {
+        const uint32_t nIndex = MapIntoRange(p, nBits);
+        if (!(vData[nIndex >> 3] & (1 << (7 & nIndex)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t GetCheckSum(uint64_t shortid) {
+    return Mix(shortid ^ 0x5bd1e9955bd1e995ULL);
+}
+
+static size_t GetCellIndex(uint64_t shortid, size_t i, size_t subtable_size) {
+    const uint64_t h = Mix(shortid + (i + 1) * 0x9e3779b97f4a7c15ULL);
+    return i * subtable_size + MapIntoRange(h >> 32, subtable_size);
+}
+
+ShortIdIBLT::ShortIdIBLT(size_t expected_diff)
+    : cells(CellCount(expected_diff)) {}
+
+size_t ShortIdIBLT::CellCount(size_t expected_diff) {
+    // Leave room for the variance of the difference and for a few transactions
+    // that may be missing from the receiver's mempool. Tables with 3 hashes
+    // decode large differences with about 1.23 cells per entry, use a wider
+    // margin since most tables are small.
+    const double diff =
+        expected_diff + 3 * std::sqrt(double(expected_diff)) + 8;
+    const size_t count = std::ceil(1.5 * diff);
+    return (count + NUM_HASHES - 1) / NUM_HASHES * NUM_HASHES;
+}
+
+void ShortIdIBLT::update(uint64_t shortid, int direction) {
+    const size_t subtable_size = cells.size() / NUM_HASHES;
+    if (subtable_size == 0) {
+        return;
+    }
+
+    const uint32_t checkSum = GetCheckSum(shortid);
+    for (size_t i = 0; i < NUM_HASHES; i++) {
+        Cell &cell = cells[GetCellIndex(shortid, i, subtable_size)];
+        cell.count += direction;
+        cell.keySum ^= shortid;
+        cell.checkSum ^= checkSum;
+    }
+}
+
+bool ShortIdIBLT::IsPure(const Cell &cell) const {
+    return (cell.count == 1 || cell.count == uint16_t(-1)) &&
+           (cell.keySum & ~SHORTID_MASK) == 0 &&
+           cell.checkSum == GetCheckSum(cell.keySum);
+}
+
+bool ShortIdIBLT::Subtract(const ShortIdIBLT &other) {
+    if (cells.size() != other.cells.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < cells.size(); i++) {
+        cells[i].count -= other.cells[i].count;
+        cells[i].keySum ^= other.cells[i].keySum;
+        cells[i].checkSum ^= other.cells[i].checkSum;
+    }
+    return true;
+}
+
+bool ShortIdIBLT::ListEntries(std::vector<uint64_t> &positive,
+                              std::vector<uint64_t> &negative) const {
+    ShortIdIBLT peeled = *this;
+    const size_t subtable_size = cells.size() / NUM_HASHES;
+
+    std::vector<size_t> pure;
+    for (size_t i = 0; i < cells.size(); i++) {
+        if (IsPure(cells[i])) {
+            pure.push_back(i);
+        }
+    }
+
+    size_t listed = 0;
+    while (!pure.empty()) {
+        const Cell cell = peeled.cells[pure.back()];
+        pure.pop_back();
+        if (!IsPure(cell)) {
+            // Already peeled through another cell.
+            continue;
+        }
+
+        // A bogus table could make us peel forever, but a valid one cannot
+        // hold more entries than it has cells.
+        if (++listed > cells.size()) {
+            return false;
+        }
+
+        const uint64_t shortid = cell.keySum;
+        const bool isPositive = cell.count == 1;
+        (isPositive ? positive : negative).push_back(shortid);
+        peeled.update(shortid, isPositive ? -1 : 1);
+
+        for (size_t i = 0; i < NUM_HASHES; i++) {
+            const size_t index = GetCellIndex(shortid, i, subtable_size);
+            if (IsPure(peeled.cells[index])) {
+                pure.push_back(index);
+            }
+        }
+    }
+
+    return std::all_of(peeled.cells.begin(), peeled.cells.end(),
+                       [](const Cell &c) { return c.IsEmpty(); });
+}
+
+CBlockHeaderAndReconciliation::CBlockHeaderAndReconciliation(
+    const CBlockHeaderAndShortTxIDs &cmpctblockIn, uint64_t mempool_size)
+    : cmpctblock(cmpctblockIn), shortid_count(cmpctblockIn.shorttxids.size()) {
+    const std::vector<uint64_t> shortids = std::move(cmpctblock.shorttxids);
+    cmpctblock.shorttxids.clear();
+
+    // Assuming the receiver has the whole block in its mempool, each of its
+    // other transactions is a false positive with the filter's fpRate. Find
+    // the expected number of false positives that minimizes the size of the
+    // filter and the table together. Not sending a filter at all is the
+    // cheapest when there are only a few transactions in excess.
+    const double excess =
+        mempool_size > shortid_count ? mempool_size - shortid_count : 0;
+    double best_fp = excess;
+    double best_size = ShortIdIBLT::CellCount(excess) * IBLT_CELL_SIZE;
+    for (double fp = excess / 2; fp >= 0.01; fp /= 2) {
+        const double size =
+            shortid_count * std::log(excess / fp) / (LN2 * LN2 * 8) +
+            ShortIdIBLT::CellCount(size_t(std::ceil(fp))) * IBLT_CELL_SIZE;
+        if (size < best_size) {
+            best_size = size;
+            best_fp = fp;
+        }
+    }
+
+    if (best_fp < excess) {
+        filter = ShortIdBloomFilter(shortid_count, best_fp / excess);
+        for (const uint64_t shortid : shortids) {
+            filter.insert(shortid);
+        }
+    }
+
+    iblt = ShortIdIBLT(size_t(std::ceil(best_fp)));
+    for (const uint64_t shortid : shortids) {
+        iblt.insert(shortid);
+    }
+}
+
+ReadStatus CBlockHeaderAndReconciliation::FillBlock(
+    const Config &config, const CTxMemPool &pool,
+    const std::vector<std::pair<TxHash, CTransactionRef>> &extra_txn,
+    CBlock &block) const {
+    const CBlockHeader &header = cmpctblock.header;
+    if (header.IsNull() || BlockTxCount() == 0) {
+        return READ_STATUS_INVALID;
+    }
+    if (BlockTxCount() > config.GetMaxBlockSize() / MIN_TRANSACTION_SIZE) {
+        return READ_STATUS_INVALID;
+    }
+    for (const auto &prefilledtxn : cmpctblock.prefilledtxn) {
+        if (prefilledtxn.tx->IsNull()) {
+            return READ_STATUS_INVALID;
+        }
+    }
+
+    // Compute the shortids of the mempool and extra transactions, without
+    // holding the mempool lock, and keep the ones that match the filter.
+    std::vector<uint256> txhashes;
+    {
+        LOCK(pool.cs);
+        txhashes.reserve(pool.vTxHashes.size() + extra_txn.size());
+        for (const auto &txhash : pool.vTxHashes) {
+            txhashes.push_back(txhash.first);
+        }
+    }
+    const size_t mempool_count = txhashes.size();
+    for (const auto &extra : extra_txn) {
+        txhashes.push_back(extra.first);
+    }
+
+    std::vector<uint64_t> shortids(txhashes.size());
+    cmpctblock.GetShortIDs(txhashes.data(), txhashes.size(), shortids.data());
+
+    // (shortid, index in txhashes)
+    std::vector<std::pair<uint64_t, size_t>> candidates;
+    for (size_t i = 0; i < shortids.size(); i++) {
+        if (i >= mempool_count && !extra_txn[i - mempool_count].second) {
+            continue;
+        }
+        if (filter.contains(shortids[i])) {
+            candidates.emplace_back(shortids[i], i);
+        }
+    }
+
+    // The same transaction can be both in the mempool and the extra pool, but
+    // different transactions with the same shortid cannot be told apart.
+    std::sort(candidates.begin(), candidates.end());
+    size_t unique_count = 0;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (unique_count > 0 &&
+            candidates[unique_count - 1].first == candidates[i].first) {
+            if (txhashes[candidates[unique_count - 1].second] !=
+                txhashes[candidates[i].second]) {
+                return READ_STATUS_FAILED;
+            }
+            continue;
+        }
+        candidates[unique_count++] = candidates[i];
+    }
+    candidates.resize(unique_count);
+
+    ShortIdIBLT diff = iblt;
+    for (const auto &candidate : candidates) {
+        diff.erase(candidate.first);
+    }
+
+    std::vector<uint64_t> missing, false_positives;
+    if (!diff.ListEntries(missing, false_positives) || !missing.empty()) {
+        return READ_STATUS_FAILED;
+    }
+    std::sort(false_positives.begin(), false_positives.end());
+
+    // (tx, shortid)
+    std::vector<std::pair<CTransactionRef, uint64_t>> txs;
+    txs.reserve(shortid_count);
+    {
+        LOCK(pool.cs);
+        for (const auto &candidate : candidates) {
+            if (std::binary_search(false_positives.begin(),
+                                   false_positives.end(), candidate.first)) {
+                continue;
+            }
+
+            const size_t i = candidate.second;
+            // The txid and the hash of a transaction are the same.
+            CTransactionRef tx = i < mempool_count
+                                     ? pool.get(TxId(txhashes[i]))
+                                     : extra_txn[i - mempool_count].second;
+            if (!tx) {
+                // Removed from the mempool in the meantime.
+                return READ_STATUS_FAILED;
+            }
+            txs.emplace_back(std::move(tx), candidate.first);
+        }
+    }
+
+    if (txs.size() != shortid_count) {
+        return READ_STATUS_FAILED;
+    }
+
+    // Use the canonical transaction ordering to place the transactions around
+    // the prefilled ones.
+    std::sort(txs.begin(), txs.end(), [](const auto &a, const auto &b) {
+        return a.first->GetId() < b.first->GetId();
+    });
+    std::vector<uint64_t> ordered_shortids;
+    ordered_shortids.reserve(txs.size());
+    for (const auto &tx : txs) {
+        ordered_shortids.push_back(tx.second);
+    }
+
+    TransactionShortIdProcessor shortidProcessor(cmpctblock.prefilledtxn,
+                                                 ordered_shortids, 12);
+    if (!shortidProcessor.isEvenlyDistributed() ||
+        shortidProcessor.hasShortIdCollision() ||
+        shortidProcessor.hasOutOfBoundIndex()) {
+        return READ_STATUS_FAILED;
+    }
+    for (const auto &tx : txs) {
+        shortidProcessor.matchKnownItem(tx.second, tx.first);
+    }
+
+    block = header;
+    block.vtx.resize(BlockTxCount());
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        block.vtx[i] = shortidProcessor.getItem(i);
+        if (!block.vtx[i]) {
+            return READ_STATUS_FAILED;
+        }
+    }
+
+    BlockValidationState state;
+    if (!CheckBlock(block, state, config.GetChainParams().GetConsensus(),
+                    BlockValidationOptions(config))) {
+        if (state.GetResult() == BlockValidationResult::BLOCK_MUTATED) {
+            // Not a canonically ordered block, or a shortid collision.
+            return READ_STATUS_FAILED;
+        }
+        return READ_STATUS_CHECKBLOCK_FAILED;
+    }
+
+    LogPrint(BCLog::CMPCTBLOCK,
+             "Successfully reconciled block %s with %lu txn prefilled, %lu "
+             "candidates and %lu false positives\n",
+             header.GetHash().ToString(), cmpctblock.prefilledtxn.size(),
+             candidates.size(), false_positives.size());
+
+    return READ_STATUS_OK;
+}
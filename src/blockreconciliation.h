@@ -0,0 +1,196 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKRECONCILIATION_H
+#define BITCOIN_BLOCKRECONCILIATION_H
+
+#include <blockencodings.h>
+#include <primitives/block.h>
+#include <serialize.h>
+
+#include <cstdint>
+#include <ios>
+#include <limits>
+#include <utility>
+#include <vector>
+
+class Config;
+class CTxMemPool;
+
+/**
+ * Bloom filter over the 6-bytes shortids of a block. Unlike CBloomFilter, the
+ * elements are already salted random values so they are not hashed again, and
+ * the size is not capped so it can cover blocks of any size.
+ *
+ * An empty filter matches every shortid.
+ */
+class ShortIdBloomFilter {
+    std::vector<uint8_t> vData;
+    uint8_t nHashFuncs = 0;
+
+public:
+    static constexpr uint8_t MAX_HASH_FUNCS = 32;
+
+    ShortIdBloomFilter() {}
+
+    /**
+     * Create a filter sized for nElements with a false positive rate of
+     * fpRate, which must be in the (0, 1) range.
+     */
+    ShortIdBloomFilter(size_t nElements, double fpRate);
+
+    void insert(uint64_t shortid);
+    bool contains(uint64_t shortid) const;
+
+    bool IsEmpty() const { return vData.empty(); }
+
+    SERIALIZE_METHODS(ShortIdBloomFilter, obj) {
+        READWRITE(obj.vData, obj.nHashFuncs);
+
+        if (ser_action.ForRead() && obj.nHashFuncs > MAX_HASH_FUNCS) {
+            throw std::ios_base::failure("too many bloom hash functions");
+        }
+    }
+};
+
+/**
+ * Invertible Bloom lookup table over shortids. Subtracting the table of a
+ * candidate set from the table of the block leaves only the symmetric
+ * difference of the two sets, which can be listed as long as it is small
+ * enough compared to the table size, regardless of the size of the sets.
+ */
+class ShortIdIBLT {
+public:
+    //! Each shortid is added to one cell in each of the NUM_HASHES subtables
+    static constexpr size_t NUM_HASHES = 3;
+
+    struct Cell {
+        //! Counts can wrap around, only the +1/-1 values are meaningful
+        uint16_t count = 0;
+        uint64_t keySum = 0;
+        uint32_t checkSum = 0;
+
+        bool IsEmpty() const {
+            return count == 0 && keySum == 0 && checkSum == 0;
+        }
+
+        SERIALIZE_METHODS(Cell, obj) {
+            READWRITE(obj.count, Using<CustomUintFormatter<6>>(obj.keySum),
+                      obj.checkSum);
+        }
+    };
+
+private:
+    std::vector<Cell> cells;
+
+    void update(uint64_t shortid, int direction);
+    bool IsPure(const Cell &cell) const;
+
+public:
+    ShortIdIBLT() {}
+
+    //! Create a table that can list about expected_diff shortids
+    explicit ShortIdIBLT(size_t expected_diff);
+
+    //! Number of cells needed to list about expected_diff shortids
+    static size_t CellCount(size_t expected_diff);
+
+    size_t size() const { return cells.size(); }
+
+    void insert(uint64_t shortid) { update(shortid, 1); }
+    void erase(uint64_t shortid) { update(shortid, -1); }
+
+    /**
+     * Remove the content of other from this table. Returns false if the tables
+     * don't have the same size.
+     */
+    bool Subtract(const ShortIdIBLT &other);
+
+    /**
+     * List the shortids that were inserted (positive) or removed (negative)
+     * more times than the other. Returns false if the table cannot be fully
+     * decoded.
+     */
+    bool ListEntries(std::vector<uint64_t> &positive,
+                     std::vector<uint64_t> &negative) const;
+
+    SERIALIZE_METHODS(ShortIdIBLT, obj) {
+        READWRITE(obj.cells);
+
+        if (ser_action.ForRead() && obj.cells.size() % NUM_HASHES != 0) {
+            throw std::ios_base::failure("invalid iblt size");
+        }
+    }
+};
+
+class BlockReconciliationRequest {
+public:
+    // A BlockReconciliationRequest message
+    BlockHash blockhash;
+    //! Number of transactions in the requester's mempool
+    uint64_t mempool_size = 0;
+
+    SERIALIZE_METHODS(BlockReconciliationRequest, obj) {
+        READWRITE(obj.blockhash, obj.mempool_size);
+    }
+};
+
+/**
+ * A block encoded for set reconciliation against the receiver's mempool.
+ *
+ * The receiver runs its mempool through the bloom filter of the block shortids
+ * to get a candidate set, then uses the IBLT to find out about the false
+ * positives. This only works on a chain with the canonical transaction
+ * ordering, where the transaction order can be recovered from the txids.
+ */
+class CBlockHeaderAndReconciliation {
+    //! Header, shortid salt and prefilled transactions, without shortids
+    CBlockHeaderAndShortTxIDs cmpctblock;
+    //! Number of transactions that are not prefilled
+    uint64_t shortid_count = 0;
+    ShortIdBloomFilter filter;
+    ShortIdIBLT iblt;
+
+public:
+    // Dummy for deserialization
+    CBlockHeaderAndReconciliation() {}
+
+    /**
+     * Encode a block for a peer which has mempool_size transactions in its
+     * mempool. The filter and the table are sized so that the expected
+     * message size is minimal if that mempool contains the whole block.
+     */
+    CBlockHeaderAndReconciliation(const CBlockHeaderAndShortTxIDs &cmpctblockIn,
+                                  uint64_t mempool_size);
+
+    const CBlockHeader &GetHeader() const { return cmpctblock.header; }
+
+    size_t BlockTxCount() const {
+        return cmpctblock.prefilledtxn.size() + shortid_count;
+    }
+
+    /**
+     * Rebuild the block from the mempool and the extra transactions.
+     *
+     * Returns READ_STATUS_FAILED if the block cannot be reconciled, e.g. when
+     * the receiver is missing some transactions, in which case the block
+     * should be requested through compact block relay instead.
+     */
+    ReadStatus
+    FillBlock(const Config &config, const CTxMemPool &pool,
+              const std::vector<std::pair<TxHash, CTransactionRef>> &extra_txn,
+              CBlock &block) const;
+
+    SERIALIZE_METHODS(CBlockHeaderAndReconciliation, obj) {
+        READWRITE(obj.cmpctblock, COMPACTSIZE(obj.shortid_count), obj.filter,
+                  obj.iblt);
+
+        if (ser_action.ForRead() &&
+            obj.BlockTxCount() > std::numeric_limits<uint32_t>::max()) {
+            throw std::ios_base::failure("indexes overflowed 32 bits");
+        }
+    }
+};
+
+#endif // BITCOIN_BLOCKRECONCILIATION_H
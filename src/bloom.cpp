@@ -4,6 +4,7 @@
 
 #include <bloom.h>
 
+#include <crypto/siphash.h>
 #include <hash.h>
 #include <primitives/transaction.h>
 #include <random.h>
@@ -297,3 +298,146 @@ void CRollingBloomFilter::reset() {
     nGeneration = 1;
     std::fill(data.begin(), data.end(), 0);
 }
+
+/**
+ * The false-positive rate of a blocked bloom filter with hash_funcs bits per
+ * element, when the blocks hold elements_per_block elements on average. The
+ * number of elements in a block follows a Poisson distribution.
+ */
+static double BlockedFalsePositiveRate(double elements_per_block,
+                                       int hash_funcs, uint32_t block_bits) {
+    const int max_elements =
+        int(elements_per_block + 12 * sqrt(elements_per_block)) + 20;
+    double probability = exp(-elements_per_block);
+    double fpRate = 0;
+    for (int n = 0; n <= max_elements; n++) {
+        if (n > 0) {
+            probability *= elements_per_block / n;
+        }
+        const double bit_set =
+            1.0 - pow(1.0 - 1.0 / block_bits, double(n) * hash_funcs);
+        fpRate += probability * pow(bit_set, hash_funcs);
+    }
+    return fpRate;
+}
+
+CBlockedRollingBloomFilter::CBlockedRollingBloomFilter(const uint32_t nElements,
+                                                       const double fpRate) {
+    double logFpRate = log(fpRate);
+    nHashFuncs = std::max(1, std::min<int>(round(logFpRate / log(0.5)), 50));
+    nEntriesPerGeneration = (nElements + 1) / 2;
+    uint32_t nMaxElements = nEntriesPerGeneration * 3;
+    /* Start from the size of the equivalent CRollingBloomFilter, and grow it
+     * until the blocked layout meets the false-positive rate when the filter
+     * is as full as it gets. */
+    uint32_t nFilterBits =
+        uint32_t(ceil(-1.0 * nHashFuncs * nMaxElements /
+                      log(1.0 - exp(logFpRate / nHashFuncs))));
+    size_t nBlocks = (nFilterBits + BLOCK_BITS - 1) / BLOCK_BITS;
+    while (BlockedFalsePositiveRate(double(nMaxElements) / nBlocks,
+                                    nHashFuncs, BLOCK_BITS) > fpRate) {
+        nBlocks += std::max<size_t>(1, nBlocks / 32);
+    }
+    data.clear();
+    data.resize(nBlocks);
+    reset();
+}
+
+/**
+ * SplitMix64, used to expand the element hash into the positions of its bits
+ * within the block.
+ */
+static inline uint64_t SplitMix64(uint64_t &state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+CBlockedRollingBloomFilter::BlockMask
+CBlockedRollingBloomFilter::GetBlockMask(uint64_t hash) const {
+    static_assert(BLOCK_BITS == 256, "A position is taken from 8 hash bits");
+    BlockMask mask{};
+    uint64_t state = hash;
+    uint64_t bits = 0;
+    for (int n = 0; n < nHashFuncs; n++) {
+        if (n % 8 == 0) {
+            bits = SplitMix64(state);
+        }
+        const uint32_t pos = bits & 0xFF;
+        bits >>= 8;
+        mask[pos >> 6] |= uint64_t(1) << (pos & 63);
+    }
+    return mask;
+}
+
+void CBlockedRollingBloomFilter::InsertHash(uint64_t hash) {
+    if (nEntriesThisGeneration == nEntriesPerGeneration) {
+        nEntriesThisGeneration = 0;
+        nGeneration++;
+        if (nGeneration == 4) {
+            nGeneration = 1;
+        }
+        uint64_t nGenerationMask1 = 0 - uint64_t(nGeneration & 1);
+        uint64_t nGenerationMask2 = 0 - uint64_t(nGeneration >> 1);
+        /* Wipe old entries that used this generation number. */
+        for (Block &block : data) {
+            for (size_t i = 0; i < BLOCK_WORDS; i++) {
+                uint64_t mask = (block.gen1[i] ^ nGenerationMask1) |
+                                (block.gen2[i] ^ nGenerationMask2);
+                block.gen1[i] &= mask;
+                block.gen2[i] &= mask;
+            }
+        }
+    }
+    nEntriesThisGeneration++;
+
+    const BlockMask mask = GetBlockMask(hash);
+    /* As in FastMod, the upper bits of the hash select the block. The bit
+     * positions are derived from the whole hash through SplitMix64. */
+    Block &block = data[((hash >> 32) * data.size()) >> 32];
+    const uint64_t gen1 = 0 - uint64_t(nGeneration & 1);
+    const uint64_t gen2 = 0 - uint64_t(nGeneration >> 1);
+    for (size_t i = 0; i < BLOCK_WORDS; i++) {
+        block.gen1[i] = (block.gen1[i] & ~mask[i]) | (gen1 & mask[i]);
+        block.gen2[i] = (block.gen2[i] & ~mask[i]) | (gen2 & mask[i]);
+    }
+}
+
+bool CBlockedRollingBloomFilter::ContainsHash(uint64_t hash) const {
+    const BlockMask mask = GetBlockMask(hash);
+    const Block &block = data[((hash >> 32) * data.size()) >> 32];
+    /* The element is contained if none of its bits is unset in both planes */
+    uint64_t missing = 0;
+    for (size_t i = 0; i < BLOCK_WORDS; i++) {
+        missing |= mask[i] & ~(block.gen1[i] | block.gen2[i]);
+    }
+    return missing == 0;
+}
+
+void CBlockedRollingBloomFilter::insert(const std::vector<uint8_t> &vKey) {
+    InsertHash(
+        CSipHasher(m_k0, m_k1).Write(vKey.data(), vKey.size()).Finalize());
+}
+
+void CBlockedRollingBloomFilter::insert(const uint256 &hash) {
+    InsertHash(SipHashUint256(m_k0, m_k1, hash));
+}
+
+bool CBlockedRollingBloomFilter::contains(
+    const std::vector<uint8_t> &vKey) const {
+    return ContainsHash(
+        CSipHasher(m_k0, m_k1).Write(vKey.data(), vKey.size()).Finalize());
+}
+
+bool CBlockedRollingBloomFilter::contains(const uint256 &hash) const {
+    return ContainsHash(SipHashUint256(m_k0, m_k1, hash));
+}
+
+void CBlockedRollingBloomFilter::reset() {
+    m_k0 = GetRand(std::numeric_limits<uint64_t>::max());
+    m_k1 = GetRand(std::numeric_limits<uint64_t>::max());
+    nEntriesThisGeneration = 0;
+    nGeneration = 1;
+    std::fill(data.begin(), data.end(), Block{});
+}
@@ -7,6 +7,7 @@
 
 #include <serialize.h>
 
+#include <array>
 #include <cstdint>
 #include <vector>
 
@@ -136,4 +137,58 @@ private:
     int nHashFuncs;
 };
 
+/**
+ * A rolling bloom filter with the same semantics as CRollingBloomFilter, in
+ * which all the bits of an element land in a single cache line. The element is
+ * hashed once with SipHash, the bits within the line are derived from that
+ * hash, and they are tested and set with word-wise operations over the whole
+ * line which the compiler can vectorize.
+ *
+ * Confining the bits of an element to one line raises the false-positive rate
+ * of a filter of a given size, so the filter is sized for the requested rate
+ * under the blocked layout, and is somewhat larger than CRollingBloomFilter.
+ */
+class CBlockedRollingBloomFilter {
+public:
+    CBlockedRollingBloomFilter(const uint32_t nElements, const double nFPRate);
+
+    void insert(const std::vector<uint8_t> &vKey);
+    void insert(const uint256 &hash);
+    bool contains(const std::vector<uint8_t> &vKey) const;
+    bool contains(const uint256 &hash) const;
+
+    void reset();
+
+    //! Memory used by the filter bits, in bytes
+    size_t GetMemoryUsage() const { return data.size() * sizeof(Block); }
+
+private:
+    //! Number of 64-bit words of a block in each generation plane
+    static constexpr size_t BLOCK_WORDS = 4;
+    static constexpr uint32_t BLOCK_BITS = BLOCK_WORDS * 64;
+
+    /**
+     * A cache line worth of BLOCK_BITS positions. As in CRollingBloomFilter,
+     * each position is stored as 2 bits, one in each plane: (00) is unset,
+     * (01), (10) and (11) are set in generation 1, 2 or 3 respectively.
+     */
+    struct alignas(64) Block {
+        uint64_t gen1[BLOCK_WORDS];
+        uint64_t gen2[BLOCK_WORDS];
+    };
+    using BlockMask = std::array<uint64_t, BLOCK_WORDS>;
+
+    void InsertHash(uint64_t hash);
+    bool ContainsHash(uint64_t hash) const;
+    BlockMask GetBlockMask(uint64_t hash) const;
+
+    int nEntriesPerGeneration;
+    int nEntriesThisGeneration;
+    int nGeneration;
+    std::vector<Block> data;
+    uint64_t m_k0;
+    uint64_t m_k1;
+    int nHashFuncs;
+};
+
 #endif // BITCOIN_BLOOM_H
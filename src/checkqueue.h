@@ -96,7 +96,7 @@ private:
                         return fRet;
                     }
                     nIdle++;
-                    cond.wait(lock); // wait
+                    lock.Wait(cond); // wait
                     nIdle--;
                 }
                 if (m_request_stop) {
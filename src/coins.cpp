@@ -353,6 +353,7 @@ bool CCoinsViewErrorCatcher::GetCoin(const COutPoint &outpoint,
         // read data), and could lead to invalid interpretation. Just exit
         // immediately, as we can't continue anyway, and all writes should be
         // atomic.
+        LogInstance().Flush();
         std::abort();
     }
 }
@@ -5,6 +5,8 @@
 #include <consensus/merkle.h>
 #include <hash.h>
 
+#include <cassert>
+
 /*     WARNING! If you're reading this because you're learning about crypto
        and/or designing a new system that will use merkle trees, keep in mind
        that the following merkle tree algorithm has a serious flaw related to
@@ -66,6 +68,32 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated) {
     return hashes[0];
 }
 
+uint256 ComputeMerkleSubtreeRoot(std::vector<uint256> hashes, size_t height,
+                                 bool *mutated) {
+    assert(!hashes.empty() && hashes.size() <= (size_t(1) << height));
+    bool mutation = false;
+    for (size_t level = 0; level < height; level++) {
+        if (mutated) {
+            for (size_t pos = 0; pos + 1 < hashes.size(); pos += 2) {
+                if (hashes[pos] == hashes[pos + 1]) {
+                    mutation = true;
+                }
+            }
+        }
+        // The last subtree of the tree is padded the same way as the whole
+        // tree, up to the requested height.
+        if (hashes.size() & 1) {
+            hashes.push_back(hashes.back());
+        }
+        SHA256D64(hashes[0].begin(), hashes[0].begin(), hashes.size() / 2);
+        hashes.resize(hashes.size() / 2);
+    }
+    if (mutated) {
+        *mutated = mutation;
+    }
+    return hashes[0];
+}
+
 uint256 BlockMerkleRoot(const CBlock &block, bool *mutated) {
     std::vector<uint256> leaves;
     leaves.resize(block.vtx.size());
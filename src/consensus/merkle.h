@@ -12,6 +12,16 @@
 
 uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated = nullptr);
 
+/**
+ * Compute the root of the subtree of the given height over at most 2^height
+ * consecutive hashes. If there are fewer hashes, they are treated as the end
+ * of a larger tree. The merkle root of a list of more than 2^height hashes is
+ * the ComputeMerkleRoot of the roots of its subtrees, which allows the
+ * subtrees to be computed independently.
+ */
+uint256 ComputeMerkleSubtreeRoot(std::vector<uint256> hashes, size_t height,
+                                 bool *mutated = nullptr);
+
 /**
  * Compute the Merkle root of the transactions in a block.
  * *mutated is set to true if a duplicated subtree was found.
@@ -8,6 +8,7 @@
 #include <crypto/common.h>
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 
 #if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
@@ -26,12 +27,17 @@ namespace sha256d64_avx2 {
 void Transform_8way(uint8_t *out, const uint8_t *in);
 }
 
+namespace sha256_avx2 {
+void Transform_8way(uint32_t *s, const uint8_t *const *chunks);
+}
+
 namespace sha256d64_shani {
 void Transform_2way(uint8_t *out, const uint8_t *in);
 }
 
 namespace sha256_shani {
 void Transform(uint32_t *s, const uint8_t *chunk, size_t blocks);
+void Transform_2way(uint32_t *s, const uint8_t *const *chunks);
 }
 
 // Internal implementation code.
@@ -619,6 +625,147 @@ TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
 
+typedef void (*TransformMultiType)(uint32_t *, const uint8_t *const *);
+typedef void (*HashMultiType)(uint8_t *, const Span<const uint8_t> *, size_t);
+
+/** Double-SHA256 of one message of arbitrary length. */
+void HashD(uint8_t *out, Span<const uint8_t> in) {
+    uint8_t buf[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(in.data(), in.size()).Finalize(buf);
+    CSHA256().Write(buf, CSHA256::OUTPUT_SIZE).Finalize(out);
+}
+
+void HashDMulti_1way(uint8_t *out, const Span<const uint8_t> *in,
+                     size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        HashD(out + 32 * i, in[i]);
+    }
+}
+
+/**
+ * Hash independent messages of arbitrary length with a kernel transforming
+ * one chunk for each of N states at once.
+ *
+ * Each lane walks through the blocks of one message, then through its padded
+ * tail, then through the padded first digest; it then picks up the next
+ * message. Messages are read in place, only the tails are copied.
+ */
+template <size_t N, TransformMultiType tr>
+void HashDMulti(uint8_t *out, const Span<const uint8_t> *in, size_t count) {
+    static const uint8_t idle_chunk[64] = {0};
+
+    struct Lane {
+        //! Message being hashed, or SIZE_MAX if the lane is idle
+        size_t msg;
+        //! 0: message blocks, 1: padded tail, 2: second hash
+        int phase;
+        const uint8_t *data;
+        size_t blocks;
+        size_t tail_blocks;
+        uint8_t tail[128];
+    };
+
+    // Idle lanes are transformed too, so their state must be initialized
+    uint32_t state[8 * N]{};
+    Lane lanes[N];
+    size_t next = 0;
+    size_t active = 0;
+
+    auto start = [&](size_t l) {
+        Lane &lane = lanes[l];
+        if (next == count) {
+            lane.msg = SIZE_MAX;
+            return;
+        }
+        const Span<const uint8_t> msg = in[next];
+        lane.msg = next++;
+        ++active;
+
+        sha256::Initialize(state + 8 * l);
+        lane.phase = 0;
+        lane.data = msg.data();
+        lane.blocks = msg.size() / 64;
+
+        const size_t rem = msg.size() % 64;
+        lane.tail_blocks = rem < 56 ? 1 : 2;
+        std::memset(lane.tail, 0, sizeof(lane.tail));
+        if (rem) {
+            std::memcpy(lane.tail, msg.data() + msg.size() - rem, rem);
+        }
+        lane.tail[rem] = 0x80;
+        WriteBE64(lane.tail + 64 * lane.tail_blocks - 8, uint64_t(msg.size())
+                                                             << 3);
+        if (lane.blocks == 0) {
+            lane.phase = 1;
+            lane.data = lane.tail;
+            lane.blocks = lane.tail_blocks;
+        }
+    };
+
+    // Called once the current run of blocks of a lane has been processed.
+    auto advance = [&](size_t l) {
+        Lane &lane = lanes[l];
+        uint32_t *s = state + 8 * l;
+        if (lane.phase == 0) {
+            lane.phase = 1;
+            lane.data = lane.tail;
+            lane.blocks = lane.tail_blocks;
+        } else if (lane.phase == 1) {
+            std::memset(lane.tail, 0, 64);
+            for (int i = 0; i < 8; ++i) {
+                WriteBE32(lane.tail + 4 * i, s[i]);
+            }
+            lane.tail[32] = 0x80;
+            WriteBE64(lane.tail + 56, 256);
+            sha256::Initialize(s);
+            lane.phase = 2;
+            lane.data = lane.tail;
+            lane.blocks = 1;
+        } else {
+            for (int i = 0; i < 8; ++i) {
+                WriteBE32(out + 32 * lane.msg + 4 * i, s[i]);
+            }
+            --active;
+            start(l);
+        }
+    };
+
+    for (size_t l = 0; l < N; ++l) {
+        start(l);
+    }
+
+    while (active > 0) {
+        if (active == 1 && next == count) {
+            // Finish the last message without wasting the other lanes.
+            for (size_t l = 0; l < N; ++l) {
+                while (lanes[l].msg != SIZE_MAX) {
+                    Transform(state + 8 * l, lanes[l].data, lanes[l].blocks);
+                    advance(l);
+                }
+            }
+            break;
+        }
+
+        const uint8_t *chunks[N];
+        for (size_t l = 0; l < N; ++l) {
+            chunks[l] = lanes[l].msg == SIZE_MAX ? idle_chunk : lanes[l].data;
+        }
+        tr(state, chunks);
+        for (size_t l = 0; l < N; ++l) {
+            Lane &lane = lanes[l];
+            if (lane.msg == SIZE_MAX) {
+                continue;
+            }
+            lane.data += 64;
+            if (--lane.blocks == 0) {
+                advance(l);
+            }
+        }
+    }
+}
+
+HashMultiType HashDMultiImpl = HashDMulti_1way;
+
 bool SelfTest() {
     // Input state (equal to the initial SHA256 state)
     static const uint32_t init[8] = {0x6a09e667ul, 0xbb67ae85ul, 0x3c6ef372ul,
@@ -729,18 +876,24 @@ bool SelfTest() {
         }
     }
 
-    return true;
-}
+    // Test the multi-message double-SHA256 against hashing the messages one
+    // by one, with lengths covering every padding case.
+    if (HashDMultiImpl != HashDMulti_1way) {
+        Span<const uint8_t> msgs[24];
+        for (size_t i = 0; i < 24; ++i) {
+            msgs[i] = Span<const uint8_t>{data + 1, (i * 83) % 640};
+        }
+        uint8_t out[24 * 32];
+        uint8_t expected[24 * 32];
+        HashDMultiImpl(out, msgs, 24);
+        HashDMulti_1way(expected, msgs, 24);
+        if (!std::equal(out, out + sizeof(out), expected)) {
+            return false;
+        }
+    }
 
-#if defined(USE_ASM) &&                                                        \
-    (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
-/** Check whether the OS has enabled AVX registers. */
-bool AVXEnabled() {
-    uint32_t a, d;
-    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
-    return (a & 6) == 6;
+    return true;
 }
-#endif
 } // namespace
 
 std::string SHA256AutoDetect() {
@@ -753,7 +906,6 @@ std::string SHA256AutoDetect() {
     bool have_shani = false;
     bool enabled_avx = false;
 
-    (void)AVXEnabled;
     (void)have_sse4;
     (void)have_avx;
     (void)have_xsave;
@@ -780,6 +932,7 @@ std::string SHA256AutoDetect() {
         Transform = sha256_shani::Transform;
         TransformD64 = TransformD64Wrapper<sha256_shani::Transform>;
         TransformD64_2way = sha256d64_shani::Transform_2way;
+        HashDMultiImpl = HashDMulti<2, sha256_shani::Transform_2way>;
         ret = "shani(1way,2way)";
         have_sse4 = false; // Disable SSE4/AVX2;
         have_avx2 = false;
@@ -801,6 +954,7 @@ std::string SHA256AutoDetect() {
 #if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
+        HashDMultiImpl = HashDMulti<8, sha256_avx2::Transform_8way>;
         ret += ",avx2(8way)";
     }
 #endif
@@ -895,3 +1049,8 @@ void SHA256D64(uint8_t *out, const uint8_t *in, size_t blocks) {
         --blocks;
     }
 }
+
+void SHA256DMulti(uint8_t *output, const Span<const uint8_t> *inputs,
+                  size_t count) {
+    HashDMultiImpl(output, inputs, count);
+}
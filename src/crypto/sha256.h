@@ -5,6 +5,8 @@
 #ifndef BITCOIN_CRYPTO_SHA256_H
 #define BITCOIN_CRYPTO_SHA256_H
 
+#include <span.h>
+
 #include <cstdint>
 #include <cstdlib>
 #include <string>
@@ -39,4 +41,14 @@ std::string SHA256AutoDetect();
  */
 void SHA256D64(uint8_t *output, const uint8_t *input, size_t blocks);
 
+/**
+ * Compute multiple double-SHA256's of independent messages of arbitrary
+ * length, interleaving them when a multi-way implementation is available.
+ * output:  pointer to a count*32 byte output buffer
+ * inputs:  pointer to count messages
+ * count:   the number of hashes to compute.
+ */
+void SHA256DMulti(uint8_t *output, const Span<const uint8_t> *inputs,
+                  size_t count);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
@@ -454,4 +454,103 @@ void Transform_8way(uint8_t *out, const uint8_t *in) {
 }
 } // namespace sha256d64_avx2
 
+namespace sha256_avx2 {
+namespace {
+    using namespace sha256d64_avx2;
+
+    const uint32_t ROUND_K[64] = {
+        0x428a2f98ul, 0x71374491ul, 0xb5c0fbcful, 0xe9b5dba5ul,
+        0x3956c25bul, 0x59f111f1ul, 0x923f82a4ul, 0xab1c5ed5ul,
+        0xd807aa98ul, 0x12835b01ul, 0x243185beul, 0x550c7dc3ul,
+        0x72be5d74ul, 0x80deb1feul, 0x9bdc06a7ul, 0xc19bf174ul,
+        0xe49b69c1ul, 0xefbe4786ul, 0x0fc19dc6ul, 0x240ca1ccul,
+        0x2de92c6ful, 0x4a7484aaul, 0x5cb0a9dcul, 0x76f988daul,
+        0x983e5152ul, 0xa831c66dul, 0xb00327c8ul, 0xbf597fc7ul,
+        0xc6e00bf3ul, 0xd5a79147ul, 0x06ca6351ul, 0x14292967ul,
+        0x27b70a85ul, 0x2e1b2138ul, 0x4d2c6dfcul, 0x53380d13ul,
+        0x650a7354ul, 0x766a0abbul, 0x81c2c92eul, 0x92722c85ul,
+        0xa2bfe8a1ul, 0xa81a664bul, 0xc24b8b70ul, 0xc76c51a3ul,
+        0xd192e819ul, 0xd6990624ul, 0xf40e3585ul, 0x106aa070ul,
+        0x19a4c116ul, 0x1e376c08ul, 0x2748774cul, 0x34b0bcb5ul,
+        0x391c0cb3ul, 0x4ed8aa4aul, 0x5b9cca4ful, 0x682e6ff3ul,
+        0x748f82eeul, 0x78a5636ful, 0x84c87814ul, 0x8cc70208ul,
+        0x90befffaul, 0xa4506cebul, 0xbef9a3f7ul, 0xc67178f2ul,
+    };
+
+    /** Read the same 32-bit word of 8 independent chunks, one per lane. */
+    __m256i inline Read8Lanes(const uint8_t *const *chunks, int offset) {
+        __m256i ret = _mm256_set_epi32(
+            ReadLE32(chunks[7] + offset), ReadLE32(chunks[6] + offset),
+            ReadLE32(chunks[5] + offset), ReadLE32(chunks[4] + offset),
+            ReadLE32(chunks[3] + offset), ReadLE32(chunks[2] + offset),
+            ReadLE32(chunks[1] + offset), ReadLE32(chunks[0] + offset));
+        return _mm256_shuffle_epi8(
+            ret, _mm256_set_epi32(0x0C0D0E0FUL, 0x08090A0BUL, 0x04050607UL,
+                                  0x00010203UL, 0x0C0D0E0FUL, 0x08090A0BUL,
+                                  0x04050607UL, 0x00010203UL));
+    }
+
+    /** Gather word i of the 8 consecutive lane states. */
+    __m256i inline LoadState(const uint32_t *s, int i) {
+        return _mm256_set_epi32(s[56 + i], s[48 + i], s[40 + i], s[32 + i],
+                                s[24 + i], s[16 + i], s[8 + i], s[i]);
+    }
+
+    /** Add v to word i of the 8 consecutive lane states. */
+    inline void AddState(uint32_t *s, int i, __m256i v) {
+        alignas(32) uint32_t words[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(words), v);
+        for (int lane = 0; lane < 8; ++lane) {
+            s[8 * lane + i] += words[lane];
+        }
+    }
+} // namespace
+
+/**
+ * Transform one 64-byte chunk for each of eight independent states. s points
+ * to the eight consecutive 8-word states.
+ */
+void Transform_8way(uint32_t *s, const uint8_t *const *chunks) {
+    __m256i a = LoadState(s, 0);
+    __m256i b = LoadState(s, 1);
+    __m256i c = LoadState(s, 2);
+    __m256i d = LoadState(s, 3);
+    __m256i e = LoadState(s, 4);
+    __m256i f = LoadState(s, 5);
+    __m256i g = LoadState(s, 6);
+    __m256i h = LoadState(s, 7);
+
+    __m256i w[16];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = Read8Lanes(chunks, 4 * i);
+    }
+
+    for (int i = 0; i < 64; i += 8) {
+        if (i >= 16) {
+            for (int j = i; j < i + 8; ++j) {
+                Inc(w[j & 15], sigma1(w[(j - 2) & 15]), w[(j - 7) & 15],
+                    sigma0(w[(j - 15) & 15]));
+            }
+        }
+        Round(a, b, c, d, e, f, g, h, Add(K(ROUND_K[i + 0]), w[(i + 0) & 15]));
+        Round(h, a, b, c, d, e, f, g, Add(K(ROUND_K[i + 1]), w[(i + 1) & 15]));
+        Round(g, h, a, b, c, d, e, f, Add(K(ROUND_K[i + 2]), w[(i + 2) & 15]));
+        Round(f, g, h, a, b, c, d, e, Add(K(ROUND_K[i + 3]), w[(i + 3) & 15]));
+        Round(e, f, g, h, a, b, c, d, Add(K(ROUND_K[i + 4]), w[(i + 4) & 15]));
+        Round(d, e, f, g, h, a, b, c, Add(K(ROUND_K[i + 5]), w[(i + 5) & 15]));
+        Round(c, d, e, f, g, h, a, b, Add(K(ROUND_K[i + 6]), w[(i + 6) & 15]));
+        Round(b, c, d, e, f, g, h, a, Add(K(ROUND_K[i + 7]), w[(i + 7) & 15]));
+    }
+
+    AddState(s, 0, a);
+    AddState(s, 1, b);
+    AddState(s, 2, c);
+    AddState(s, 3, d);
+    AddState(s, 4, e);
+    AddState(s, 5, f);
+    AddState(s, 6, g);
+    AddState(s, 7, h);
+}
+} // namespace sha256_avx2
+
 #endif
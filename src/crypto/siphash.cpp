@@ -4,6 +4,8 @@
 
 #include <crypto/siphash.h>
 
+#include <compat/cpuid.h>
+
 #define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
 
 #define SIPROUND                                                               \
@@ -135,6 +137,30 @@ uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256 &val) {
     return v0 ^ v1 ^ v2 ^ v3;
 }
 
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+namespace siphash_avx2 {
+void SipHashUint256_4way(uint64_t k0, uint64_t k1, const uint256 *vals,
+                         uint64_t *out);
+}
+#endif
+
+void SipHashUint256Multi(uint64_t k0, uint64_t k1, const uint256 *vals,
+                         size_t count, uint64_t *out) {
+    size_t i = 0;
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL) &&                \
+    defined(USE_ASM) && defined(HAVE_GETCPUID)
+    static const bool use_avx2 = HaveAVX2();
+    if (use_avx2) {
+        for (; i + 4 <= count; i += 4) {
+            siphash_avx2::SipHashUint256_4way(k0, k1, vals + i, out + i);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = SipHashUint256(k0, k1, vals[i]);
+    }
+}
+
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256 &val,
                              uint32_t extra) {
     /* Specialized implementation for efficiency */
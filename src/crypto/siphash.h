@@ -7,6 +7,7 @@
 
 #include <uint256.h>
 
+#include <cstddef>
 #include <cstdint>
 
 /** SipHash-2-4 */
@@ -48,4 +49,12 @@ uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256 &val);
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256 &val,
                              uint32_t extra);
 
+/**
+ * Compute SipHashUint256(k0, k1, vals[i]) into out[i] for count values,
+ * hashing several of them in lockstep. This is much faster than one at a time
+ * when many values are hashed with the same key.
+ */
+void SipHashUint256Multi(uint64_t k0, uint64_t k1, const uint256 *vals,
+                         size_t count, uint64_t *out);
+
 #endif // BITCOIN_CRYPTO_SIPHASH_H
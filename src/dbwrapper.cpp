@@ -5,6 +5,9 @@
 #include <dbwrapper.h>
 
 #include <random.h>
+#include <sync.h>
+#include <threadinterrupt.h>
+#include <util/thread.h>
 
 #include <leveldb/cache.h>
 #include <leveldb/env.h>
@@ -12,8 +15,12 @@
 #include <memenv.h>
 
 #include <algorithm>
+#include <condition_variable>
 #include <cstdint>
+#include <map>
 #include <memory>
+#include <sstream>
+#include <thread>
 
 class CBitcoinLevelDBLogger : public leveldb::Logger {
 public:
@@ -98,13 +105,56 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize) {
+/**
+ * Forwards to a LevelDB LRU cache while counting lookup hits and misses, so
+ * the block cache efficiency can be reported.
+ */
+class CDBWrapper::CountingCache : public leveldb::Cache {
+private:
+    std::unique_ptr<leveldb::Cache> m_cache;
+
+public:
+    const size_t m_capacity;
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+
+    explicit CountingCache(size_t capacity)
+        : m_cache(leveldb::NewLRUCache(capacity)), m_capacity(capacity) {}
+
+    Handle *Insert(const leveldb::Slice &key, void *value, size_t charge,
+                   void (*deleter)(const leveldb::Slice &key,
+                                   void *value)) override {
+        return m_cache->Insert(key, value, charge, deleter);
+    }
+    Handle *Lookup(const leveldb::Slice &key) override {
+        Handle *handle = m_cache->Lookup(key);
+        (handle ? m_hits : m_misses).fetch_add(1, std::memory_order_relaxed);
+        return handle;
+    }
+    void Release(Handle *handle) override { m_cache->Release(handle); }
+    void *Value(Handle *handle) override { return m_cache->Value(handle); }
+    void Erase(const leveldb::Slice &key) override { m_cache->Erase(key); }
+    uint64_t NewId() override { return m_cache->NewId(); }
+    void Prune() override { m_cache->Prune(); }
+    size_t TotalCharge() const override { return m_cache->TotalCharge(); }
+};
+
+static leveldb::Options GetOptions(size_t nCacheSize,
+                                   const DBOptions &db_options) {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
     // up to two write buffers may be held in memory simultaneously
-    options.write_buffer_size = nCacheSize / 4;
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
+    options.write_buffer_size = db_options.write_buffer_size
+                                    ? db_options.write_buffer_size
+                                    : nCacheSize / 4;
+    if (db_options.block_size) {
+        options.block_size = db_options.block_size;
+    }
+    if (db_options.bloom_bits_per_key > 0) {
+        options.filter_policy =
+            leveldb::NewBloomFilterPolicy(db_options.bloom_bits_per_key);
+    }
+    options.compression = db_options.compression ? leveldb::kSnappyCompression
+                                                 : leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 ||
         (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -116,15 +166,169 @@ static leveldb::Options GetOptions(size_t nCacheSize) {
     return options;
 }
 
+bool ParseDBOption(const std::string &str, std::string &db_name,
+                   std::string &option, uint64_t &value, std::string &error) {
+    const size_t colon = str.find(':');
+    const size_t equal = str.find('=', colon == std::string::npos ? 0 : colon);
+    if (colon == std::string::npos || colon == 0 ||
+        equal == std::string::npos || equal == colon + 1) {
+        error = strprintf(
+            "Invalid -dboption '%s', expected <db>:<option>=<value>", str);
+        return false;
+    }
+    db_name = str.substr(0, colon);
+    option = str.substr(colon + 1, equal - colon - 1);
+    if (option != "blockcache" && option != "writebuffer" &&
+        option != "blocksize" && option != "compression" &&
+        option != "bloombits") {
+        error = strprintf("Unknown -dboption option '%s'", option);
+        return false;
+    }
+    if (!ParseUInt64(str.substr(equal + 1), &value)) {
+        error = strprintf("Invalid -dboption value for %s:%s", db_name, option);
+        return false;
+    }
+    if ((option == "compression" && value > 1) ||
+        (option == "bloombits" && value > 64)) {
+        error = strprintf("-dboption value for %s:%s is out of range",
+                          db_name, option);
+        return false;
+    }
+    return true;
+}
+
+DBOptions ReadDBOptions(const ArgsManager &args, const std::string &db_name) {
+    DBOptions db_options;
+    db_options.name = db_name;
+    for (const std::string &str : args.GetArgs("-dboption")) {
+        std::string name, option, error;
+        uint64_t value;
+        // Malformed options are rejected during init.
+        if (!ParseDBOption(str, name, option, value, error) ||
+            name != db_name) {
+            continue;
+        }
+        if (option == "blockcache") {
+            db_options.block_cache_size = value << 20;
+        } else if (option == "writebuffer") {
+            db_options.write_buffer_size = value << 20;
+        } else if (option == "blocksize") {
+            db_options.block_size = value << 10;
+        } else if (option == "compression") {
+            db_options.compression = value != 0;
+        } else if (option == "bloombits") {
+            db_options.bloom_bits_per_key = value;
+        }
+    }
+    return db_options;
+}
+
+double DBStats::CacheHitRate() const {
+    const uint64_t lookups = cache_hits + cache_misses;
+    return lookups ? double(cache_hits) / lookups : 0;
+}
+
+double DBStats::WriteAmplification() const {
+    if (bytes_written == 0) {
+        return 0;
+    }
+    double written_mib = 0;
+    for (const DBLevelStats &level : levels) {
+        written_mib += level.compaction_write_mib;
+    }
+    return written_mib * 1048576.0 / bytes_written;
+}
+
+int DBStats::ReadAmplification() const {
+    // Every level 0 file may overlap the key, while deeper levels contribute
+    // at most one table each.
+    int tables = 0;
+    for (const DBLevelStats &level : levels) {
+        if (level.level == 0) {
+            tables += level.files;
+        } else if (level.files > 0) {
+            tables++;
+        }
+    }
+    return tables;
+}
+
+namespace {
+Mutex g_dbwrappers_mutex;
+//! The open databases, with the number of compactions running on each
+std::map<const CDBWrapper *, int>
+    g_dbwrappers GUARDED_BY(g_dbwrappers_mutex);
+//! Notified when a compaction is done
+std::condition_variable g_dbwrappers_cv;
+
+CThreadInterrupt g_db_compaction_interrupt;
+std::thread g_db_compaction_thread;
+} // namespace
+
+void ForEachDBWrapper(const std::function<void(const CDBWrapper &)> &func) {
+    LOCK(g_dbwrappers_mutex);
+    for (const auto &[db, compactions] : g_dbwrappers) {
+        func(*db);
+    }
+}
+
+int CompactDBWrappers(const std::string &name) {
+    std::vector<const CDBWrapper *> dbs;
+    {
+        LOCK(g_dbwrappers_mutex);
+        for (auto &[db, compactions] : g_dbwrappers) {
+            if (name.empty() || db->GetOptionsName() == name) {
+                // Keeps the database open until the compaction is done
+                ++compactions;
+                dbs.push_back(db);
+            }
+        }
+    }
+
+    for (const CDBWrapper *db : dbs) {
+        db->CompactFull();
+        WITH_LOCK(g_dbwrappers_mutex, --g_dbwrappers.at(db));
+        g_dbwrappers_cv.notify_all();
+    }
+    return dbs.size();
+}
+
+void StartDBCompactionThread(std::chrono::minutes interval) {
+    assert(!g_db_compaction_thread.joinable());
+    g_db_compaction_interrupt.reset();
+    g_db_compaction_thread =
+        std::thread(&util::TraceThread, "dbcompact", [interval] {
+            while (g_db_compaction_interrupt.sleep_for(interval)) {
+                CompactDBWrappers("");
+            }
+        });
+}
+
+void InterruptDBCompactionThread() {
+    g_db_compaction_interrupt();
+}
+
+void StopDBCompactionThread() {
+    if (g_db_compaction_thread.joinable()) {
+        g_db_compaction_thread.join();
+    }
+}
+
 CDBWrapper::CDBWrapper(const fs::path &path, size_t nCacheSize, bool fMemory,
-                       bool fWipe, bool obfuscate)
-    : m_name{fs::PathToString(path.stem())} {
+                       bool fWipe, bool obfuscate, const DBOptions &db_options)
+    : m_name{fs::PathToString(path.stem())},
+      m_options_name{db_options.name.empty() ? m_name : db_options.name},
+      m_path{path} {
     penv = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, db_options);
+    m_cache = new CountingCache(db_options.block_cache_size
+                                    ? db_options.block_cache_size
+                                    : nCacheSize / 2);
+    options.block_cache = m_cache;
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -145,11 +349,7 @@ CDBWrapper::CDBWrapper(const fs::path &path, size_t nCacheSize, bool fMemory,
     LogPrintf("Opened LevelDB successfully\n");
 
     if (gArgs.GetBoolArg("-forcecompactdb", false)) {
-        LogPrintf("Starting database compaction of %s\n",
-                  fs::PathToString(path));
-        pdb->CompactRange(nullptr, nullptr);
-        LogPrintf("Finished database compaction of %s\n",
-                  fs::PathToString(path));
+        CompactFull();
     }
 
     // The base-case obfuscation key, which is a noop.
@@ -172,9 +372,26 @@ CDBWrapper::CDBWrapper(const fs::path &path, size_t nCacheSize, bool fMemory,
 
     LogPrintf("Using obfuscation key for %s: %s\n", fs::PathToString(path),
               HexStr(obfuscate_key));
+
+    LogPrint(BCLog::LEVELDB,
+             "LevelDB %s using block_cache=%u write_buffer=%u block_size=%u "
+             "compression=%d bloom_bits=%d\n",
+             m_options_name, m_cache->m_capacity, options.write_buffer_size,
+             options.block_size, db_options.compression,
+             db_options.bloom_bits_per_key);
+
+    WITH_LOCK(g_dbwrappers_mutex, g_dbwrappers.emplace(this, 0));
 }
 
 CDBWrapper::~CDBWrapper() {
+    {
+        WAIT_LOCK(g_dbwrappers_mutex, lock);
+        lock.Wait(g_dbwrappers_cv,
+                  [this]() EXCLUSIVE_LOCKS_REQUIRED(g_dbwrappers_mutex) {
+                      return g_dbwrappers.at(this) == 0;
+                  });
+        g_dbwrappers.erase(this);
+    }
     delete pdb;
     pdb = nullptr;
     delete options.filter_policy;
@@ -196,6 +413,7 @@ bool CDBWrapper::WriteBatch(CDBBatch &batch, bool fSync) {
     leveldb::Status status =
         pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
     dbwrapper_private::HandleError(status);
+    m_bytes_written.fetch_add(batch.SizeEstimate(), std::memory_order_relaxed);
     if (log_memory) {
         double mem_after = DynamicMemoryUsage() / 1024.0 / 1024;
         LogPrint(
@@ -216,6 +434,43 @@ size_t CDBWrapper::DynamicMemoryUsage() const {
     return stoul(memory);
 }
 
+DBStats CDBWrapper::GetStats() const {
+    DBStats stats;
+    stats.cache_hits = m_cache->m_hits.load(std::memory_order_relaxed);
+    stats.cache_misses = m_cache->m_misses.load(std::memory_order_relaxed);
+    stats.bytes_written = m_bytes_written.load(std::memory_order_relaxed);
+    stats.memory_usage = DynamicMemoryUsage();
+
+    std::string property;
+    if (!pdb->GetProperty("leveldb.stats", &property)) {
+        LogPrint(BCLog::LEVELDB, "Failed to get stats property\n");
+        return stats;
+    }
+    // Skip the three header lines, then parse one line per active level.
+    std::istringstream lines(property);
+    std::string line;
+    for (int i = 0; i < 3 && std::getline(lines, line); ++i) {
+    }
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        DBLevelStats level;
+        if (fields >> level.level >> level.files >> level.size_mib >>
+            level.compaction_time_s >> level.compaction_read_mib >>
+            level.compaction_write_mib) {
+            stats.levels.push_back(level);
+        }
+    }
+    return stats;
+}
+
+void CDBWrapper::CompactFull() const {
+    LogPrintf("Starting database compaction of %s\n",
+              fs::PathToString(m_path));
+    pdb->CompactRange(nullptr, nullptr);
+    LogPrintf("Finished database compaction of %s\n",
+              fs::PathToString(m_path));
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy past
@@ -15,9 +15,80 @@
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 
+class ArgsManager;
+
+/**
+ * Per-database LevelDB tuning. Options left to zero are derived from the
+ * cache size given to CDBWrapper, which matches the historical behavior.
+ */
+struct DBOptions {
+    //! Name under which the database is tuned with -dboption and reported
+    //! by the getdbinfo RPC (e.g. "chainstate").
+    std::string name;
+    //! Size of the LevelDB block cache in bytes (0: half of the cache size).
+    size_t block_cache_size{0};
+    //! Size of a LevelDB write buffer in bytes (0: a quarter of the cache
+    //! size).
+    size_t write_buffer_size{0};
+    //! Approximate amount of user data packed per block in bytes (0: LevelDB
+    //! default).
+    size_t block_size{0};
+    //! Whether to compress blocks using Snappy.
+    bool compression{false};
+    //! Bits per key used by the bloom filter, 0 to disable the filter.
+    int bloom_bits_per_key{10};
+};
+
+/**
+ * Parse a single -dboption value of the form <db>:<option>=<value>.
+ * Returns false and fills error if the value is malformed.
+ */
+bool ParseDBOption(const std::string &str, std::string &db_name,
+                   std::string &option, uint64_t &value, std::string &error);
+
+/**
+ * Build the tuning options for the database called db_name, applying any
+ * matching -dboption overrides.
+ */
+DBOptions ReadDBOptions(const ArgsManager &args, const std::string &db_name);
+
+/** Per-level LevelDB statistics, as reported by the "leveldb.stats" property */
+struct DBLevelStats {
+    int level{0};
+    int files{0};
+    double size_mib{0};
+    double compaction_time_s{0};
+    double compaction_read_mib{0};
+    double compaction_write_mib{0};
+};
+
+/** Snapshot of the statistics of a CDBWrapper */
+struct DBStats {
+    std::vector<DBLevelStats> levels;
+    //! Block cache lookups since the database was opened
+    uint64_t cache_hits{0};
+    uint64_t cache_misses{0};
+    //! Bytes handed to LevelDB by WriteBatch since the database was opened
+    uint64_t bytes_written{0};
+    size_t memory_usage{0};
+
+    double CacheHitRate() const;
+    //! Bytes written by memtable flushes and compactions per user byte
+    double WriteAmplification() const;
+    //! Worst-case number of tables consulted by a point lookup
+    int ReadAmplification() const;
+};
+
 class dbwrapper_error : public std::runtime_error {
 public:
     explicit dbwrapper_error(const std::string &msg)
@@ -117,13 +188,19 @@ private:
     const CDBWrapper &parent;
     leveldb::Iterator *piter;
 
+    //! Buffers reused across GetKey / GetValue calls, so walking a large
+    //! range does not allocate for every entry.
+    CDataStream ssKey;
+    CDataStream ssValue;
+
 public:
     /**
      * @param[in] _parent          Parent CDBWrapper instance.
      * @param[in] _piter           The original leveldb iterator.
      */
     CDBIterator(const CDBWrapper &_parent, leveldb::Iterator *_piter)
-        : parent(_parent), piter(_piter){};
+        : parent(_parent), piter(_piter), ssKey(SER_DISK, CLIENT_VERSION),
+          ssValue(SER_DISK, CLIENT_VERSION){};
     ~CDBIterator();
 
     bool Valid() const;
@@ -143,8 +220,8 @@ public:
     template <typename K> bool GetKey(K &key) {
         leveldb::Slice slKey = piter->key();
         try {
-            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(),
-                              SER_DISK, CLIENT_VERSION);
+            ssKey.clear();
+            ssKey.write(slKey.data(), slKey.size());
             ssKey >> key;
         } catch (const std::exception &) {
             return false;
@@ -155,8 +232,8 @@ public:
     template <typename V> bool GetValue(V &value) {
         leveldb::Slice slValue = piter->value();
         try {
-            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(),
-                                SER_DISK, CLIENT_VERSION);
+            ssValue.clear();
+            ssValue.write(slValue.data(), slValue.size());
             ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
             ssValue >> value;
         } catch (const std::exception &) {
@@ -198,6 +275,19 @@ private:
     //! the name of this database
     std::string m_name;
 
+    //! the name this database is tuned and reported under
+    std::string m_options_name;
+
+    //! the location of this database
+    fs::path m_path;
+
+    //! block cache wrapper counting lookups, owned via options.block_cache
+    class CountingCache;
+    CountingCache *m_cache;
+
+    //! bytes written through WriteBatch since the database was opened
+    std::atomic<uint64_t> m_bytes_written{0};
+
     //! a key used for optional XOR-obfuscation of the database
     std::vector<uint8_t> obfuscate_key;
 
@@ -219,9 +309,11 @@ public:
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If
      * false, XOR
      *                        with a zero'd byte array.
+     * @param[in] db_options  Per-database tuning, see ReadDBOptions.
      */
     CDBWrapper(const fs::path &path, size_t nCacheSize, bool fMemory = false,
-               bool fWipe = false, bool obfuscate = false);
+               bool fWipe = false, bool obfuscate = false,
+               const DBOptions &db_options = {});
     ~CDBWrapper();
 
     CDBWrapper(const CDBWrapper &) = delete;
@@ -286,6 +378,18 @@ public:
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
+    const std::string &GetOptionsName() const { return m_options_name; }
+    const fs::path &GetPath() const { return m_path; }
+
+    /** Gather LevelDB statistics for this database. */
+    DBStats GetStats() const;
+
+    /**
+     * Compact the whole database. This blocks the caller until the
+     * compaction is done, so it should not be called from validation.
+     */
+    void CompactFull() const;
+
     CDBIterator *NewIterator() {
         return new CDBIterator(*this, pdb->NewIterator(iteroptions));
     }
@@ -328,4 +432,32 @@ public:
     }
 };
 
+/**
+ * Call func for every CDBWrapper currently open. Databases cannot be closed
+ * while func is running.
+ */
+void ForEachDBWrapper(const std::function<void(const CDBWrapper &)> &func);
+
+/**
+ * Fully compact every open CDBWrapper whose options name is name, or every
+ * open database if name is empty, and return how many were compacted. The
+ * databases are compacted without holding the registry lock, so other
+ * databases can be opened and closed meanwhile. Closing a database that is
+ * being compacted waits for the compaction to finish.
+ */
+int CompactDBWrappers(const std::string &name);
+
+//! Default for -dbcompactinterval, in minutes (0 = disabled)
+static constexpr int64_t DEFAULT_DB_COMPACT_INTERVAL{0};
+
+/**
+ * Start a background thread compacting every open database each interval
+ * (-dbcompactinterval), off the validation path.
+ */
+void StartDBCompactionThread(std::chrono::minutes interval);
+/** Stop waiting for the next scheduled compaction. */
+void InterruptDBCompactionThread();
+/** Join the compaction thread, waiting for a running compaction to finish. */
+void StopDBCompactionThread();
+
 #endif // BITCOIN_DBWRAPPER_H
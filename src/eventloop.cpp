@@ -52,7 +52,7 @@ bool EventLoop::stopEventLoop() {
     stopRequest = true;
 
     // Wait for event loop to stop.
-    cond_running.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(cs_running) {
+    lock.Wait(cond_running, [this]() EXCLUSIVE_LOCKS_REQUIRED(cs_running) {
         return !running;
     });
 
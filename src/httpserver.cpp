@@ -100,7 +100,7 @@ public:
             {
                 WAIT_LOCK(cs, lock);
                 while (running && queue.empty()) {
-                    cond.wait(lock);
+                    lock.Wait(cond);
                 }
                 if (!running) {
                     break;
@@ -36,7 +36,8 @@ protected:
     class DB : public CDBWrapper {
     public:
         DB(const fs::path &path, size_t n_cache_size, bool f_memory = false,
-           bool f_wipe = false, bool f_obfuscate = false);
+           bool f_wipe = false, bool f_obfuscate = false,
+           const DBOptions &db_options = {});
 
         /// Read block locator of the chain that the txindex is in sync with.
         bool ReadBestBlock(CBlockLocator &locator) const;
@@ -116,8 +116,9 @@ BlockFilterIndex::BlockFilterIndex(BlockFilterType filter_type,
     fs::create_directories(path);
 
     m_name = filter_name + " block filter index";
-    m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory,
-                                           f_wipe);
+    m_db = std::make_unique<BaseIndex::DB>(
+        path / "db", n_cache_size, f_memory, f_wipe, /*f_obfuscate=*/false,
+        ReadDBOptions(gArgs, "blockfilterindex"));
     m_filter_fileseq = std::make_unique<FlatFileSeq>(std::move(path), "fltr",
                                                      FLTR_FILE_CHUNK_SIZE);
 }
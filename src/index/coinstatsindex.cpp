@@ -106,8 +106,9 @@ CoinStatsIndex::CoinStatsIndex(size_t n_cache_size, bool f_memory,
     fs::path path{gArgs.GetDataDirNet() / "indexes" / "coinstats"};
     fs::create_directories(path);
 
-    m_db = std::make_unique<CoinStatsIndex::DB>(path / "db", n_cache_size,
-                                                f_memory, f_wipe);
+    m_db = std::make_unique<CoinStatsIndex::DB>(
+        path / "db", n_cache_size, f_memory, f_wipe, /*f_obfuscate=*/false,
+        ReadDBOptions(gArgs, "coinstatsindex"));
 }
 
 bool CoinStatsIndex::WriteBlock(const CBlock &block,
@@ -32,7 +32,8 @@ public:
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe)
     : BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size,
-                    f_memory, f_wipe) {}
+                    f_memory, f_wipe, /*f_obfuscate=*/false,
+                    ReadDBOptions(gArgs, "txindex")) {}
 
 bool TxIndex::DB::ReadTxPos(const TxId &txid, CDiskTxPos &pos) const {
     return Read(std::make_pair(DB_TXINDEX, txid), pos);
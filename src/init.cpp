@@ -23,6 +23,7 @@
 #include <config.h>
 #include <consensus/amount.h>
 #include <currencyunit.h>
+#include <dbwrapper.h>
 #include <flatfile.h>
 #include <fs.h>
 #include <hash.h>
@@ -96,6 +97,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <functional>
+#include <limits>
 #include <set>
 #include <thread>
 #include <vector>
@@ -200,6 +202,7 @@ void Interrupt(NodeContext &node) {
     if (g_coin_stats_index) {
         g_coin_stats_index->Interrupt();
     }
+    InterruptDBCompactionThread();
 }
 
 void Shutdown(NodeContext &node) {
@@ -263,6 +266,7 @@ void Shutdown(NodeContext &node) {
         node.chainman->m_load_block.join();
     }
     StopScriptCheckWorkerThreads();
+    StopDBCompactionThread();
 
     // After the threads that potentially access these pointers have been
     // stopped, destruct and reset all to nullptr.
@@ -353,6 +357,7 @@ void Shutdown(NodeContext &node) {
 
     node.args = nullptr;
     LogPrintf("%s: done\n", __func__);
+    LogInstance().StopAsyncLogging();
 }
 
 /**
@@ -523,6 +528,21 @@ void SetupServerArgs(NodeContext &node) {
         strprintf("Set database cache size in MiB (%d to %d, default: %d)",
                   MIN_DB_CACHE_MB, MAX_DB_CACHE_MB, DEFAULT_DB_CACHE_MB),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-dboption=<db>:<option>=<value>",
+        "Tune the LevelDB database <db> (chainstate, blockindex, txindex, "
+        "blockfilterindex or coinstatsindex). <option> is one of blockcache "
+        "(MiB), writebuffer (MiB), blocksize (KiB), compression (0 or 1) or "
+        "bloombits (bits per key, 0 to disable). By default the block cache "
+        "and write buffer are derived from the database cache size. Can be "
+        "specified multiple times.",
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-dbcompactinterval=<n>",
+        strprintf("Fully compact every LevelDB database each <n> minutes, "
+                  "from a background thread (0 to disable, default: %d)",
+                  DEFAULT_DB_COMPACT_INTERVAL),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-finalizationdelay=<n>",
         strprintf("Set the minimum amount of time to wait between a "
@@ -671,6 +691,13 @@ void SetupServerArgs(NodeContext &node) {
         "(activate by default on Jan, 14)",
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 
+    argsman.AddArg("-adaptiveblockdownload",
+                   strprintf("Size the number of blocks in flight from each "
+                             "peer after its measured throughput, and request "
+                             "late blocks again from faster peers (default: "
+                             "%d)",
+                             DEFAULT_ADAPTIVE_BLOCK_DOWNLOAD),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg(
         "-addnode=<ip>",
         "Add a node to connect to and attempt to keep the connection "
@@ -820,6 +847,12 @@ void SetupServerArgs(NodeContext &node) {
                    strprintf("Relay non-P2SH multisig (default: %d)",
                              DEFAULT_PERMIT_BAREMULTISIG),
                    ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-reconblockrelay",
+                   strprintf("Relay new blocks to and from peers that support "
+                             "it by set reconciliation against their mempool, "
+                             "falling back to compact blocks (default: %d)",
+                             DEFAULT_RECON_BLOCK_RELAY),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     // TODO: remove the sentence "Nodes not using ... incoming connections."
     // once the changes from https://github.com/bitcoin/bitcoin/pull/23542 have
     // become widespread.
@@ -834,6 +867,13 @@ void SetupServerArgs(NodeContext &node) {
                              regtestChainParams->GetDefaultPort()),
                    ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY,
                    OptionsCategory::CONNECTION);
+    argsman.AddArg("-prioritymessages",
+                   strprintf("Process the block relay messages and the "
+                             "avalanche responses ahead of the other messages "
+                             "of the peer, e.g. transaction relay (default: "
+                             "%d)",
+                             DEFAULT_PRIORITY_MESSAGES),
+                   ArgsManager::ALLOW_BOOL, OptionsCategory::CONNECTION);
     argsman.AddArg("-proxy=<ip:port>", "Connect through SOCKS5 proxy",
                    ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg(
@@ -1095,6 +1135,13 @@ void SetupServerArgs(NodeContext &node) {
                              DEFAULT_MAX_TIP_AGE),
                    ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
                    OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-lockprofile=<n>",
+        strprintf("Time one in <n> mutex acquisitions of each thread to report "
+                  "lock contention by lock site, see the getlockprofile RPC, "
+                  "or 0 to disable (default: %u)",
+                  DEFAULT_LOCK_PROFILE_SAMPLE_RATE),
+        ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
 
     argsman.AddArg("-uacomment=<cmt>",
                    "Append comment to the user agent string",
@@ -1783,6 +1830,14 @@ bool AppInitParameterInteraction(Config &config, const ArgsManager &args) {
         }
     }
 
+    for (const std::string &str : args.GetArgs("-dboption")) {
+        std::string db_name, option, error;
+        uint64_t value;
+        if (!ParseDBOption(str, db_name, option, value, error)) {
+            return InitError(Untranslated(error));
+        }
+    }
+
     // -bind and -whitebind can't be set when not listening
     size_t nUserBind =
         args.GetArgs("-bind").size() + args.GetArgs("-whitebind").size();
@@ -1832,6 +1887,15 @@ bool AppInitParameterInteraction(Config &config, const ArgsManager &args) {
     // Step 3: parameter-to-internal-flags
     init::SetLoggingCategories(args);
 
+    const int64_t lock_profile_rate = args.GetIntArg(
+        "-lockprofile", DEFAULT_LOCK_PROFILE_SAMPLE_RATE);
+    if (lock_profile_rate < 0 ||
+        lock_profile_rate > std::numeric_limits<uint32_t>::max()) {
+        return InitError(strprintf(_("Invalid value for -lockprofile: %d"),
+                                   lock_profile_rate));
+    }
+    LockProfiler::SetSampleRate(lock_profile_rate);
+
     fCheckBlockIndex = args.GetBoolArg("-checkblockindex",
                                        chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled =
@@ -2669,6 +2733,12 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
 
     // Step 10: data directory maintenance
 
+    if (const int64_t interval{args.GetIntArg("-dbcompactinterval",
+                                              DEFAULT_DB_COMPACT_INTERVAL)};
+        interval > 0) {
+        StartDBCompactionThread(std::chrono::minutes{interval});
+    }
+
     // if pruning, unset the service bit and perform the initial blockstore
     // prune after any wallet rescanning has taken place.
     if (fPruneMode) {
@@ -2745,7 +2815,7 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         // ThreadImport getting started, so instead we just wait on a timer to
         // check ShutdownRequested() regularly.
         while (!fHaveGenesis && !ShutdownRequested()) {
-            g_genesis_wait_cv.wait_for(lock, std::chrono::milliseconds(500));
+            lock.WaitFor(g_genesis_wait_cv, std::chrono::milliseconds(500));
         }
         block_notify_genesis_wait_connection.disconnect();
     }
@@ -2816,6 +2886,8 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         1000 * args.GetIntArg("-maxsendbuffer", DEFAULT_MAXSENDBUFFER);
     connOptions.nReceiveFloodSize =
         1000 * args.GetIntArg("-maxreceivebuffer", DEFAULT_MAXRECEIVEBUFFER);
+    connOptions.m_priority_messages =
+        args.GetBoolArg("-prioritymessages", DEFAULT_PRIORITY_MESSAGES);
     connOptions.m_added_nodes = args.GetArgs("-addnode");
 
     connOptions.nMaxOutboundLimit =
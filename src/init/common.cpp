@@ -19,12 +19,28 @@
 #include <util/time.h>
 #include <util/translation.h>
 
+#include <cstdlib>
+#include <exception>
 #include <memory>
 
 using node::DEFAULT_PRINTPRIORITY;
 
 static std::unique_ptr<ECCVerifyHandle> globalVerifyHandle;
 
+static std::terminate_handler g_previous_terminate_handler{nullptr};
+
+/**
+ * Write the messages waiting to be logged asynchronously before the process
+ * is terminated, e.g. by an uncaught exception.
+ */
+[[noreturn]] static void FlushLogOnTerminate() {
+    LogInstance().Flush();
+    if (g_previous_terminate_handler) {
+        g_previous_terminate_handler();
+    }
+    std::abort();
+}
+
 namespace init {
 void SetGlobals() {
     std::string sha256_algo = SHA256AutoDetect();
@@ -120,6 +136,17 @@ void AddLoggingArgs(ArgsManager &argsman) {
                   DEFAULT_LOGTIMEMICROS),
         ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
         OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-asynclogging",
+        strprintf("Write the debug output from a background thread, in "
+                  "batches. If more than %u MiB of messages are waiting to be "
+                  "written, the new ones are dropped and their number is "
+                  "logged. The waiting messages are written on shutdown, on "
+                  "fatal errors and uncaught exceptions, but they are lost "
+                  "if the process is killed or fails an assertion "
+                  "(default: %u)",
+                  DEFAULT_LOGASYNC_MAX_BYTES >> 20, DEFAULT_LOGASYNC),
+        ArgsManager::ALLOW_BOOL, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-printtoconsole",
                    "Send trace/debug info to console (default: 1 when no "
                    "-daemon. To disable logging to file, set -nodebuglogfile)",
@@ -203,6 +230,14 @@ bool StartLogging(const ArgsManager &args) {
                       fs::PathToString(logger.m_file_path)));
     }
 
+    if (args.GetBoolArg("-asynclogging", DEFAULT_LOGASYNC)) {
+        logger.StartAsyncLogging();
+        if (!g_previous_terminate_handler) {
+            g_previous_terminate_handler =
+                std::set_terminate(FlushLogOnTerminate);
+        }
+    }
+
     if (!logger.m_log_timestamps) {
         LogPrintf("Startup time: %s\n", FormatISO8601DateTime(GetTime()));
     }
@@ -7,6 +7,7 @@
 #include <logging.h>
 
 #include <util/string.h>
+#include <util/thread.h>
 #include <util/threadnames.h>
 #include <util/time.h>
 
@@ -86,6 +87,7 @@ bool BCLog::Logger::StartLogging() {
 }
 
 void BCLog::Logger::DisconnectTestLogger() {
+    StopAsyncLogging();
     StdLockGuard scoped_lock(m_cs);
     m_buffering = true;
     if (m_fileout != nullptr) {
@@ -173,6 +175,7 @@ std::vector<LogCategory> BCLog::Logger::LogCategoriesList() const {
 }
 
 BCLog::Logger::~Logger() {
+    StopAsyncLogging();
     if (m_fileout) {
         fclose(m_fileout);
     }
@@ -254,6 +257,14 @@ void BCLog::Logger::LogPrintStr(const std::string &str,
         return;
     }
 
+    if (m_async) {
+        for (const auto &cb : m_print_callbacks) {
+            cb(str_prefixed);
+        }
+        QueueAsyncMessage(str_prefixed);
+        return;
+    }
+
     if (m_print_to_console) {
         // Print to console.
         fwrite(str_prefixed.data(), 1, str_prefixed.size(), stdout);
@@ -264,19 +275,136 @@ void BCLog::Logger::LogPrintStr(const std::string &str,
     }
     if (m_print_to_file) {
         assert(m_fileout != nullptr);
+        ReopenFileIfRequested();
+        FileWriteStr(str_prefixed, m_fileout);
+    }
+}
 
-        // Reopen the log file, if requested.
-        if (m_reopen_file) {
-            m_reopen_file = false;
-            FILE *new_fileout = fsbridge::fopen(m_file_path, "a");
-            if (new_fileout) {
-                // unbuffered.
-                setbuf(m_fileout, nullptr);
-                fclose(m_fileout);
-                m_fileout = new_fileout;
-            }
+void BCLog::Logger::ReopenFileIfRequested() {
+    if (m_reopen_file) {
+        m_reopen_file = false;
+        FILE *new_fileout = fsbridge::fopen(m_file_path, "a");
+        if (new_fileout) {
+            // unbuffered.
+            setbuf(m_fileout, nullptr);
+            fclose(m_fileout);
+            m_fileout = new_fileout;
         }
-        FileWriteStr(str_prefixed, m_fileout);
+    }
+}
+
+void BCLog::Logger::StartAsyncLogging() {
+    StdLockGuard scoped_lock(m_cs);
+    assert(!m_buffering);
+    if (m_async) {
+        return;
+    }
+    m_async = true;
+    m_async_stop = false;
+    m_async_thread = std::thread(&util::TraceThread, "logger",
+                                 [this] { AsyncWriterThread(); });
+}
+
+void BCLog::Logger::StopAsyncLogging() {
+    {
+        StdLockGuard scoped_lock(m_cs);
+        if (!m_async) {
+            return;
+        }
+        m_async_stop = true;
+    }
+    m_async_cv.notify_one();
+    if (m_async_thread.joinable()) {
+        m_async_thread.join();
+    }
+
+    // Write what is left while holding m_cs, so the messages logged from now
+    // on are written after it.
+    StdLockGuard write_lock(m_write_cs);
+    StdLockGuard scoped_lock(m_cs);
+    std::string batch;
+    WriteAsyncBatch(batch, TakeAsyncBatch(batch));
+    m_async = false;
+}
+
+void BCLog::Logger::Flush() {
+    std::string batch;
+    WriteQueuedMessages(batch);
+}
+
+void BCLog::Logger::QueueAsyncMessage(const std::string &str) {
+    // A message larger than the limit is still written if it is the only one
+    if (!m_async_buffer.empty() &&
+        m_async_buffer.size() + str.size() > m_async_max_bytes) {
+        ++m_async_unreported_drops;
+        ++m_async_drops;
+        return;
+    }
+    // The writer only waits for messages when there is none
+    const bool notify = m_async_buffer.empty();
+    m_async_buffer += str;
+    if (notify) {
+        m_async_cv.notify_one();
+    }
+}
+
+FILE *BCLog::Logger::TakeAsyncBatch(std::string &batch) {
+    batch.clear();
+    std::swap(batch, m_async_buffer);
+    // The messages were dropped after the ones in the batch
+    if (m_async_unreported_drops > 0) {
+        batch += strprintf("*** %u log messages were dropped\n",
+                           m_async_unreported_drops);
+        m_async_unreported_drops = 0;
+    }
+    if (!m_print_to_file) {
+        return nullptr;
+    }
+    assert(m_fileout != nullptr);
+    ReopenFileIfRequested();
+    return m_fileout;
+}
+
+void BCLog::Logger::WriteAsyncBatch(const std::string &batch, FILE *file) {
+    if (batch.empty()) {
+        return;
+    }
+    if (m_print_to_console) {
+        fwrite(batch.data(), 1, batch.size(), stdout);
+        fflush(stdout);
+    }
+    if (file) {
+        FileWriteStr(batch, file);
+    }
+}
+
+void BCLog::Logger::WriteQueuedMessages(std::string &batch) {
+    // The file is only written to by the holder of m_write_cs in asynchronous
+    // mode, so it is safe to use it after m_cs is released.
+    StdLockGuard write_lock(m_write_cs);
+    FILE *file;
+    {
+        StdLockGuard scoped_lock(m_cs);
+        if (!m_async) {
+            return;
+        }
+        file = TakeAsyncBatch(batch);
+    }
+    WriteAsyncBatch(batch, file);
+}
+
+void BCLog::Logger::AsyncWriterThread() {
+    // The buffer is swapped with the one of the logger, so both keep their
+    // capacity.
+    std::string batch;
+    while (!m_async_stop) {
+        {
+            std::unique_lock<StdMutex> lock(m_cs);
+            m_async_cv.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_cs) {
+                return m_async_stop || !m_async_buffer.empty();
+            });
+        }
+        WriteQueuedMessages(batch);
     }
 }
 
@@ -13,16 +13,21 @@
 #include <util/string.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <list>
 #include <mutex>
 #include <string>
+#include <thread>
 
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
 static const bool DEFAULT_LOGSOURCELOCATIONS = false;
+static const bool DEFAULT_LOGASYNC = false;
+//! Default for the size of the messages waiting to be written asynchronously
+static constexpr size_t DEFAULT_LOGASYNC_MAX_BYTES{16 << 20};
 
 extern bool fLogIPs;
 extern const char *const DEFAULT_DEBUGLOGFILE;
@@ -90,8 +95,34 @@ private:
      */
     std::atomic<uint32_t> m_categories{0};
 
+    /**
+     * In asynchronous mode, the messages are written to the console and the
+     * log file in batches by a background thread, so that the logging threads
+     * don't wait for the I/O. m_write_cs serializes the writes of the batches
+     * and is taken before m_cs.
+     */
+    bool m_async GUARDED_BY(m_cs){false};
+    std::atomic<bool> m_async_stop{false};
+    //! The messages waiting to be written
+    std::string m_async_buffer GUARDED_BY(m_cs);
+    //! Messages dropped since the last batch was written
+    uint64_t m_async_unreported_drops GUARDED_BY(m_cs){0};
+    std::atomic<uint64_t> m_async_drops{0};
+    std::condition_variable_any m_async_cv;
+    StdMutex m_write_cs;
+    std::thread m_async_thread;
+
     std::string LogTimestampStr(const std::string &str);
 
+    void ReopenFileIfRequested() EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+    void QueueAsyncMessage(const std::string &str)
+        EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+    //! Move the waiting messages to batch, and return the file to write to
+    FILE *TakeAsyncBatch(std::string &batch) EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+    void WriteAsyncBatch(const std::string &batch, FILE *file);
+    void WriteQueuedMessages(std::string &batch);
+    void AsyncWriterThread();
+
     /** Slots that connect to the print signal */
     std::list<std::function<void(const std::string &)>>
         m_print_callbacks GUARDED_BY(m_cs){};
@@ -108,6 +139,9 @@ public:
     fs::path m_file_path;
     std::atomic<bool> m_reopen_file{false};
 
+    //! Above this size of waiting messages, the new messages are dropped
+    size_t m_async_max_bytes = DEFAULT_LOGASYNC_MAX_BYTES;
+
     ~Logger();
 
     /** Send a string to the log output */
@@ -142,6 +176,23 @@ public:
     /** Only for testing */
     void DisconnectTestLogger();
 
+    /**
+     * Write the messages from a background thread from now on (-asynclogging).
+     * Must be called after StartLogging().
+     */
+    void StartAsyncLogging();
+    /** Write the waiting messages and go back to synchronous logging */
+    void StopAsyncLogging();
+    /** Write the messages waiting in asynchronous mode now, e.g. on abort */
+    void Flush();
+    /** Number of messages dropped because too many were waiting */
+    uint64_t GetAsyncDrops() const { return m_async_drops.load(); }
+    /** Size of the messages waiting to be written, in bytes */
+    size_t GetAsyncQueuedBytes() const {
+        StdLockGuard scoped_lock(m_cs);
+        return m_async_buffer.size();
+    }
+
     void ShrinkDebugFile();
 
     uint32_t GetCategoryMask() const { return m_categories.load(); }
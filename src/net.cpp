@@ -26,6 +26,7 @@
 #include <protocol.h>
 #include <random.h>
 #include <scheduler.h>
+#include <util/asmap.h>
 #include <util/sock.h>
 #include <util/strencodings.h>
 #include <util/system.h>
@@ -611,6 +612,20 @@ void CNode::copyStats(CNodeStats &stats) {
         LOCK(cs_vSend);
         stats.mapSendBytesPerMsgCmd = mapSendBytesPerMsgCmd;
         stats.nSendBytes = nSendBytes;
+        stats.m_send_queue_bytes = nSendSize;
+        stats.m_send_queue_age =
+            vSendMsg.empty() ? std::chrono::microseconds{0}
+                             : GetTime<std::chrono::microseconds>() -
+                                   m_send_queue_since;
+    }
+    {
+        LOCK(cs_vProcessMsg);
+        stats.m_process_queue_msgs = vProcessMsg.size();
+        stats.m_process_queue_bytes = nProcessQueueSize;
+        stats.m_process_queue_age =
+            vProcessMsg.empty() ? std::chrono::microseconds{0}
+                                : GetTime<std::chrono::microseconds>() -
+                                      vProcessMsg.front().m_time;
     }
     {
         LOCK(cs_vRecv);
@@ -680,6 +695,73 @@ bool CNode::ReceiveMsgBytes(const Config &config, Span<const uint8_t> msg_bytes,
     return true;
 }
 
+RecvBufferPool g_recv_buffer_pool;
+
+/** Smallest size class whose buffers can hold size bytes. */
+static unsigned int GetSizeClass(size_t size) {
+    unsigned int size_class = 0;
+    while ((size_t{1} << size_class) < size) {
+        ++size_class;
+    }
+    return size_class;
+}
+
+CDataStream RecvBufferPool::Get(size_t size, int nType, int nVersion) {
+    const unsigned int size_class = GetSizeClass(size);
+    if (size_class >= MIN_SIZE_CLASS && size_class <= MAX_SIZE_CLASS) {
+        LOCK(m_mutex);
+        std::vector<CDataStream> &buffers =
+            m_buffers[size_class - MIN_SIZE_CLASS];
+        if (!buffers.empty()) {
+            CDataStream stream = std::move(buffers.back());
+            buffers.pop_back();
+            m_pooled_bytes -= stream.capacity();
+            ++m_reused;
+
+            stream.SetType(nType);
+            stream.SetVersion(nVersion);
+            return stream;
+        }
+    }
+
+    CDataStream stream(nType, nVersion);
+    if (size > 0) {
+        // Allocate the whole size class, so the buffer can be pooled for
+        // any message of that class once it is released. Buffers above
+        // MAX_PREALLOCATION double in size as they grow, so they end up
+        // filling their class as well.
+        stream.reserve(
+            size_class < MIN_SIZE_CLASS
+                ? size
+                : std::min(size_t{1} << size_class, MAX_PREALLOCATION));
+        ++m_allocated;
+    }
+    return stream;
+}
+
+void RecvBufferPool::Put(CDataStream &&stream) {
+    stream.clear();
+
+    // Buffers are filed under the largest class they can serve
+    const size_t capacity = stream.capacity();
+    if (capacity < (size_t{1} << MIN_SIZE_CLASS) ||
+        capacity >= (size_t{1} << (MAX_SIZE_CLASS + 1))) {
+        return;
+    }
+    unsigned int size_class = GetSizeClass(capacity);
+    if ((size_t{1} << size_class) > capacity) {
+        --size_class;
+    }
+
+    LOCK(m_mutex);
+    if (m_pooled_bytes + capacity > m_max_pooled_bytes) {
+        return;
+    }
+    m_buffers[size_class - MIN_SIZE_CLASS].push_back(std::move(stream));
+    m_pooled_bytes += capacity;
+    stream.clear();
+}
+
 int V1TransportDeserializer::readHeader(const Config &config,
                                         Span<const uint8_t> msg_bytes) {
     // copy data to temporary parsing buffer
@@ -707,8 +789,11 @@ int V1TransportDeserializer::readHeader(const Config &config,
         return -1;
     }
 
-    // switch state to reading message data
+    // switch state to reading message data, into a buffer that is large
+    // enough for the whole payload
     in_data = true;
+    vRecv = m_recv_pool.Get(hdr.nMessageSize, vRecv.GetType(),
+                            vRecv.GetVersion());
 
     return nCopy;
 }
@@ -717,14 +802,10 @@ int V1TransportDeserializer::readData(Span<const uint8_t> msg_bytes) {
     unsigned int nRemaining = hdr.nMessageSize - nDataPos;
     unsigned int nCopy = std::min<unsigned int>(nRemaining, msg_bytes.size());
 
-    if (vRecv.size() < nDataPos + nCopy) {
-        // Allocate up to 256 KiB ahead, but never more than the total message
-        // size.
-        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024));
-    }
-
+    // The checksum is computed as the data arrives, while it is still hot in
+    // the cache.
     hasher.Write(msg_bytes.first(nCopy));
-    memcpy(&vRecv[nDataPos], msg_bytes.data(), nCopy);
+    vRecv.write(reinterpret_cast<const char *>(msg_bytes.data()), nCopy);
     nDataPos += nCopy;
 
     return nCopy;
@@ -742,7 +823,7 @@ CNetMessage
 V1TransportDeserializer::GetMessage(const Config &config,
                                     const std::chrono::microseconds time) {
     // decompose a single CNetMessage from the TransportDeserializer
-    CNetMessage msg(std::move(vRecv));
+    CNetMessage msg(std::move(vRecv), &m_recv_pool);
 
     // store state about valid header, netmagic and checksum
     msg.m_valid_header = hdr.IsValid(config);
@@ -786,12 +867,14 @@ V1TransportDeserializer::GetMessage(const Config &config,
 void V1TransportSerializer::prepareForTransport(const Config &config,
                                                 CSerializedNetMsg &msg,
                                                 std::vector<uint8_t> &header) {
-    // create dbl-sha256 checksum
-    uint256 hash = Hash(msg.data);
+    // create dbl-sha256 checksum, which is computed only once for shared
+    // payloads
+    const uint256 hash =
+        msg.m_shared_payload ? msg.m_shared_payload->hash : Hash(msg.data);
 
     // create header
     CMessageHeader hdr(config.GetChainParams().NetMagic(), msg.m_type.c_str(),
-                       msg.data.size());
+                       msg.GetPayload().size());
     memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
 
     // serialize header
@@ -799,25 +882,69 @@ void V1TransportSerializer::prepareForTransport(const Config &config,
     CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, header, 0, hdr};
 }
 
+#ifdef WIN32
+//! Without sendmsg, the buffers are sent one at a time.
+static constexpr size_t MAX_SEND_BUFFERS = 1;
+#else
+//! Maximum number of buffers gathered into a single sendmsg call, well below
+//! the IOV_MAX of the supported platforms.
+static constexpr size_t MAX_SEND_BUFFERS = 64;
+#endif
+
+static ssize_t SendBuffersToSocket(SOCKET socket,
+                                   Span<const Span<const uint8_t>> buffers) {
+#ifdef WIN32
+    return send(socket, reinterpret_cast<const char *>(buffers[0].data()),
+                buffers[0].size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+#else
+    std::array<iovec, MAX_SEND_BUFFERS> iov;
+    const size_t count = std::min(buffers.size(), iov.size());
+    for (size_t i = 0; i < count; i++) {
+        iov[i].iov_base = const_cast<uint8_t *>(buffers[i].data());
+        iov[i].iov_len = buffers[i].size();
+    }
+
+    msghdr msg{};
+    msg.msg_iov = iov.data();
+    msg.msg_iovlen = count;
+    return sendmsg(socket, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
+}
+
+std::function<ssize_t(SOCKET, Span<const Span<const uint8_t>>)> SendBuffers =
+    SendBuffersToSocket;
+
 size_t CConnman::SocketSendData(CNode &node) const {
     size_t nSentSize = 0;
     size_t nMsgCount = 0;
 
-    for (const auto &data : node.vSendMsg) {
-        assert(data.size() > node.nSendOffset);
-        int nBytes = 0;
-
+    while (nMsgCount < node.vSendMsg.size()) {
+        // Gather as many queued buffers as possible, starting where the last
+        // call left off.
+        std::array<Span<const uint8_t>, MAX_SEND_BUFFERS> buffers;
+        size_t buffer_count = 0;
+        size_t nToSend = 0;
+        for (auto it = node.vSendMsg.begin() + nMsgCount;
+             it != node.vSendMsg.end() && buffer_count < buffers.size();
+             ++it) {
+            const size_t offset = buffer_count == 0 ? node.nSendOffset : 0;
+            assert((*it)->size() > offset);
+            buffers[buffer_count++] = Span<const uint8_t>(**it).subspan(offset);
+            nToSend += (*it)->size() - offset;
+        }
+
+        ssize_t nBytes = 0;
         {
             LOCK(node.cs_hSocket);
             if (node.hSocket == INVALID_SOCKET) {
                 break;
             }
 
-            nBytes = send(
-                node.hSocket,
-                reinterpret_cast<const char *>(data.data()) + node.nSendOffset,
-                data.size() - node.nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+            nBytes = SendBuffers(node.hSocket,
+                                 Span<const Span<const uint8_t>>(
+                                     buffers.data(), buffer_count));
         }
+        node.nSendCalls++;
 
         if (nBytes == 0) {
             // couldn't send anything at all
@@ -840,17 +967,28 @@ size_t CConnman::SocketSendData(CNode &node) const {
         assert(nBytes > 0);
         node.m_last_send = GetTime<std::chrono::seconds>();
         node.nSendBytes += nBytes;
-        node.nSendOffset += nBytes;
         nSentSize += nBytes;
-        if (node.nSendOffset != data.size()) {
-            // could not send full message; stop sending more
-            break;
-        }
 
-        node.nSendOffset = 0;
-        node.nSendSize -= data.size();
+        // Skip over the buffers that were sent completely.
+        size_t nRemaining = nBytes;
+        while (nRemaining > 0) {
+            const size_t size = node.vSendMsg[nMsgCount]->size();
+            if (nRemaining < size - node.nSendOffset) {
+                node.nSendOffset += nRemaining;
+                break;
+            }
+
+            nRemaining -= size - node.nSendOffset;
+            node.nSendOffset = 0;
+            node.nSendSize -= size;
+            nMsgCount++;
+        }
         node.fPauseSend = node.nSendSize > nSendBufferMaxSize;
-        nMsgCount++;
+
+        if (size_t(nBytes) != nToSend) {
+            // could not send everything; stop sending more
+            break;
+        }
     }
 
     node.vSendMsg.erase(node.vSendMsg.begin(),
@@ -864,6 +1002,32 @@ size_t CConnman::SocketSendData(CNode &node) const {
     return nSentSize;
 }
 
+void CConnman::QueueReceivedMessages(CNode &node) const {
+    const bool prioritize =
+        m_priority_messages && node.fSuccessfullyConnected;
+    size_t nSizeAdded = 0;
+    // vRecvMsg contains only completed CNetMessage, the single possible
+    // partially deserialized message is held by the TransportDeserializer.
+    for (CNetMessage &msg : node.vRecvMsg) {
+        nSizeAdded += msg.m_raw_message_size;
+        msg.m_priority =
+            prioritize && NetMsgType::IsHighPriority(msg.m_command);
+    }
+
+    LOCK(node.cs_vProcessMsg);
+    const auto first_normal =
+        std::find_if(node.vProcessMsg.begin(), node.vProcessMsg.end(),
+                     [](const CNetMessage &msg) { return !msg.m_priority; });
+    while (!node.vRecvMsg.empty()) {
+        const auto it = node.vRecvMsg.begin();
+        node.vProcessMsg.splice(it->m_priority ? first_normal
+                                               : node.vProcessMsg.end(),
+                                node.vRecvMsg, it);
+    }
+    node.nProcessQueueSize += nSizeAdded;
+    node.fPauseRecv = node.nProcessQueueSize > nReceiveFloodSize;
+}
+
 static bool ReverseCompareNodeMinPingTime(const NodeEvictionCandidate &a,
                                           const NodeEvictionCandidate &b) {
     return a.m_min_ping_time > b.m_min_ping_time;
@@ -1824,23 +1988,7 @@ void CConnman::SocketHandler() {
                 }
                 RecordBytesRecv(nBytes);
                 if (notify) {
-                    size_t nSizeAdded = 0;
-                    auto it(pnode->vRecvMsg.begin());
-                    for (; it != pnode->vRecvMsg.end(); ++it) {
-                        // vRecvMsg contains only completed CNetMessage
-                        // the single possible partially deserialized message
-                        // are held by TransportDeserializer
-                        nSizeAdded += it->m_raw_message_size;
-                    }
-                    {
-                        LOCK(pnode->cs_vProcessMsg);
-                        pnode->vProcessMsg.splice(pnode->vProcessMsg.end(),
-                                                  pnode->vRecvMsg,
-                                                  pnode->vRecvMsg.begin(), it);
-                        pnode->nProcessQueueSize += nSizeAdded;
-                        pnode->fPauseRecv =
-                            pnode->nProcessQueueSize > nReceiveFloodSize;
-                    }
+                    QueueReceivedMessages(*pnode);
                     WakeMessageHandler();
                 }
             } else if (nBytes == 0) {
@@ -2619,11 +2767,9 @@ void CConnman::ThreadMessageHandler() {
 
         bool fMoreWork = false;
 
-        for (CNode *pnode : vNodesCopy) {
-            if (pnode->fDisconnect) {
-                continue;
-            }
-
+        // Process a message from the node, then send it its messages. Return
+        // false if interrupted.
+        const auto process_node = [&](CNode *pnode) {
             bool fMoreNodeWork = false;
             // Receive messages
             for (auto interface : m_msgproc) {
@@ -2632,7 +2778,7 @@ void CConnman::ThreadMessageHandler() {
             }
             fMoreWork |= (fMoreNodeWork && !pnode->fPauseSend);
             if (flagInterruptMsgProc) {
-                return;
+                return false;
             }
 
             // Send messages
@@ -2643,7 +2789,31 @@ void CConnman::ThreadMessageHandler() {
                 }
             }
 
-            if (flagInterruptMsgProc) {
+            return !flagInterruptMsgProc;
+        };
+
+        // Give the nodes with a high priority message waiting an extra turn
+        // first, so these messages don't wait for a message of every other
+        // node to be processed. This at most doubles the share of a node.
+        for (CNode *pnode : vNodesCopy) {
+            if (pnode->fDisconnect ||
+                !WITH_LOCK(pnode->cs_vProcessMsg,
+                           return !pnode->vProcessMsg.empty() &&
+                                  pnode->vProcessMsg.front().m_priority)) {
+                continue;
+            }
+
+            if (!process_node(pnode)) {
+                return;
+            }
+        }
+
+        for (CNode *pnode : vNodesCopy) {
+            if (pnode->fDisconnect) {
+                continue;
+            }
+
+            if (!process_node(pnode)) {
                 return;
             }
         }
@@ -2657,11 +2827,12 @@ void CConnman::ThreadMessageHandler() {
 
         WAIT_LOCK(mutexMsgProc, lock);
         if (!fMoreWork) {
-            condMsgProc.wait_until(lock,
-                                   std::chrono::steady_clock::now() +
-                                       std::chrono::milliseconds(100),
-                                   [this]() EXCLUSIVE_LOCKS_REQUIRED(
-                                       mutexMsgProc) { return fMsgProcWake; });
+            lock.WaitUntil(condMsgProc,
+                           std::chrono::steady_clock::now() +
+                               std::chrono::milliseconds(100),
+                           [this]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) {
+                               return fMsgProcWake;
+                           });
         }
         fMsgProcWake = false;
     }
@@ -3489,17 +3660,18 @@ bool CConnman::NodeFullyConnected(const CNode *pnode) {
 }
 
 void CConnman::PushMessage(CNode *pnode, CSerializedNetMsg &&msg) {
-    size_t nMessageSize = msg.data.size();
+    const Span<const uint8_t> payload = msg.GetPayload();
+    size_t nMessageSize = payload.size();
     LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n", msg.m_type,
              nMessageSize, pnode->GetId());
     if (gArgs.GetBoolArg("-capturemessages", false)) {
-        CaptureMessage(pnode->addr, msg.m_type, msg.data,
+        CaptureMessage(pnode->addr, msg.m_type, payload,
                        /*is_incoming=*/false);
     }
 
     TRACE6(net, outbound_message, pnode->GetId(), pnode->m_addr_name.c_str(),
            pnode->ConnectionTypeAsString().c_str(), msg.m_type.c_str(),
-           msg.data.size(), msg.data.data());
+           payload.size(), payload.data());
 
     // make sure we use the appropriate network transport format
     std::vector<uint8_t> serializedHeader;
@@ -3510,6 +3682,9 @@ void CConnman::PushMessage(CNode *pnode, CSerializedNetMsg &&msg) {
     {
         LOCK(pnode->cs_vSend);
         bool optimisticSend(pnode->vSendMsg.empty());
+        if (optimisticSend) {
+            pnode->m_send_queue_since = GetTime<std::chrono::microseconds>();
+        }
 
         // log total amount of bytes per message type
         pnode->mapSendBytesPerMsgCmd[msg.m_type] += nTotalSize;
@@ -3518,9 +3693,18 @@ void CConnman::PushMessage(CNode *pnode, CSerializedNetMsg &&msg) {
         if (pnode->nSendSize > nSendBufferMaxSize) {
             pnode->fPauseSend = true;
         }
-        pnode->vSendMsg.push_back(std::move(serializedHeader));
+        pnode->vSendMsg.push_back(std::make_shared<const std::vector<uint8_t>>(
+            std::move(serializedHeader)));
         if (nMessageSize) {
-            pnode->vSendMsg.push_back(std::move(msg.data));
+            if (msg.m_shared_payload) {
+                // Keep the payload alive without copying it.
+                pnode->vSendMsg.emplace_back(msg.m_shared_payload,
+                                             &msg.m_shared_payload->data);
+            } else {
+                pnode->vSendMsg.push_back(
+                    std::make_shared<const std::vector<uint8_t>>(
+                        std::move(msg.data)));
+            }
         }
 
         // If write queue empty, attempt "optimistic write"
@@ -32,14 +32,17 @@
 #include <util/check.h>
 #include <validation.h> // For cs_main
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
 #include <thread>
+#include <utility>
 #include <vector>
 
 class AddrMan;
@@ -103,6 +106,8 @@ static const bool DEFAULT_DNSSEED = true;
 static const bool DEFAULT_FIXEDSEEDS = true;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER = 1 * 1000;
+/** Default for -prioritymessages */
+static const bool DEFAULT_PRIORITY_MESSAGES = false;
 
 /** Refresh period for the avalanche statistics computation */
 static constexpr std::chrono::minutes AVALANCHE_STATISTICS_REFRESH_PERIOD{10};
@@ -126,6 +131,19 @@ struct AddedNodeInfo {
 struct CNodeStats;
 class CClientUIInterface;
 
+/**
+ * A serialized message payload that is never modified once created, so it can
+ * be queued to many peers without being copied. The hash the message checksum
+ * is taken from is only computed once.
+ */
+struct SharedNetPayload {
+    explicit SharedNetPayload(std::vector<uint8_t> &&dataIn)
+        : data(std::move(dataIn)), hash(Hash(data)) {}
+
+    const std::vector<uint8_t> data;
+    const uint256 hash;
+};
+
 struct CSerializedNetMsg {
     CSerializedNetMsg() = default;
     CSerializedNetMsg(CSerializedNetMsg &&) = default;
@@ -134,8 +152,21 @@ struct CSerializedNetMsg {
     CSerializedNetMsg(const CSerializedNetMsg &msg) = delete;
     CSerializedNetMsg &operator=(const CSerializedNetMsg &) = delete;
 
+    //! Message sharing its payload with other messages
+    CSerializedNetMsg(std::string type,
+                      std::shared_ptr<const SharedNetPayload> shared_payload)
+        : m_type(std::move(type)), m_shared_payload(std::move(shared_payload)) {
+    }
+
     std::vector<uint8_t> data;
     std::string m_type;
+    //! If set, this is the payload and data is left empty
+    std::shared_ptr<const SharedNetPayload> m_shared_payload;
+
+    Span<const uint8_t> GetPayload() const {
+        return m_shared_payload ? Span<const uint8_t>(m_shared_payload->data)
+                                : Span<const uint8_t>(data);
+    }
 };
 
 const std::vector<std::string> CONNECTION_TYPE_DOC{
@@ -273,6 +304,14 @@ extern std::map<CNetAddr, LocalServiceInfo>
     mapLocalHost GUARDED_BY(cs_mapLocalHost);
 
 extern const std::string NET_MESSAGE_COMMAND_OTHER;
+
+/**
+ * Send the given buffers to a socket in a single system call, like send()
+ * would send a single buffer. Can be replaced by tests to simulate short
+ * writes.
+ */
+extern std::function<ssize_t(SOCKET, Span<const Span<const uint8_t>>)>
+    SendBuffers;
 // Command, total bytes
 typedef std::map<std::string, uint64_t> mapMsgCmdSize;
 
@@ -304,6 +343,15 @@ struct CNodeStats {
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     uint64_t nRecvBytes;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    //! Number and size of the received messages waiting to be processed
+    size_t m_process_queue_msgs;
+    size_t m_process_queue_bytes;
+    //! How long the oldest of them has been waiting, zero if there is none
+    std::chrono::microseconds m_process_queue_age;
+    //! Size of the data waiting to be sent
+    size_t m_send_queue_bytes;
+    //! How long the send queue has not been empty, zero if it is
+    std::chrono::microseconds m_send_queue_age;
     NetPermissionFlags m_permissionFlags;
     bool m_legacyWhitelisted;
     std::chrono::microseconds m_last_ping_time;
@@ -322,6 +370,69 @@ struct CNodeStats {
     std::optional<double> m_availabilityScore;
 };
 
+/**
+ * Pool of receive buffers, sorted in power of two size classes, so that the
+ * buffer of a processed message can be reused for the next message of the
+ * same class instead of being reallocated as the message data arrives.
+ */
+class RecvBufferPool {
+public:
+    //! Smaller buffers are allocated to size and not pooled
+    static constexpr unsigned int MIN_SIZE_CLASS = 8;
+    //! Larger buffers are not pooled
+    static constexpr unsigned int MAX_SIZE_CLASS = 25;
+    //! Default upper bound on the memory held by the idle buffers
+    static constexpr size_t MAX_POOLED_BYTES = 32 * 1024 * 1024;
+    /**
+     * Buffers that are not taken from the pool are preallocated for the
+     * announced payload size up to this limit, so that a peer cannot make us
+     * allocate for data that it never sends. Past it they grow as the data
+     * arrives.
+     */
+    static constexpr size_t MAX_PREALLOCATION = 1024 * 1024;
+
+    struct Stats {
+        //! Buffers allocated because the pool had none of the right class
+        uint64_t allocated{0};
+        //! Buffers taken from the pool
+        uint64_t reused{0};
+    };
+
+    explicit RecvBufferPool(size_t max_pooled_bytes = MAX_POOLED_BYTES)
+        : m_max_pooled_bytes(max_pooled_bytes) {}
+
+    /**
+     * Get an empty stream with room for size bytes, or up to
+     * MAX_PREALLOCATION bytes if the buffer is newly allocated.
+     */
+    CDataStream Get(size_t size, int nType, int nVersion);
+
+    //! Return a buffer to the pool. The stream is left empty.
+    void Put(CDataStream &&stream);
+
+    Stats GetStats() const {
+        return {m_allocated.load(), m_reused.load()};
+    }
+
+private:
+    static constexpr size_t NUM_SIZE_CLASSES =
+        MAX_SIZE_CLASS - MIN_SIZE_CLASS + 1;
+
+    const size_t m_max_pooled_bytes;
+
+    mutable Mutex m_mutex;
+    //! Idle buffers, indexed by size class
+    std::array<std::vector<CDataStream>, NUM_SIZE_CLASSES>
+        m_buffers GUARDED_BY(m_mutex);
+    size_t m_pooled_bytes GUARDED_BY(m_mutex){0};
+
+    std::atomic<uint64_t> m_allocated{0};
+    std::atomic<uint64_t> m_reused{0};
+};
+
+//! Receive buffer pool shared by all the peers
+extern RecvBufferPool g_recv_buffer_pool;
+
 /**
  * Transport protocol agnostic message container.
  * Ideally it should only contain receive time, payload,
@@ -331,6 +442,8 @@ class CNetMessage {
 public:
     //! received message data
     CDataStream m_recv;
+    //! the pool m_recv is returned to once the message is destroyed
+    RecvBufferPool *m_recv_pool{nullptr};
     //! time of message receipt
     std::chrono::microseconds m_time{0};
     bool m_valid_netmagic = false;
@@ -341,10 +454,49 @@ public:
     //! used wire size of the message (including header/checksum)
     uint32_t m_raw_message_size{0};
     std::string m_command;
-
-    CNetMessage(CDataStream &&recv_in) : m_recv(std::move(recv_in)) {}
+    //! queued ahead of the other messages of the peer
+    bool m_priority{false};
+
+    CNetMessage(CDataStream &&recv_in, RecvBufferPool *recv_pool = nullptr)
+        : m_recv(std::move(recv_in)), m_recv_pool(recv_pool) {}
+    //! The buffer goes along with its pool, the moved-from message has none
+    CNetMessage(CNetMessage &&other) noexcept
+        : m_recv(std::move(other.m_recv)),
+          m_recv_pool(std::exchange(other.m_recv_pool, nullptr)),
+          m_time(other.m_time), m_valid_netmagic(other.m_valid_netmagic),
+          m_valid_header(other.m_valid_header),
+          m_valid_checksum(other.m_valid_checksum),
+          m_message_size(other.m_message_size),
+          m_raw_message_size(other.m_raw_message_size),
+          m_command(std::move(other.m_command)),
+          m_priority(other.m_priority) {}
+    CNetMessage &operator=(CNetMessage &&other) noexcept {
+        if (this != &other) {
+            ReleaseBuffer();
+            m_recv = std::move(other.m_recv);
+            m_recv_pool = std::exchange(other.m_recv_pool, nullptr);
+            m_time = other.m_time;
+            m_valid_netmagic = other.m_valid_netmagic;
+            m_valid_header = other.m_valid_header;
+            m_valid_checksum = other.m_valid_checksum;
+            m_message_size = other.m_message_size;
+            m_raw_message_size = other.m_raw_message_size;
+            m_command = std::move(other.m_command);
+            m_priority = other.m_priority;
+        }
+        return *this;
+    }
+    ~CNetMessage() { ReleaseBuffer(); }
 
     void SetVersion(int nVersionIn) { m_recv.SetVersion(nVersionIn); }
+
+private:
+    //! Return the buffer to its pool, if any
+    void ReleaseBuffer() {
+        if (m_recv_pool) {
+            std::exchange(m_recv_pool, nullptr)->Put(std::move(m_recv));
+        }
+    }
 };
 
 /**
@@ -368,6 +520,7 @@ public:
 
 class V1TransportDeserializer final : public TransportDeserializer {
 private:
+    RecvBufferPool &m_recv_pool;
     mutable CHash256 hasher;
     mutable uint256 data_hash;
 
@@ -387,7 +540,8 @@ private:
     int readData(Span<const uint8_t> msg_bytes);
 
     void Reset() {
-        vRecv.clear();
+        // Give back the buffer of an incomplete message
+        m_recv_pool.Put(std::move(vRecv));
         hdrbuf.clear();
         hdrbuf.resize(24);
         in_data = false;
@@ -400,9 +554,9 @@ private:
 public:
     V1TransportDeserializer(
         const CMessageHeader::MessageMagic &pchMessageStartIn, int nTypeIn,
-        int nVersionIn)
-        : hdrbuf(nTypeIn, nVersionIn), hdr(pchMessageStartIn),
-          vRecv(nTypeIn, nVersionIn) {
+        int nVersionIn, RecvBufferPool &recv_pool = g_recv_buffer_pool)
+        : m_recv_pool(recv_pool), hdrbuf(nTypeIn, nVersionIn),
+          hdr(pchMessageStartIn), vRecv(nTypeIn, nVersionIn) {
         Reset();
     }
 
@@ -468,7 +622,14 @@ public:
     // Offset inside the first vSendMsg already sent.
     size_t nSendOffset{0};
     uint64_t nSendBytes GUARDED_BY(cs_vSend){0};
-    std::deque<std::vector<uint8_t>> vSendMsg GUARDED_BY(cs_vSend);
+    // Number of system calls used to send nSendBytes.
+    uint64_t nSendCalls GUARDED_BY(cs_vSend){0};
+    // Message headers and payloads to send, the payloads can be shared with
+    // the send queues of other nodes.
+    std::deque<std::shared_ptr<const std::vector<uint8_t>>>
+        vSendMsg GUARDED_BY(cs_vSend);
+    // Time at which the first message of vSendMsg was queued.
+    std::chrono::microseconds m_send_queue_since GUARDED_BY(cs_vSend){0};
     Mutex cs_vSend;
     Mutex cs_hSocket;
     Mutex cs_vRecv;
@@ -622,10 +783,9 @@ public:
         mutable RecursiveMutex cs_tx_inventory;
         CRollingBloomFilter filterInventoryKnown GUARDED_BY(cs_tx_inventory){
             50000, 0.000001};
-        // Set of transaction ids we still have to announce.
-        // They are sorted by the mempool before relay, so the order is not
-        // important.
-        std::set<TxId> setInventoryTxToSend GUARDED_BY(cs_tx_inventory);
+        // Sequence number of the next transaction to consider for
+        // announcement, from the batches shared by all the peers.
+        uint64_t m_next_tx_announcement GUARDED_BY(cs_tx_inventory){0};
         // Used for BIP35 mempool sending
         bool fSendMempool GUARDED_BY(cs_tx_inventory){false};
         // Last time a "MEMPOOL" request was serviced.
@@ -836,16 +996,6 @@ public:
         }
     }
 
-    void PushTxInventory(const TxId &txid) {
-        if (m_tx_relay == nullptr) {
-            return;
-        }
-        LOCK(m_tx_relay->cs_tx_inventory);
-        if (!m_tx_relay->filterInventoryKnown.contains(txid)) {
-            m_tx_relay->setInventoryTxToSend.insert(txid);
-        }
-    }
-
     void AddKnownProof(const avalanche::ProofId &proofid) {
         if (m_proof_relay != nullptr) {
             LOCK(m_proof_relay->cs_proof_inventory);
@@ -956,6 +1106,7 @@ public:
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
         bool m_i2p_accept_incoming = true;
+        bool m_priority_messages = DEFAULT_PRIORITY_MESSAGES;
     };
 
     void Init(const Options &connOptions) {
@@ -994,6 +1145,7 @@ public:
             vAddedNodes = connOptions.m_added_nodes;
         }
         m_onion_binds = connOptions.onion_binds;
+        m_priority_messages = connOptions.m_priority_messages;
     }
 
     CConnman(const Config &configIn, uint64_t seed0, uint64_t seed1,
@@ -1242,6 +1394,12 @@ private:
 
     size_t SocketSendData(CNode &node) const
         EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend);
+    /**
+     * Move the messages received from the node to its process queue. Once the
+     * handshake is complete, the high priority messages are queued after the
+     * high priority messages already waiting, ahead of the other ones.
+     */
+    void QueueReceivedMessages(CNode &node) const;
     void DumpAddresses();
 
     // Network stats
@@ -1280,6 +1438,12 @@ private:
     unsigned int nSendBufferMaxSize{0};
     unsigned int nReceiveFloodSize{0};
 
+    /**
+     * Whether the block relay messages and the avalanche responses are
+     * processed ahead of the other messages (-prioritymessages).
+     */
+    bool m_priority_messages{DEFAULT_PRIORITY_MESSAGES};
+
     std::vector<ListenSocket> vhListenSocket;
     std::atomic<bool> fNetworkActive{true};
     bool fAddressesInitialized{false};
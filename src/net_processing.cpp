@@ -14,13 +14,16 @@
 #include <avalanche/validation.h>
 #include <banman.h>
 #include <blockencodings.h>
+#include <blockreconciliation.h>
 #include <blockfilter.h>
 #include <blockvalidity.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <config.h>
 #include <consensus/amount.h>
+#include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <invrequest.h>
@@ -37,6 +40,7 @@
 #include <scheduler.h>
 #include <streams.h>
 #include <tinyformat.h>
+#include <txannouncement.h>
 #include <txmempool.h>
 #include <txorphanage.h>
 #include <util/check.h> // For NDEBUG compile time check
@@ -46,6 +50,7 @@
 #include <validation.h>
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <memory>
 #include <typeinfo>
@@ -184,9 +189,32 @@ static constexpr DataRequestParameters PROOF_REQUEST_PARAMS{
  */
 static const unsigned int MAX_GETDATA_SZ = 1000;
 /**
- * Number of blocks that can be requested at any given time from a single peer.
+ * Number of blocks that can be requested at any given time from a single peer,
+ * unless its window is sized from its measured throughput.
  */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
+/**
+ * Bounds of the adaptive block download window of a peer, see
+ * GetMaxBlocksInFlight().
+ */
+static const int MIN_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER = 1;
+static const int MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER = 64;
+/**
+ * How much data, in seconds of its measured throughput on top of its ping
+ * time, is kept in flight from a peer. This covers the round trip plus some
+ * slack for our own processing of the blocks.
+ */
+static constexpr auto BLOCK_DOWNLOAD_QUEUE_TIME = 2s;
+/**
+ * Weight of the past samples in the decaying averages of the block sizes and
+ * download times.
+ */
+static constexpr double BLOCK_DOWNLOAD_DECAY = 0.75;
+/**
+ * Minimum time a block must have been in flight before it is requested from
+ * a faster peer.
+ */
+static constexpr auto BLOCK_REASSIGN_MIN_DELAY = 1s;
 /**
  * Time during which a peer must stall block download progress before being
  * disconnected.
@@ -209,6 +237,13 @@ static const int MAX_CMPCTBLOCK_DEPTH = 5;
  * for.
  */
 static const int MAX_BLOCKTXN_DEPTH = 10;
+/**
+ * Largest requester mempool size, in transactions, that reconciled blocks are
+ * encoded for: a default sized mempool full of the smallest transactions.
+ * Larger values sent in GETRECONBLK are clamped.
+ */
+static constexpr uint64_t MAX_RECONBLOCK_MEMPOOL_SIZE{
+    DEFAULT_MAX_MEMPOOL_SIZE * ONE_MEGABYTE / MIN_TX_SIZE};
 /**
  * Size of the "block download window": how far ahead of our current height do
  * we fetch? Larger windows tolerate larger download speed differences between
@@ -257,6 +292,12 @@ static constexpr unsigned int INVENTORY_BROADCAST_PER_SECOND = 7;
 static constexpr unsigned int INVENTORY_BROADCAST_MAX_PER_MB =
     INVENTORY_BROADCAST_PER_SECOND *
     count_seconds(INBOUND_INVENTORY_BROADCAST_INTERVAL);
+/**
+ * Number of transactions kept in the shared announcement batches for the peers
+ * that did not get to announce them yet. That is about a minute worth of
+ * transactions at a thousand transactions per second.
+ */
+static constexpr size_t MAX_TX_ANNOUNCEMENT_QUEUE_SIZE = 60000;
 /** The number of most recently announced transactions a peer can request. */
 static constexpr unsigned int INVENTORY_MAX_RECENT_RELAY = 3500;
 /**
@@ -324,8 +365,12 @@ struct QueuedBlock {
     const CBlockIndex *pindex;
     /** Optional, used for CMPCTBLOCK downloads */
     std::unique_ptr<PartiallyDownloadedBlock> partialBlock;
+    /** When the block was requested */
+    std::chrono::microseconds m_time_requested{0us};
 };
 
+struct CNodeState;
+
 /**
  * Data structure for an individual peer. This struct is not protected by
  * cs_main since it does not contain validation-critical data.
@@ -398,8 +443,10 @@ struct Peer {
      *  address related message (ADDR, ADDRV2, GETADDR).
      *
      *  Presence of this filter must correlate with m_addr_relay_enabled.
+     *
+     *  Memory used: 31 KB
      **/
-    std::unique_ptr<CRollingBloomFilter> m_addr_known;
+    std::unique_ptr<CBlockedRollingBloomFilter> m_addr_known;
     /**
      * Whether we are participating in address relay with this connection.
      *
@@ -504,6 +551,8 @@ public:
                const CBlockIndex &block_index) override;
     bool GetNodeStateStats(NodeId nodeid,
                            CNodeStateStats &stats) const override;
+    std::map<std::string, MessageProcessingStats>
+    GetMessageProcessingStats() const override;
     bool IgnoresIncomingTxs() override { return m_ignore_incoming_txs; }
     void SendPings() override;
     void RelayTransaction(const TxId &txid) override;
@@ -687,6 +736,17 @@ private:
     /** Whether this node is running in blocks only mode */
     const bool m_ignore_incoming_txs;
 
+    /**
+     * Whether block download windows are sized from the peer throughput
+     * (-adaptiveblockdownload)
+     */
+    const bool m_adaptive_block_download{gArgs.GetBoolArg(
+        "-adaptiveblockdownload", DEFAULT_ADAPTIVE_BLOCK_DOWNLOAD)};
+
+    /** Whether blocks can be relayed by set reconciliation (-reconblockrelay) */
+    const bool m_recon_block_relay{
+        gArgs.GetBoolArg("-reconblockrelay", DEFAULT_RECON_BLOCK_RELAY)};
+
     /**
      * Whether we've completed initial sync yet, for determining when to turn
      * on extra block-relay-only peers.
@@ -740,18 +800,21 @@ private:
      * million to make it highly unlikely for users to have issues with this
      * filter.
      *
-     * Memory used: 1.3 MB
+     * Memory used: 2.3 MB
      */
-    std::unique_ptr<CRollingBloomFilter> recentRejects GUARDED_BY(cs_main);
+    std::unique_ptr<CBlockedRollingBloomFilter>
+        recentRejects GUARDED_BY(cs_main);
     uint256 hashRecentRejectsChainTip GUARDED_BY(cs_main);
 
     /**
      * Filter for transactions that have been recently confirmed.
      * We use this to avoid requesting transactions that have already been
      * confirmed.
+     *
+     * Memory used: 464 KB
      */
     mutable Mutex m_recent_confirmed_transactions_mutex;
-    std::unique_ptr<CRollingBloomFilter> m_recent_confirmed_transactions
+    std::unique_ptr<CBlockedRollingBloomFilter> m_recent_confirmed_transactions
         GUARDED_BY(m_recent_confirmed_transactions_mutex);
 
     /** Have we requested this block from a peer */
@@ -788,6 +851,35 @@ private:
                                   NodeId &nodeStaller)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Add to vBlocks, until it has at most count entries, the blocks at the
+     * start of the download window that are in flight from other measured
+     * peers and that this peer would deliver significantly faster. Blocks
+     * with a partially downloaded compact block are never taken over.
+     */
+    void FindLateBlocksToDownload(NodeId nodeid, unsigned int count,
+                                  std::vector<const CBlockIndex *> &vBlocks)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Update the throughput estimate of a peer with a block it sent us, if
+     * that block was the first one it had in flight.
+     */
+    void RecordBlockDownload(NodeId nodeid, const BlockHash &hash,
+                             size_t block_size)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Number of blocks that can be in flight from a peer: enough to keep its
+     * link busy given its measured throughput and ping time, or
+     * MAX_BLOCKS_IN_TRANSIT_PER_PEER until it is measured.
+     */
+    int GetMaxBlocksInFlight(const CNodeState &state) const
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /** Decaying average size of the blocks downloaded from our peers */
+    double m_avg_block_size GUARDED_BY(cs_main){0};
+
     std::map<BlockHash, std::pair<NodeId, std::list<QueuedBlock>::iterator>>
         mapBlocksInFlight GUARDED_BY(cs_main);
 
@@ -813,6 +905,21 @@ private:
                       const std::shared_ptr<const CBlock> &block,
                       bool force_processing);
 
+    mutable Mutex m_message_stats_mutex;
+    //! Processing time statistics, by message type. The unknown message types
+    //! are accounted for as NET_MESSAGE_COMMAND_OTHER.
+    std::map<std::string, MessageProcessingStats>
+        m_message_stats GUARDED_BY(m_message_stats_mutex);
+
+    void RecordMessageProcessing(const std::string &msg_type,
+                                 std::chrono::microseconds processing_time,
+                                 std::chrono::microseconds cs_main_time,
+                                 std::chrono::microseconds queue_time)
+        LOCKS_EXCLUDED(m_message_stats_mutex);
+
+    //! Relayed transactions, announced to all the peers in shared batches
+    TxAnnouncementQueue m_tx_announcements{MAX_TX_ANNOUNCEMENT_QUEUE_SIZE};
+
     /** Relay map. */
     typedef std::map<TxId, CTransactionRef> MapRelay;
     MapRelay mapRelay GUARDED_BY(cs_main);
@@ -1038,6 +1145,14 @@ struct CNodeState {
     //! when vBlocksInFlight is empty.
     std::chrono::microseconds m_downloading_since{0us};
     int nBlocksInFlight;
+    /**
+     * Decaying sums of the sizes and download times of the blocks received
+     * from this peer, the ratio of which is its block download throughput.
+     */
+    double m_block_download_bytes{0};
+    double m_block_download_seconds{0};
+    //! Minimum ping time to this peer, as of the last SendMessages().
+    std::chrono::microseconds m_min_ping_time{0us};
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload;
     //! Whether this peer wants invs or headers (when possible) for block
@@ -1059,6 +1174,11 @@ struct CNodeState {
      * non-witnesses in cmpctblocks/blocktxns.
      */
     bool fSupportsDesiredCmpctVersion;
+    /**
+     * Whether both this peer and us relay blocks via set reconciliation, so
+     * that we request "reconblock" rather than "cmpctblock" from it.
+     */
+    bool m_supports_recon_blocks;
 
     /**
      * State used to enforce CHAIN_SYNC_TIMEOUT and EXTRA_PEER_CHECK_INTERVAL
@@ -1113,9 +1233,13 @@ struct CNodeState {
     //! Whether this peer is an inbound connection
     bool m_is_inbound;
 
-    //! A rolling bloom filter of all announced tx CInvs to this peer.
-    CRollingBloomFilter m_recently_announced_invs =
-        CRollingBloomFilter{INVENTORY_MAX_RECENT_RELAY, 0.000001};
+    /**
+     * A rolling bloom filter of all announced tx CInvs to this peer.
+     *
+     * Memory used: 67 KB
+     */
+    CBlockedRollingBloomFilter m_recently_announced_invs =
+        CBlockedRollingBloomFilter{INVENTORY_MAX_RECENT_RELAY, 0.000001};
 
     //! A rolling bloom filter of all announced Proofs CInvs to this peer.
     CRollingBloomFilter m_recently_announced_proofs =
@@ -1135,6 +1259,7 @@ struct CNodeState {
         fPreferHeaderAndIDs = false;
         fProvidesHeaderAndIDs = false;
         fSupportsDesiredCmpctVersion = false;
+        m_supports_recon_blocks = false;
         m_chain_sync = {0, nullptr, false, false};
         m_last_block_announcement = 0;
         m_recently_announced_invs.reset();
@@ -1259,15 +1384,17 @@ bool PeerManagerImpl::BlockRequested(const Config &config, NodeId nodeid,
     // Make sure it's not listed somewhere already.
     RemoveBlockRequest(hash);
 
+    const auto now = GetTime<std::chrono::microseconds>();
     std::list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(
         state->vBlocksInFlight.end(),
-        {&block, std::unique_ptr<PartiallyDownloadedBlock>(
-                     pit ? new PartiallyDownloadedBlock(config, &m_mempool)
-                         : nullptr)});
+        {&block,
+         std::unique_ptr<PartiallyDownloadedBlock>(
+             pit ? new PartiallyDownloadedBlock(config, &m_mempool) : nullptr),
+         now});
     state->nBlocksInFlight++;
     if (state->nBlocksInFlight == 1) {
         // We're starting a block download (batch) from this peer.
-        state->m_downloading_since = GetTime<std::chrono::microseconds>();
+        state->m_downloading_since = now;
         m_peers_downloading_from++;
     }
 
@@ -1282,6 +1409,60 @@ bool PeerManagerImpl::BlockRequested(const Config &config, NodeId nodeid,
     return true;
 }
 
+void PeerManagerImpl::RecordBlockDownload(NodeId nodeid,
+                                          const BlockHash &hash,
+                                          size_t block_size) {
+    auto it = mapBlocksInFlight.find(hash);
+    if (it == mapBlocksInFlight.end() || it->second.first != nodeid) {
+        return;
+    }
+
+    CNodeState *state = State(nodeid);
+    assert(state != nullptr);
+
+    // Blocks are sent in the order they are requested, so only the first
+    // block in the queue has been downloading since m_downloading_since.
+    if (it->second.second != state->vBlocksInFlight.begin()) {
+        return;
+    }
+
+    const SecondsDouble elapsed{GetTime<std::chrono::microseconds>() -
+                                state->m_downloading_since};
+    state->m_block_download_bytes =
+        BLOCK_DOWNLOAD_DECAY * state->m_block_download_bytes + block_size;
+    state->m_block_download_seconds =
+        BLOCK_DOWNLOAD_DECAY * state->m_block_download_seconds +
+        std::max(CountSecondsDouble(elapsed), 0.001);
+
+    m_avg_block_size =
+        m_avg_block_size == 0
+            ? block_size
+            : BLOCK_DOWNLOAD_DECAY * m_avg_block_size +
+                  (1 - BLOCK_DOWNLOAD_DECAY) * block_size;
+}
+
+/** Block download throughput of a peer in bytes per second, or 0 if unknown */
+static double GetBlockDownloadRate(const CNodeState &state) {
+    return state.m_block_download_seconds > 0
+               ? state.m_block_download_bytes / state.m_block_download_seconds
+               : 0;
+}
+
+int PeerManagerImpl::GetMaxBlocksInFlight(const CNodeState &state) const {
+    const double rate = GetBlockDownloadRate(state);
+    if (!m_adaptive_block_download || rate == 0 || m_avg_block_size == 0) {
+        return MAX_BLOCKS_IN_TRANSIT_PER_PEER;
+    }
+
+    // Keep the link busy for the round trip plus the queue time.
+    const double window_bytes =
+        rate * CountSecondsDouble(state.m_min_ping_time +
+                                  BLOCK_DOWNLOAD_QUEUE_TIME);
+    return std::clamp<double>(std::ceil(window_bytes / m_avg_block_size),
+                              MIN_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER,
+                              MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER);
+}
+
 void PeerManagerImpl::MaybeSetPeerAsAnnouncingHeaderAndIDs(NodeId nodeid) {
     AssertLockHeld(cs_main);
     CNodeState *nodestate = State(nodeid);
@@ -1292,6 +1473,11 @@ void PeerManagerImpl::MaybeSetPeerAsAnnouncingHeaderAndIDs(NodeId nodeid) {
     if (!nodestate->fProvidesHeaderAndIDs) {
         return;
     }
+    if (nodestate->m_supports_recon_blocks) {
+        // We'd rather reconcile the blocks this peer announces with a header
+        // than have it push the larger cmpctblock to us.
+        return;
+    }
     for (std::list<NodeId>::iterator it = lNodesAnnouncingHeaderAndIDs.begin();
          it != lNodesAnnouncingHeaderAndIDs.end(); it++) {
         if (*it == nodeid) {
@@ -1504,6 +1690,95 @@ void PeerManagerImpl::FindNextBlocksToDownload(
     }
 }
 
+void PeerManagerImpl::FindLateBlocksToDownload(
+    NodeId nodeid, unsigned int count,
+    std::vector<const CBlockIndex *> &vBlocks) {
+    if (count == 0) {
+        return;
+    }
+
+    CNodeState *state = State(nodeid);
+    assert(state != nullptr);
+
+    const double rate = GetBlockDownloadRate(*state);
+    if (rate == 0 || m_avg_block_size == 0 ||
+        state->pindexBestKnownBlock == nullptr ||
+        state->pindexLastCommonBlock == nullptr) {
+        return;
+    }
+
+    // Only the start of the window is considered, as these are the blocks
+    // that hold back the validation of the others.
+    const int nStartHeight = state->pindexLastCommonBlock->nHeight;
+    const int nMaxHeight =
+        std::min(state->pindexBestKnownBlock->nHeight,
+                 nStartHeight + MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER);
+    if (nMaxHeight <= nStartHeight) {
+        return;
+    }
+    std::vector<const CBlockIndex *> vToCheck(nMaxHeight - nStartHeight);
+    vToCheck.back() = state->pindexBestKnownBlock->GetAncestor(nMaxHeight);
+    for (size_t i = vToCheck.size() - 1; i > 0; i--) {
+        vToCheck[i - 1] = vToCheck[i]->pprev;
+    }
+
+    const auto now = GetTime<std::chrono::microseconds>();
+    const auto download_time = [&](double rate_in, size_t blocks) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            SecondsDouble{blocks * m_avg_block_size / rate_in});
+    };
+    // Time it would take this peer to deliver one more block
+    const auto our_time = state->m_min_ping_time +
+                          download_time(rate, state->nBlocksInFlight + 1);
+
+    const size_t max_size = vBlocks.size() + count;
+    for (const CBlockIndex *pindex : vToCheck) {
+        auto it = mapBlocksInFlight.find(pindex->GetBlockHash());
+        if (it == mapBlocksInFlight.end() || it->second.first == nodeid) {
+            continue;
+        }
+
+        CNodeState *other = State(it->second.first);
+        assert(other != nullptr);
+        const auto list_it = it->second.second;
+        // A block being reconstructed from a compact or reconciled block is
+        // left alone, reassigning it would throw away the partial block.
+        if (list_it->partialBlock) {
+            continue;
+        }
+        const auto in_flight = now - list_it->m_time_requested;
+        if (in_flight < BLOCK_REASSIGN_MIN_DELAY || in_flight < 2 * our_time) {
+            continue;
+        }
+
+        // Without a throughput estimate there is nothing to tell the other
+        // peer is slow, the stalling logic takes care of it instead.
+        const double other_rate = GetBlockDownloadRate(*other);
+        if (other_rate == 0) {
+            continue;
+        }
+
+        // Estimate when the other peer should deliver the block, given the
+        // blocks that are queued before it.
+        const size_t position =
+            std::distance(other->vBlocksInFlight.begin(), list_it) + 1;
+        const auto expected = other->m_downloading_since +
+                              other->m_min_ping_time +
+                              download_time(other_rate, position);
+        // Leave the block alone unless it is overdue or we would get it at
+        // least twice as fast.
+        if (now < expected + (expected - list_it->m_time_requested) &&
+            expected - now < 2 * our_time) {
+            continue;
+        }
+
+        vBlocks.push_back(pindex);
+        if (vBlocks.size() >= max_size) {
+            return;
+        }
+    }
+}
+
 } // namespace
 
 template <class InvId>
@@ -1644,6 +1919,12 @@ void PeerManagerImpl::InitializeNode(const Config &config, CNode *pnode) {
         LOCK(m_peer_mutex);
         m_peer_map.emplace_hint(m_peer_map.end(), nodeid, std::move(peer));
     }
+    if (pnode->m_tx_relay != nullptr) {
+        // Only the transactions relayed from now on are announced.
+        LOCK(pnode->m_tx_relay->cs_tx_inventory);
+        pnode->m_tx_relay->m_next_tx_announcement =
+            m_tx_announcements.GetNextSequence();
+    }
     if (!pnode->IsInboundConn()) {
         PushNodeVersion(config, *pnode, GetTime());
     }
@@ -2135,7 +2416,7 @@ PeerManagerImpl::PeerManagerImpl(const CChainParams &chainparams,
       m_banman(banman), m_chainman(chainman), m_mempool(pool),
       m_stale_tip_check_time(0), m_ignore_incoming_txs(ignore_incoming_txs) {
     // Initialize global variables that cannot be constructed at startup.
-    recentRejects.reset(new CRollingBloomFilter(120000, 0.000001));
+    recentRejects.reset(new CBlockedRollingBloomFilter(120000, 0.000001));
 
     {
         LOCK(cs_invalidProofs);
@@ -2151,7 +2432,13 @@ PeerManagerImpl::PeerManagerImpl(const CChainParams &chainparams,
     // transaction per day that would be inadvertently ignored (which is the
     // same probability that we have in the reject filter).
     m_recent_confirmed_transactions.reset(
-        new CRollingBloomFilter(24000, 0.000001));
+        new CBlockedRollingBloomFilter(24000, 0.000001));
+
+    LOCK(m_message_stats_mutex);
+    for (const std::string &msg_type : getAllNetMessageTypes()) {
+        m_message_stats[msg_type];
+    }
+    m_message_stats[NET_MESSAGE_COMMAND_OTHER];
 }
 
 void PeerManagerImpl::StartScheduledTasks(CScheduler &scheduler) {
@@ -2234,6 +2521,9 @@ static std::shared_ptr<const CBlock>
 static std::shared_ptr<const CBlockHeaderAndShortTxIDs>
     most_recent_compact_block GUARDED_BY(cs_most_recent_block);
 static uint256 most_recent_block_hash GUARDED_BY(cs_most_recent_block);
+//! BLOCK message payload of most_recent_block, serialized on first request
+static std::shared_ptr<const SharedNetPayload>
+    most_recent_block_payload GUARDED_BY(cs_most_recent_block);
 
 /**
  * Maintain state about the best-seen block and fast-announce a compact block
@@ -2244,6 +2534,9 @@ void PeerManagerImpl::NewPoWValidBlock(
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> pcmpctblock =
         std::make_shared<const CBlockHeaderAndShortTxIDs>(*pblock);
     const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    // The compact block is serialized once, for the first peer it is
+    // announced to, and shared with the other ones.
+    std::shared_ptr<const SharedNetPayload> cmpctblock_payload;
 
     LOCK(cs_main);
 
@@ -2260,14 +2553,14 @@ void PeerManagerImpl::NewPoWValidBlock(
         most_recent_block_hash = hashBlock;
         most_recent_block = pblock;
         most_recent_compact_block = pcmpctblock;
+        most_recent_block_payload.reset();
     }
 
     m_connman.ForEachNode(
-        [this, &pcmpctblock, pindex, &msgMaker,
+        [this, &cmpctblock_payload, &pcmpctblock, &msgMaker, pindex,
          &hashBlock](CNode *pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
             AssertLockHeld(::cs_main);
 
-            // TODO: Avoid the repeated-serialization here
             if (pnode->GetCommonVersion() < INVALID_CB_NO_BAN_VERSION ||
                 pnode->fDisconnect) {
                 return;
@@ -2283,8 +2576,15 @@ void PeerManagerImpl::NewPoWValidBlock(
                          "%s sending header-and-ids %s to peer=%d\n",
                          "PeerManager::NewPoWValidBlock", hashBlock.ToString(),
                          pnode->GetId());
+                if (!cmpctblock_payload) {
+                    cmpctblock_payload =
+                        std::make_shared<const SharedNetPayload>(
+                            msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock)
+                                .data);
+                }
                 m_connman.PushMessage(
-                    pnode, msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
+                    pnode, CSerializedNetMsg(NetMsgType::CMPCTBLOCK,
+                                             cmpctblock_payload));
                 state.pindexBestHeaderSent = pindex;
             }
         });
@@ -2429,8 +2729,9 @@ void PeerManagerImpl::SendPings() {
 }
 
 void PeerManagerImpl::RelayTransaction(const TxId &txid) {
-    m_connman.ForEachNode(
-        [&txid](CNode *pnode) { pnode->PushTxInventory(txid); });
+    // The transaction is sorted along with the others relayed during the same
+    // interval, then each peer picks it up on its next inventory trickle.
+    m_tx_announcements.Add(txid);
 }
 
 void PeerManagerImpl::RelayProof(const avalanche::ProofId &proofid) {
@@ -2596,7 +2897,36 @@ void PeerManagerImpl::ProcessGetBlockData(const Config &config, CNode &pfrom,
             }
             pblock = pblockRead;
         }
-        if (inv.IsMsgBlk()) {
+        if (inv.IsMsgBlk() && pblock == a_recent_block) {
+            // The most recent block is typically requested by many peers, so
+            // it is only serialized once. The serialization and hashing are
+            // done without holding cs_most_recent_block.
+            std::shared_ptr<const SharedNetPayload> payload;
+            bool is_most_recent;
+            {
+                LOCK(cs_most_recent_block);
+                is_most_recent = most_recent_block == pblock;
+                if (is_most_recent) {
+                    payload = most_recent_block_payload;
+                }
+            }
+            if (is_most_recent && !payload) {
+                payload = std::make_shared<const SharedNetPayload>(
+                    msgMaker.Make(NetMsgType::BLOCK, *pblock).data);
+                LOCK(cs_most_recent_block);
+                if (most_recent_block == pblock) {
+                    if (most_recent_block_payload) {
+                        // Another peer got there first
+                        payload = most_recent_block_payload;
+                    } else {
+                        most_recent_block_payload = payload;
+                    }
+                }
+            }
+            connman.PushMessage(
+                &pfrom, payload ? CSerializedNetMsg(NetMsgType::BLOCK, payload)
+                                : msgMaker.Make(NetMsgType::BLOCK, *pblock));
+        } else if (inv.IsMsgBlk()) {
             connman.PushMessage(&pfrom,
                                 msgMaker.Make(NetMsgType::BLOCK, *pblock));
         } else if (inv.IsMsgFilteredBlk()) {
@@ -3040,7 +3370,8 @@ void PeerManagerImpl::ProcessHeadersMessage(
             // a limit.
             while (pindexWalk &&
                    !m_chainman.ActiveChain().Contains(pindexWalk) &&
-                   vToFetch.size() <= MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+                   vToFetch.size() <=
+                       size_t(GetMaxBlocksInFlight(*nodestate))) {
                 if (!pindexWalk->nStatus.hasData() &&
                     !IsBlockRequested(pindexWalk->GetBlockHash())) {
                     // We don't have this block, and it's not yet in flight.
@@ -3061,7 +3392,7 @@ void PeerManagerImpl::ProcessHeadersMessage(
                 // Download as much as possible, from earliest to latest.
                 for (const CBlockIndex *pindex : reverse_iterate(vToFetch)) {
                     if (nodestate->nBlocksInFlight >=
-                        MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+                        GetMaxBlocksInFlight(*nodestate)) {
                         // Can't download any more from this peer
                         break;
                     }
@@ -3084,9 +3415,25 @@ void PeerManagerImpl::ProcessHeadersMessage(
                         // In any case, we want to download using a compact
                         // block, not a regular one.
                         vGetData[0] = CInv(MSG_CMPCT_BLOCK, vGetData[0].hash);
+
+                        if (nodestate->m_supports_recon_blocks) {
+                            // Even better, reconcile it against our mempool.
+                            // The peer falls back to a compact block if it
+                            // can't.
+                            BlockReconciliationRequest req;
+                            req.blockhash = BlockHash(vGetData[0].hash);
+                            req.mempool_size = m_mempool.size();
+                            m_connman.PushMessage(
+                                &pfrom,
+                                msgMaker.Make(NetMsgType::GETRECONBLK, req));
+                            vGetData.clear();
+                        }
+                    }
+                    if (!vGetData.empty()) {
+                        m_connman.PushMessage(
+                            &pfrom,
+                            msgMaker.Make(NetMsgType::GETDATA, vGetData));
                     }
-                    m_connman.PushMessage(
-                        &pfrom, msgMaker.Make(NetMsgType::GETDATA, vGetData));
                 }
             }
         }
@@ -3824,6 +4171,11 @@ void PeerManagerImpl::ProcessMessage(
                                   msgMaker.Make(NetMsgType::SENDCMPCT,
                                                 fAnnounceUsingCMPCTBLOCK,
                                                 nCMPCTBLOCKVersion));
+
+            if (m_recon_block_relay) {
+                m_connman.PushMessage(&pfrom,
+                                      msgMaker.Make(NetMsgType::SENDRECONBLK));
+            }
         }
 
         if (g_avalanche && isAvalancheEnabled(gArgs)) {
@@ -4016,6 +4368,14 @@ void PeerManagerImpl::ProcessMessage(
         return;
     }
 
+    if (msg_type == NetMsgType::SENDRECONBLK) {
+        if (m_recon_block_relay) {
+            LOCK(cs_main);
+            State(pfrom.GetId())->m_supports_recon_blocks = true;
+        }
+        return;
+    }
+
     if (msg_type == NetMsgType::INV) {
         std::vector<CInv> vInv;
         vRecv >> vInv;
@@ -4304,6 +4664,52 @@ void PeerManagerImpl::ProcessMessage(
         return;
     }
 
+    if (msg_type == NetMsgType::GETRECONBLK) {
+        BlockReconciliationRequest req;
+        vRecv >> req;
+
+        std::shared_ptr<const CBlock> recent_block;
+        std::shared_ptr<const CBlockHeaderAndShortTxIDs> recent_compact_block;
+        {
+            LOCK(cs_most_recent_block);
+            if (most_recent_block_hash == req.blockhash) {
+                recent_block = most_recent_block;
+                recent_compact_block = most_recent_compact_block;
+            }
+        }
+
+        // The receiver can only recover the transaction order of a
+        // canonically ordered block.
+        if (recent_block &&
+            std::is_sorted(recent_block->vtx.begin() + 1,
+                           recent_block->vtx.end(),
+                           [](const CTransactionRef &a,
+                              const CTransactionRef &b) {
+                               return a->GetId() < b->GetId();
+                           })) {
+            // The encoding is sized from the peer-provided mempool size.
+            const CBlockHeaderAndReconciliation reconblock(
+                *recent_compact_block,
+                std::min(req.mempool_size, MAX_RECONBLOCK_MEMPOOL_SIZE));
+            // Don't bother if it's not smaller than the compact block.
+            if (GetSerializeSize(reconblock, PROTOCOL_VERSION) <
+                GetSerializeSize(*recent_compact_block, PROTOCOL_VERSION)) {
+                m_connman.PushMessage(
+                    &pfrom, msgMaker.Make(NetMsgType::RECONBLOCK, reconblock));
+                return;
+            }
+        }
+
+        // Serve the block as if a compact block was requested instead, which
+        // falls back to a full block for old blocks.
+        CInv inv(MSG_CMPCT_BLOCK, req.blockhash);
+        WITH_LOCK(peer->m_getdata_requests_mutex,
+                  peer->m_getdata_requests.push_back(inv));
+        // The message processing loop will go around again (without pausing)
+        // and we'll respond then (without cs_main)
+        return;
+    }
+
     if (msg_type == NetMsgType::GETHEADERS) {
         CBlockLocator locator;
         BlockHash hashStop;
@@ -4675,8 +5081,9 @@ void PeerManagerImpl::ProcessMessage(
             // We want to be a bit conservative just to be extra careful about
             // DoS possibilities in compact block processing...
             if (pindex->nHeight <= m_chainman.ActiveChain().Height() + 2) {
-                if ((!fAlreadyInFlight && nodestate->nBlocksInFlight <
-                                              MAX_BLOCKS_IN_TRANSIT_PER_PEER) ||
+                if ((!fAlreadyInFlight &&
+                     nodestate->nBlocksInFlight <
+                         GetMaxBlocksInFlight(*nodestate)) ||
                     (fAlreadyInFlight &&
                      blockInFlightIt->second.first == pfrom.GetId())) {
                     std::list<QueuedBlock>::iterator *queuedBlockIt = nullptr;
@@ -4818,6 +5225,81 @@ void PeerManagerImpl::ProcessMessage(
         return;
     }
 
+    if (msg_type == NetMsgType::RECONBLOCK) {
+        // Ignore reconblock received while importing
+        if (fImporting || fReindex) {
+            LogPrint(BCLog::NET,
+                     "Unexpected reconblock message received from peer %d\n",
+                     pfrom.GetId());
+            return;
+        }
+
+        CBlockHeaderAndReconciliation reconblock;
+        try {
+            vRecv >> reconblock;
+        } catch (std::ios_base::failure &e) {
+            Misbehaving(pfrom, 100, "reconblock-bad-indexes");
+            return;
+        }
+
+        const BlockHash blockhash = reconblock.GetHeader().GetHash();
+        {
+            LOCK(cs_main);
+            auto it = mapBlocksInFlight.find(blockhash);
+            if (it == mapBlocksInFlight.end() ||
+                it->second.first != pfrom.GetId()) {
+                // We only request reconblocks for headers we already have.
+                LogPrint(BCLog::NET,
+                         "Peer %d sent us a reconciled block we weren't "
+                         "expecting\n",
+                         pfrom.GetId());
+                return;
+            }
+        }
+
+        // Reconcile without holding cs_main, this might have to go through the
+        // whole mempool.
+        const std::vector<std::pair<TxHash, CTransactionRef>> extra_txn =
+            WITH_LOCK(g_cs_orphans, return vExtraTxnForCompact);
+        std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+        const ReadStatus status =
+            reconblock.FillBlock(config, m_mempool, extra_txn, *pblock);
+
+        if (status == READ_STATUS_INVALID) {
+            // Reset in-flight state in case Misbehaving does not result in a
+            // disconnect.
+            WITH_LOCK(cs_main, RemoveBlockRequest(blockhash));
+            Misbehaving(pfrom, 100, "invalid reconciled block");
+            return;
+        }
+
+        if (status == READ_STATUS_FAILED) {
+            // We are likely missing some of the transactions, let the compact
+            // block logic request them. The block is still in flight from this
+            // peer so the cmpctblock will be accepted.
+            LogPrint(BCLog::CMPCTBLOCK,
+                     "Failed to reconcile block %s from peer %d, requesting a "
+                     "compact block\n",
+                     blockhash.ToString(), pfrom.GetId());
+            std::vector<CInv> invs;
+            invs.push_back(CInv(MSG_CMPCT_BLOCK, blockhash));
+            m_connman.PushMessage(&pfrom,
+                                  msgMaker.Make(NetMsgType::GETDATA, invs));
+            return;
+        }
+
+        // The block is either okay or failed CheckBlock, which gets the same
+        // treatment as with BLOCKTXN.
+        {
+            LOCK(cs_main);
+            RemoveBlockRequest(blockhash);
+            mapBlockSource.emplace(blockhash,
+                                   std::make_pair(pfrom.GetId(), false));
+        }
+        ProcessBlock(config, pfrom, pblock, /*force_processing=*/true);
+        return;
+    }
+
     if (msg_type == NetMsgType::BLOCKTXN) {
         // Ignore blocktxn received while importing
         if (fImporting || fReindex) {
@@ -4950,8 +5432,18 @@ void PeerManagerImpl::ProcessMessage(
             return;
         }
 
+        const size_t block_size = vRecv.size();
+        // The transactions we already have in the mempool are shared with the
+        // block instead of being deserialized again.
         std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-        vRecv >> *pblock;
+        UnserializeBlock(vRecv, *pblock,
+                         [this](const std::vector<TxId> &txids,
+                                std::vector<CTransactionRef> &txs) {
+                             LOCK(m_mempool.cs);
+                             for (size_t i = 0; i < txids.size(); i++) {
+                                 txs[i] = m_mempool.get(txids[i]);
+                             }
+                         });
 
         LogPrint(BCLog::NET, "received block %s peer=%d\n",
                  pblock->GetHash().ToString(), pfrom.GetId());
@@ -4969,6 +5461,7 @@ void PeerManagerImpl::ProcessMessage(
             // Always process the block if we requested it, since we may
             // need it even when it's not a candidate for a new best tip.
             forceProcessing = IsBlockRequested(hash);
+            RecordBlockDownload(pfrom.GetId(), hash, block_size);
             RemoveBlockRequest(hash);
             // mapBlockSource is only used for punishing peers and setting
             // which peers send us compact blocks, so the race between here and
@@ -5793,7 +6286,7 @@ void PeerManagerImpl::ProcessMessage(
         // A peer might send up to 1 notfound per getdata request, but no more
         if (vInv.size() <= PROOF_REQUEST_PARAMS.max_peer_announcements +
                                TX_REQUEST_PARAMS.max_peer_announcements +
-                               MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+                               MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER) {
             for (CInv &inv : vInv) {
                 if (inv.IsMsgTx()) {
                     // If we receive a NOTFOUND message for a tx we requested,
@@ -5989,6 +6482,12 @@ bool PeerManagerImpl::ProcessMessages(const Config &config, CNode *pfrom,
         return fMoreWork;
     }
 
+    const auto queue_time = std::max(
+        GetTime<std::chrono::microseconds>() - msg.m_time,
+        std::chrono::microseconds{0});
+    const auto processing_start = std::chrono::steady_clock::now();
+    LockHoldTimer cs_main_timer{&cs_main};
+
     try {
         ProcessMessage(config, *pfrom, msg_type, vRecv, msg.m_time,
                        interruptMsgProc);
@@ -6011,9 +6510,46 @@ bool PeerManagerImpl::ProcessMessages(const Config &config, CNode *pfrom,
                  __func__, SanitizeString(msg_type), nMessageSize);
     }
 
+    const auto processing_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - processing_start);
+    RecordMessageProcessing(msg_type, processing_time,
+                            cs_main_timer.GetHeldTime(), queue_time);
+
+    TRACE6(net, processed_message, pfrom->GetId(), msg_type.c_str(),
+           nMessageSize, processing_time.count(),
+           cs_main_timer.GetHeldTime().count(), queue_time.count());
+
     return fMoreWork;
 }
 
+void PeerManagerImpl::RecordMessageProcessing(
+    const std::string &msg_type, std::chrono::microseconds processing_time,
+    std::chrono::microseconds cs_main_time,
+    std::chrono::microseconds queue_time) {
+    LOCK(m_message_stats_mutex);
+    auto it = m_message_stats.find(msg_type);
+    if (it == m_message_stats.end()) {
+        it = m_message_stats.find(NET_MESSAGE_COMMAND_OTHER);
+    }
+    MessageProcessingStats &stats = it->second;
+
+    ++stats.count;
+    stats.total_time += processing_time;
+    stats.max_time = std::max(stats.max_time, processing_time);
+    stats.cs_main_time += cs_main_time;
+    stats.queue_time += queue_time;
+    ++stats.time_histogram[std::min<uint64_t>(
+        CountBits(processing_time.count()),
+        MessageProcessingStats::NUM_TIME_BUCKETS - 1)];
+}
+
+std::map<std::string, MessageProcessingStats>
+PeerManagerImpl::GetMessageProcessingStats() const {
+    LOCK(m_message_stats_mutex);
+    return m_message_stats;
+}
+
 void PeerManagerImpl::ConsiderEviction(CNode &pto, int64_t time_in_seconds) {
     AssertLockHeld(cs_main);
 
@@ -6462,23 +6998,6 @@ void PeerManagerImpl::MaybeSendFeefilter(
     }
 }
 
-namespace {
-class CompareInvMempoolOrder {
-    CTxMemPool *mp;
-
-public:
-    explicit CompareInvMempoolOrder(CTxMemPool *_mempool) { mp = _mempool; }
-
-    bool operator()(std::set<TxId>::iterator a, std::set<TxId>::iterator b) {
-        /**
-         * As std::make_heap produces a max-heap, we want the entries with the
-         * fewest ancestors/highest fee to sort later.
-         */
-        return mp->CompareDepthAndScore(*b, *a);
-    }
-};
-} // namespace
-
 bool PeerManagerImpl::SetupAddressRelay(CNode &node, Peer &peer) {
     // We don't participate in addr relay with outbound block-relay-only
     // connections to prevent providing adversaries with the additional
@@ -6490,7 +7009,8 @@ bool PeerManagerImpl::SetupAddressRelay(CNode &node, Peer &peer) {
     if (!peer.m_addr_relay_enabled.exchange(true)) {
         // First addr message we have received from the peer, initialize
         // m_addr_known
-        peer.m_addr_known = std::make_unique<CRollingBloomFilter>(5000, 0.001);
+        peer.m_addr_known =
+            std::make_unique<CBlockedRollingBloomFilter>(5000, 0.001);
     }
 
     return true;
@@ -6855,7 +7375,8 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
             if (fSendTrickle) {
                 LOCK(pto->m_tx_relay->cs_filter);
                 if (!pto->m_tx_relay->fRelayTxes) {
-                    pto->m_tx_relay->setInventoryTxToSend.clear();
+                    pto->m_tx_relay->m_next_tx_announcement =
+                        m_tx_announcements.GetNextSequence();
                 }
             }
 
@@ -6873,7 +7394,6 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
 
                 for (const auto &txinfo : vtxinfo) {
                     const TxId &txid = txinfo.tx->GetId();
-                    pto->m_tx_relay->setInventoryTxToSend.erase(txid);
                     // Don't send transactions that peers will not put into
                     // their mempool
                     if (txinfo.fee < filterrate.GetFee(txinfo.vsize)) {
@@ -6896,82 +7416,79 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
 
             // Determine transactions to relay
             if (fSendTrickle) {
-                // Produce a vector with all candidates for sending
-                std::vector<std::set<TxId>::iterator> vInvTx;
-                vInvTx.reserve(pto->m_tx_relay->setInventoryTxToSend.size());
-                for (std::set<TxId>::iterator it =
-                         pto->m_tx_relay->setInventoryTxToSend.begin();
-                     it != pto->m_tx_relay->setInventoryTxToSend.end(); it++) {
-                    vInvTx.push_back(it);
-                }
+                uint64_t &next_tx = pto->m_tx_relay->m_next_tx_announcement;
+                // The batches are shared by all the peers, so the transactions
+                // are only sorted once. They are sorted topologically and by
+                // fee rate for privacy and priority reasons.
+                const std::vector<std::shared_ptr<const TxAnnouncementBatch>>
+                    batches = m_tx_announcements.GetBatches(next_tx, m_mempool);
                 CFeeRate filterrate;
                 {
                     LOCK(pto->m_tx_relay->cs_feeFilter);
                     filterrate = CFeeRate(pto->m_tx_relay->minFeeFilter);
                 }
-                // Topologically and fee-rate sort the inventory we send for
-                // privacy and priority reasons. A heap is used so that not
-                // all items need sorting if only a few are being sent.
-                CompareInvMempoolOrder compareInvMempoolOrder(&m_mempool);
-                std::make_heap(vInvTx.begin(), vInvTx.end(),
-                               compareInvMempoolOrder);
                 // No reason to drain out at many times the network's
                 // capacity, especially since we have many peers and some
                 // will draw much shorter delays.
                 unsigned int nRelayedTransactions = 0;
-                LOCK(pto->m_tx_relay->cs_filter);
-                while (!vInvTx.empty() &&
-                       nRelayedTransactions < INVENTORY_BROADCAST_MAX_PER_MB *
-                                                  config.GetMaxBlockSize() /
-                                                  1000000) {
-                    // Fetch the top element from the heap
-                    std::pop_heap(vInvTx.begin(), vInvTx.end(),
-                                  compareInvMempoolOrder);
-                    std::set<TxId>::iterator it = vInvTx.back();
-                    vInvTx.pop_back();
-                    const TxId txid = *it;
-                    // Remove it from the to-be-sent set
-                    pto->m_tx_relay->setInventoryTxToSend.erase(it);
-                    // Check if not in the filter already
-                    if (pto->m_tx_relay->filterInventoryKnown.contains(txid)) {
-                        continue;
-                    }
-                    // Not in the mempool anymore? don't bother sending it.
-                    auto txinfo = m_mempool.info(txid);
-                    if (!txinfo.tx) {
-                        continue;
-                    }
-                    // Peer told you to not send transactions at that
-                    // feerate? Don't bother sending it.
-                    if (txinfo.fee < filterrate.GetFee(txinfo.vsize)) {
-                        continue;
-                    }
-                    if (pto->m_tx_relay->pfilter &&
-                        !pto->m_tx_relay->pfilter->IsRelevantAndUpdate(
-                            *txinfo.tx)) {
-                        continue;
-                    }
-                    // Send
-                    State(pto->GetId())->m_recently_announced_invs.insert(txid);
-                    addInvAndMaybeFlush(MSG_TX, txid);
-                    nRelayedTransactions++;
-                    {
-                        // Expire old relay messages
-                        while (!g_relay_expiration.empty() &&
-                               g_relay_expiration.front().first <
-                                   current_time) {
-                            mapRelay.erase(g_relay_expiration.front().second);
-                            g_relay_expiration.pop_front();
+                const unsigned int nMaxRelayedTransactions =
+                    INVENTORY_BROADCAST_MAX_PER_MB * config.GetMaxBlockSize() /
+                    1000000;
+                LOCK2(pto->m_tx_relay->cs_filter, m_mempool.cs);
+                for (const auto &batch : batches) {
+                    const uint64_t batch_end = batch->EndSequence();
+                    while (next_tx < batch_end &&
+                           nRelayedTransactions < nMaxRelayedTransactions) {
+                        const TxMempoolInfo &txinfo =
+                            batch->txs[next_tx++ - batch->first_sequence];
+                        const TxId &txid = txinfo.tx->GetId();
+                        // Check if not in the filter already
+                        if (pto->m_tx_relay->filterInventoryKnown.contains(
+                                txid)) {
+                            continue;
+                        }
+                        // A peer lagging behind may reach the transaction
+                        // long after it was batched, once it has been mined
+                        // or evicted. Don't announce it nor add it to
+                        // mapRelay then.
+                        if (!m_mempool.exists(txid)) {
+                            continue;
                         }
+                        // Peer told you to not send transactions at that
+                        // feerate? Don't bother sending it.
+                        if (txinfo.fee < filterrate.GetFee(txinfo.vsize)) {
+                            continue;
+                        }
+                        if (pto->m_tx_relay->pfilter &&
+                            !pto->m_tx_relay->pfilter->IsRelevantAndUpdate(
+                                *txinfo.tx)) {
+                            continue;
+                        }
+                        // Send
+                        State(pto->GetId())
+                            ->m_recently_announced_invs.insert(txid);
+                        addInvAndMaybeFlush(MSG_TX, txid);
+                        nRelayedTransactions++;
+                        {
+                            // Expire old relay messages
+                            while (!g_relay_expiration.empty() &&
+                                   g_relay_expiration.front().first <
+                                       current_time) {
+                                mapRelay.erase(
+                                    g_relay_expiration.front().second);
+                                g_relay_expiration.pop_front();
+                            }
 
-                        auto ret = mapRelay.insert(
-                            std::make_pair(txid, std::move(txinfo.tx)));
-                        if (ret.second) {
-                            g_relay_expiration.push_back(std::make_pair(
-                                current_time + RELAY_TX_CACHE_TIME, ret.first));
+                            auto ret = mapRelay.insert(
+                                std::make_pair(txid, txinfo.tx));
+                            if (ret.second) {
+                                g_relay_expiration.push_back(std::make_pair(
+                                    current_time + RELAY_TX_CACHE_TIME,
+                                    ret.first));
+                            }
                         }
+                        pto->m_tx_relay->filterInventoryKnown.insert(txid);
                     }
-                    pto->m_tx_relay->filterInventoryKnown.insert(txid);
                 }
             }
         }
@@ -7079,18 +7596,38 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
         LOCK(cs_main);
 
         CNodeState &state = *State(pto->GetId());
+        const auto min_ping_time = pto->m_min_ping_time.load();
+        state.m_min_ping_time =
+            min_ping_time == std::chrono::microseconds::max() ? 0us
+                                                              : min_ping_time;
+        const int max_blocks_in_flight = GetMaxBlocksInFlight(state);
 
         if (!pto->fClient &&
             ((fFetch && !pto->m_limited_node) ||
              !m_chainman.ActiveChainstate().IsInitialBlockDownload()) &&
-            state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+            state.nBlocksInFlight < max_blocks_in_flight) {
             std::vector<const CBlockIndex *> vToDownload;
             NodeId staller = -1;
-            FindNextBlocksToDownload(pto->GetId(),
-                                     MAX_BLOCKS_IN_TRANSIT_PER_PEER -
-                                         state.nBlocksInFlight,
-                                     vToDownload, staller);
-            for (const CBlockIndex *pindex : vToDownload) {
+            const unsigned int count =
+                max_blocks_in_flight - state.nBlocksInFlight;
+            FindNextBlocksToDownload(pto->GetId(), count, vToDownload,
+                                     staller);
+            const size_t num_next_blocks = vToDownload.size();
+            if (m_adaptive_block_download) {
+                FindLateBlocksToDownload(
+                    pto->GetId(), count - vToDownload.size(), vToDownload);
+            }
+            for (size_t i = 0; i < vToDownload.size(); i++) {
+                const CBlockIndex *pindex = vToDownload[i];
+                if (i >= num_next_blocks) {
+                    LogPrint(BCLog::NET,
+                             "Block %s (%d) is late from peer=%d, requesting "
+                             "it from faster peer=%d\n",
+                             pindex->GetBlockHash().ToString(),
+                             pindex->nHeight,
+                             mapBlocksInFlight[pindex->GetBlockHash()].first,
+                             pto->GetId());
+                }
                 vGetData.push_back(CInv(MSG_BLOCK, pindex->GetBlockHash()));
                 BlockRequested(config, pto->GetId(), *pindex);
                 LogPrint(BCLog::NET, "Requesting block %s (%d) peer=%d\n",
@@ -10,6 +10,11 @@
 #include <sync.h>
 #include <validationinterface.h>
 
+#include <array>
+#include <chrono>
+#include <map>
+#include <string>
+
 extern RecursiveMutex cs_main;
 
 namespace avalanche {
@@ -32,6 +37,10 @@ static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
  */
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
 static const bool DEFAULT_PEERBLOCKFILTERS = false;
+/** Default for -adaptiveblockdownload */
+static const bool DEFAULT_ADAPTIVE_BLOCK_DOWNLOAD = true;
+/** Default for -reconblockrelay */
+static const bool DEFAULT_RECON_BLOCK_RELAY = false;
 /** Threshold for marking a node to be discouraged, e.g. disconnected and added
  * to the discouragement filter. */
 static const int DISCOURAGEMENT_THRESHOLD{100};
@@ -48,6 +57,22 @@ struct CNodeStateStats {
     bool m_addr_relay_enabled{false};
 };
 
+/** Processing time statistics for a message type, aggregated over all peers */
+struct MessageProcessingStats {
+    //! Number of histogram buckets, the last one counts all the slower messages
+    static constexpr size_t NUM_TIME_BUCKETS = 24;
+
+    uint64_t count{0};
+    std::chrono::microseconds total_time{0};
+    std::chrono::microseconds max_time{0};
+    //! Time cs_main was held while processing the messages
+    std::chrono::microseconds cs_main_time{0};
+    //! Time the messages waited in the process queue
+    std::chrono::microseconds queue_time{0};
+    //! Bucket i counts the messages processed in less than 2^i microseconds
+    std::array<uint64_t, NUM_TIME_BUCKETS> time_histogram{};
+};
+
 class PeerManager : public CValidationInterface, public NetEventsInterface {
 public:
     static std::unique_ptr<PeerManager>
@@ -77,6 +102,10 @@ public:
     virtual bool GetNodeStateStats(NodeId nodeid,
                                    CNodeStateStats &stats) const = 0;
 
+    /** Get the processing time statistics, by message type */
+    virtual std::map<std::string, MessageProcessingStats>
+    GetMessageProcessingStats() const = 0;
+
     /** Whether this node ignores txs received over p2p. */
     virtual bool IgnoresIncomingTxs() = 0;
 
@@ -760,6 +760,27 @@ uint32_t CNetAddr::GetMappedAS(const std::vector<bool> &asmap) const {
     return mapped_as;
 }
 
+uint32_t CNetAddr::GetMappedAS(const CompiledAsmap &asmap) const {
+    uint32_t net_class = GetNetClass();
+    if (asmap.empty() || (net_class != NET_IPV4 && net_class != NET_IPV6)) {
+        return 0; // Indicates not found, safe because AS0 is reserved per
+                  // RFC7607.
+    }
+    std::array<uint8_t, ADDR_IPV6_SIZE> ip;
+    if (HasLinkedIPv4()) {
+        // For lookup, treat as if it was just an IPv4 address
+        // (IPV4_IN_IPV6_PREFIX + IPv4 bits)
+        std::copy(IPV4_IN_IPV6_PREFIX.begin(), IPV4_IN_IPV6_PREFIX.end(),
+                  ip.begin());
+        WriteBE32(ip.data() + IPV4_IN_IPV6_PREFIX.size(), GetLinkedIPv4());
+    } else {
+        // Use all 128 bits of the IPv6 address otherwise
+        assert(IsIPv6());
+        std::copy(m_addr.begin(), m_addr.end(), ip.begin());
+    }
+    return asmap.Lookup(ip);
+}
+
 /**
  * Get the canonical identifier of our network group
  *
@@ -770,7 +791,7 @@ uint32_t CNetAddr::GetMappedAS(const std::vector<bool> &asmap) const {
  * @note No two connections will be attempted to addresses with the same network
  *       group.
  */
-std::vector<uint8_t> CNetAddr::GetGroup(const std::vector<bool> &asmap) const {
+std::vector<uint8_t> CNetAddr::GetGroup(const CompiledAsmap &asmap) const {
     std::vector<uint8_t> vchRet;
     uint32_t net_class = GetNetClass();
     // If non-empty asmap is supplied and the address is IPv4/IPv6,
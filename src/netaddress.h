@@ -116,6 +116,8 @@ static constexpr size_t ADDR_INTERNAL_SIZE = 10;
 /// SAM 3.1 and earlier do not support specifying ports and force the port to 0.
 static constexpr uint16_t I2P_SAM31_PORT{0};
 
+class CompiledAsmap;
+
 /**
  * Network address.
  */
@@ -231,8 +233,9 @@ public:
     // peers in AddrMan bucketing based on the AS infrastructure.
     // The ip->AS mapping depends on how asmap is constructed.
     uint32_t GetMappedAS(const std::vector<bool> &asmap) const;
+    uint32_t GetMappedAS(const CompiledAsmap &asmap) const;
 
-    std::vector<uint8_t> GetGroup(const std::vector<bool> &asmap) const;
+    std::vector<uint8_t> GetGroup(const CompiledAsmap &asmap) const;
     std::vector<uint8_t> GetAddrBytes() const;
     int GetReachabilityFrom(const CNetAddr *paddrPartner = nullptr) const;
 
@@ -13,6 +13,8 @@
 #include <flatfile.h>
 #include <fs.h>
 #include <hash.h>
+#include <logging/timer.h>
+#include <memusage.h>
 #include <pow/pow.h>
 #include <reverse_iterator.h>
 #include <shutdown.h>
@@ -49,7 +51,8 @@ CBlockIndex *BlockManager::AddToBlockIndex(const CBlockHeader &block) {
     }
 
     // Construct new block index object
-    CBlockIndex *pindexNew = new CBlockIndex(block);
+    CBlockIndex *pindexNew = m_block_index_arena.Allocate();
+    *pindexNew = CBlockIndex(block);
     // We assign the sequence id to blocks only when the full data is available,
     // to avoid miners withholding blocks but broadcasting headers, to get a
     // competitive advantage.
@@ -225,37 +228,67 @@ CBlockIndex *BlockManager::InsertBlockIndex(const BlockHash &hash) {
     }
 
     // Create new
-    CBlockIndex *pindexNew = new CBlockIndex();
+    CBlockIndex *pindexNew = m_block_index_arena.Allocate();
     mi = m_block_index.insert(std::make_pair(hash, pindexNew)).first;
     pindexNew->phashBlock = &((*mi).first);
 
     return pindexNew;
 }
 
+std::vector<CBlockIndex *> BlockManager::GetBlockIndexByHeight() const {
+    AssertLockHeld(cs_main);
+    // Heights are dense and bounded by the number of entries, so a counting
+    // sort orders the whole index in linear time. Each parent is visited
+    // before its children, which is all the callers rely on.
+    std::vector<size_t> offsets;
+    for (const auto &[hash, pindex] : m_block_index) {
+        const size_t height = pindex->nHeight;
+        if (offsets.size() <= height + 1) {
+            offsets.resize(height + 2);
+        }
+        offsets[height + 1]++;
+    }
+    for (size_t height = 1; height < offsets.size(); height++) {
+        offsets[height] += offsets[height - 1];
+    }
+
+    std::vector<CBlockIndex *> by_height(m_block_index.size());
+    for (const auto &[hash, pindex] : m_block_index) {
+        by_height[offsets[pindex->nHeight]++] = pindex;
+    }
+    return by_height;
+}
+
 bool BlockManager::LoadBlockIndex(const Consensus::Params &params,
                                   ChainstateManager &chainman) {
     AssertLockHeld(cs_main);
-    if (!m_block_tree_db->LoadBlockIndexGuts(
-            params, [this](const BlockHash &hash) EXCLUSIVE_LOCKS_REQUIRED(
-                        cs_main) { return this->InsertBlockIndex(hash); })) {
-        return false;
+    // Size the map up front so it is not rehashed over and over while the
+    // entries are streamed in.
+    m_block_index.reserve(m_block_index.size() +
+                          m_block_tree_db->EstimateBlockIndexEntries());
+    {
+        LOG_TIME_MILLIS_WITH_CATEGORY("read block index entries",
+                                      BCLog::ALL);
+        if (!m_block_tree_db->LoadBlockIndexGuts(
+                params,
+                [this](const BlockHash &hash) EXCLUSIVE_LOCKS_REQUIRED(
+                    cs_main) { return this->InsertBlockIndex(hash); })) {
+            return false;
+        }
     }
 
-    // Calculate nChainWork
-    std::vector<std::pair<int, CBlockIndex *>> vSortedByHeight;
-    vSortedByHeight.reserve(m_block_index.size());
-    for (const std::pair<const BlockHash, CBlockIndex *> &item :
-         m_block_index) {
-        CBlockIndex *pindex = item.second;
-        vSortedByHeight.push_back(std::make_pair(pindex->nHeight, pindex));
-    }
+    // Everything below is derived from the headers that were just read, so
+    // it is recomputed in a single pass rather than persisted.
+    LOG_TIME_MILLIS_WITH_CATEGORY("rebuild block index chain state",
+                                  BCLog::ALL);
 
-    sort(vSortedByHeight.begin(), vSortedByHeight.end());
+    // Calculate nChainWork
+    const std::vector<CBlockIndex *> vSortedByHeight{GetBlockIndexByHeight()};
 
     // Find start of assumed-valid region.
     int first_assumed_valid_height = std::numeric_limits<int>::max();
 
-    for (const auto &[height, block] : vSortedByHeight) {
+    for (CBlockIndex *block : vSortedByHeight) {
         if (block->IsAssumedValid()) {
             auto chainstates = chainman.GetAll();
 
@@ -275,15 +308,14 @@ bool BlockManager::LoadBlockIndex(const Consensus::Params &params,
                 return !chainstate->reliesOnAssumedValid();
             }));
 
-            first_assumed_valid_height = height;
+            first_assumed_valid_height = block->nHeight;
             break;
         }
     }
-    for (const std::pair<int, CBlockIndex *> &item : vSortedByHeight) {
+    for (CBlockIndex *pindex : vSortedByHeight) {
         if (ShutdownRequested()) {
             return false;
         }
-        CBlockIndex *pindex = item.second;
         pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) +
                              GetBlockProof(*pindex);
         pindex->nTimeMax =
@@ -370,11 +402,8 @@ bool BlockManager::LoadBlockIndex(const Consensus::Params &params,
 void BlockManager::Unload() {
     m_blocks_unlinked.clear();
 
-    for (const BlockMap::value_type &entry : m_block_index) {
-        delete entry.second;
-    }
-
     m_block_index.clear();
+    m_block_index_arena.Clear();
 
     m_blockfile_info.clear();
     m_last_blockfile = 0;
@@ -406,9 +435,15 @@ bool BlockManager::WriteBlockIndexDB() {
 }
 
 bool BlockManager::LoadBlockIndexDB(ChainstateManager &chainman) {
+    const int64_t load_start = GetTimeMillis();
     if (!LoadBlockIndex(::Params().GetConsensus(), chainman)) {
         return false;
     }
+    LogPrintf("%s: loaded %u block index entries in %dms, using %.1fMiB\n",
+              __func__, m_block_index.size(), GetTimeMillis() - load_start,
+              (m_block_index_arena.DynamicMemoryUsage() +
+               memusage::DynamicUsage(m_block_index)) /
+                  1024.0 / 1024);
 
     // Load block file info
     m_block_tree_db->ReadLastBlockFile(m_last_blockfile);
@@ -528,7 +563,12 @@ CBlockFileInfo *BlockManager::GetBlockFileInfo(size_t n) {
     return &m_blockfile_info.at(n);
 }
 
-static bool UndoWriteToDisk(const CBlockUndo &blockundo, FlatFilePos &pos,
+/**
+ * Write undo data that has already been serialized. Sizing the record,
+ * writing it and computing its checksum all work from the same buffer, so
+ * the undo data only needs to be serialized once.
+ */
+static bool UndoWriteToDisk(const CDataStream &undo_data, FlatFilePos &pos,
                             const BlockHash &hashBlock,
                             const CMessageHeader::MessageMagic &messageStart) {
     // Open history file to append
@@ -538,7 +578,7 @@ static bool UndoWriteToDisk(const CBlockUndo &blockundo, FlatFilePos &pos,
     }
 
     // Write index header
-    unsigned int nSize = GetSerializeSize(blockundo, fileout.GetVersion());
+    unsigned int nSize = undo_data.size();
     fileout << messageStart << nSize;
 
     // Write undo data
@@ -547,12 +587,12 @@ static bool UndoWriteToDisk(const CBlockUndo &blockundo, FlatFilePos &pos,
         return error("%s: ftell failed", __func__);
     }
     pos.nPos = (unsigned int)fileOutPos;
-    fileout << blockundo;
+    fileout.write(undo_data.data(), undo_data.size());
 
     // calculate & write checksum
     CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
     hasher << hashBlock;
-    hasher << blockundo;
+    hasher.write(undo_data.data(), undo_data.size());
     fileout << hasher.GetHash();
 
     return true;
@@ -779,12 +819,14 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo &blockundo,
                                          const CChainParams &chainparams) {
     // Write undo information to disk
     if (pindex->GetUndoPos().IsNull()) {
+        CDataStream undo_data(SER_DISK, CLIENT_VERSION);
+        undo_data << blockundo;
+
         FlatFilePos _pos;
-        if (!FindUndoPos(state, pindex->nFile, _pos,
-                         ::GetSerializeSize(blockundo, CLIENT_VERSION) + 40)) {
+        if (!FindUndoPos(state, pindex->nFile, _pos, undo_data.size() + 40)) {
             return error("ConnectBlock(): FindUndoPos failed");
         }
-        if (!UndoWriteToDisk(blockundo, _pos, pindex->pprev->GetBlockHash(),
+        if (!UndoWriteToDisk(undo_data, _pos, pindex->pprev->GetBlockHash(),
                              chainparams.DiskMagic())) {
             return AbortNode(state, "Failed to write undo data");
         }
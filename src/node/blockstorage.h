@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <vector>
 
+#include <blockindex.h>
 #include <fs.h>
 #include <protocol.h> // For CMessageHeader::MessageStartChars
 #include <txdb.h>
@@ -120,6 +121,9 @@ private:
     /** Dirty block file entries. */
     std::set<int> m_dirty_fileinfo;
 
+    /** Storage for the entries of m_block_index. */
+    BlockIndexArena m_block_index_arena GUARDED_BY(cs_main);
+
 public:
     BlockMap m_block_index GUARDED_BY(cs_main);
 
@@ -148,6 +152,10 @@ public:
     /** Clear all data members. */
     void Unload() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /** Return all the block index entries, ordered by increasing height. */
+    std::vector<CBlockIndex *> GetBlockIndexByHeight() const
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     CBlockIndex *AddToBlockIndex(const CBlockHeader &block)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /** Create a new block index entry for a given block hash */
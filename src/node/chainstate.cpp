@@ -6,6 +6,7 @@
 
 #include <config.h>
 #include <consensus/params.h>
+#include <logging/timer.h>
 #include <node/blockstorage.h>
 #include <validation.h>
 
@@ -62,11 +63,14 @@ LoadChainstate(bool fReset, ChainstateManager &chainman, CTxMemPool *mempool,
     // block file from disk.
     // Note that it also sets fReindex based on the disk flag!
     // From here on out fReindex and fReset mean something different!
-    if (!chainman.LoadBlockIndex()) {
-        if (shutdown_requested && shutdown_requested()) {
-            return ChainstateLoadingError::SHUTDOWN_PROBED;
+    {
+        LOG_TIME_MILLIS_WITH_CATEGORY("load block index", BCLog::ALL);
+        if (!chainman.LoadBlockIndex()) {
+            if (shutdown_requested && shutdown_requested()) {
+                return ChainstateLoadingError::SHUTDOWN_PROBED;
+            }
+            return ChainstateLoadingError::ERROR_LOADING_BLOCK_DB;
         }
-        return ChainstateLoadingError::ERROR_LOADING_BLOCK_DB;
     }
 
     if (!chainman.BlockIndex().empty() &&
@@ -112,8 +116,11 @@ LoadChainstate(bool fReset, ChainstateManager &chainman, CTxMemPool *mempool,
 
         // ReplayBlocks is a no-op if we cleared the coinsviewdb with
         // -reindex or -reindex-chainstate
-        if (!chainstate->ReplayBlocks()) {
-            return ChainstateLoadingError::ERROR_REPLAYBLOCKS_FAILED;
+        {
+            LOG_TIME_MILLIS_WITH_CATEGORY("replay blocks", BCLog::ALL);
+            if (!chainstate->ReplayBlocks()) {
+                return ChainstateLoadingError::ERROR_REPLAYBLOCKS_FAILED;
+            }
         }
 
         // The on-disk coinsdb is now in a good state, create the cache
@@ -123,6 +130,7 @@ LoadChainstate(bool fReset, ChainstateManager &chainman, CTxMemPool *mempool,
         if (!is_coinsview_empty(chainstate)) {
             // LoadChainTip initializes the chain based on CoinsTip()'s
             // best block
+            LOG_TIME_MILLIS_WITH_CATEGORY("load chain tip", BCLog::ALL);
             if (!chainstate->LoadChainTip()) {
                 return ChainstateLoadingError::ERROR_LOADCHAINTIP_FAILED;
             }
@@ -154,6 +162,7 @@ VerifyLoadedChainstate(ChainstateManager &chainman, bool fReset,
                 return ChainstateLoadVerifyError::ERROR_BLOCK_FROM_FUTURE;
             }
 
+            LOG_TIME_MILLIS_WITH_CATEGORY("verify chainstate", BCLog::ALL);
             if (!CVerifyDB().VerifyDB(*chainstate, config,
                                       chainstate->CoinsDB(), check_level,
                                       check_blocks)) {
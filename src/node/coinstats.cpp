@@ -15,6 +15,7 @@
 #include <util/system.h>
 #include <validation.h>
 
+#include <cstring>
 #include <map>
 
 namespace node {
@@ -166,6 +167,42 @@ bool GetUTXOStats(CCoinsView *view, BlockManager &blockman, CCoinsStats &stats,
     assert(false);
 }
 
+SerializedCoinsHasher::SerializedCoinsHasher(const BlockHash &block_hash)
+    : m_hasher(SER_GETHASH, PROTOCOL_VERSION) {
+    m_hasher << block_hash;
+}
+
+bool SerializedCoinsHasher::Add(const COutPoint &outpoint, const Coin &coin) {
+    if (coin.IsSpent()) {
+        return false;
+    }
+    if (!m_outputs.empty()) {
+        if (outpoint.GetTxId() == m_txid) {
+            if (outpoint.GetN() <= m_outputs.rbegin()->first) {
+                return false;
+            }
+        } else if (std::memcmp(outpoint.GetTxId().begin(), m_txid.begin(),
+                               m_txid.size()) < 0) {
+            // The database sorts keys bytewise, unlike uint256::operator<.
+            return false;
+        } else {
+            ApplyHash(m_hasher, m_txid, m_outputs);
+            m_outputs.clear();
+        }
+    }
+    m_txid = outpoint.GetTxId();
+    m_outputs.emplace_hint(m_outputs.end(), outpoint.GetN(), coin);
+    return true;
+}
+
+uint256 SerializedCoinsHasher::Finalize() {
+    if (!m_outputs.empty()) {
+        ApplyHash(m_hasher, m_txid, m_outputs);
+        m_outputs.clear();
+    }
+    return m_hasher.GetHash();
+}
+
 // The legacy hash serializes the hashBlock
 static void PrepareHash(CHashWriter &ss, const CCoinsStats &stats) {
     ss << stats.hashBlock;
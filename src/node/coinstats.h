@@ -9,12 +9,15 @@
 #include <chain.h>
 #include <coins.h>
 #include <consensus/amount.h>
+#include <hash.h>
 #include <primitives/blockhash.h>
+#include <primitives/txid.h>
 #include <streams.h>
 #include <uint256.h>
 
 #include <cstdint>
 #include <functional>
+#include <map>
 
 class CCoinsView;
 namespace node {
@@ -67,6 +70,32 @@ bool GetUTXOStats(CCoinsView *view, node::BlockManager &blockman,
                   const std::function<void()> &interruption_point = {},
                   const CBlockIndex *pindex = nullptr);
 
+/**
+ * Computes the same HASH_SERIALIZED commitment as GetUTXOStats, one coin at a
+ * time, for coins that are supplied in the order in which the coins database
+ * iterates them. This allows a UTXO snapshot to be hashed while it is being
+ * loaded rather than by walking the database afterwards.
+ */
+class SerializedCoinsHasher {
+private:
+    CHashWriter m_hasher;
+    TxId m_txid;
+    std::map<uint32_t, Coin> m_outputs;
+
+public:
+    explicit SerializedCoinsHasher(const BlockHash &block_hash);
+
+    /**
+     * Add the next coin. Returns false if the coin is spent or does not sort
+     * strictly after the previous one, in which case the resulting hash would
+     * not match the database and must not be used.
+     */
+    bool Add(const COutPoint &outpoint, const Coin &coin);
+
+    //! Hash of all the coins added so far.
+    uint256 Finalize();
+};
+
 uint64_t GetBogoSize(const CScript &script_pub_key);
 
 CDataStream TxOutSer(const COutPoint &outpoint, const Coin &coin);
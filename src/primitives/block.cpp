@@ -6,6 +6,7 @@
 #include <primitives/block.h>
 
 #include <hash.h>
+#include <streams.h>
 #include <tinyformat.h>
 
 BlockHash CBlockHeader::GetHash() const {
@@ -24,3 +25,14 @@ std::string CBlock::ToString() const {
     }
     return s.str();
 }
+
+void UnserializeBlock(CDataStream &s, CBlock &block,
+                      const TransactionLookup &lookup) {
+    block.SetNull();
+    s >> static_cast<CBlockHeader &>(block);
+    const uint64_t count = ReadCompactSize(s);
+    // The transactions are read straight from the stream buffer, which is
+    // only released once they have all been deserialized.
+    s.ignore(
+        UnserializeTransactions(MakeUCharSpan(s), count, block.vtx, lookup));
+}
@@ -67,9 +67,16 @@ public:
         *(static_cast<CBlockHeader *>(this)) = header;
     }
 
-    SERIALIZE_METHODS(CBlock, obj) {
-        READWRITEAS(CBlockHeader, obj);
-        READWRITE(obj.vtx);
+    template <typename Stream> void Serialize(Stream &s) const {
+        ::Serialize(s, static_cast<const CBlockHeader &>(*this));
+        ::Serialize(s, vtx);
+    }
+
+    template <typename Stream> void Unserialize(Stream &s) {
+        ::Unserialize(s, static_cast<CBlockHeader &>(*this));
+        // The transaction ids are computed together when the whole block is
+        // read rather than one at a time.
+        UnserializeTransactions(s, vtx);
     }
 
     void SetNull() {
@@ -92,6 +99,15 @@ public:
     std::string ToString() const;
 };
 
+class CDataStream;
+
+/**
+ * Deserialize a block from s, sharing the transactions that lookup already
+ * knows about rather than deserializing another copy of them.
+ */
+void UnserializeBlock(CDataStream &s, CBlock &block,
+                      const TransactionLookup &lookup);
+
 /**
  * Describes a place in the block chain to another node such that if the other
  * node doesn't have the same branch, it can find a recent common trunk.  The
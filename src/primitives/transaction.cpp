@@ -6,9 +6,12 @@
 #include <primitives/transaction.h>
 
 #include <consensus/amount.h>
+#include <crypto/sha256.h>
 #include <hash.h>
+#include <streams.h>
 #include <tinyformat.h>
 #include <util/strencodings.h>
+#include <version.h>
 
 #include <cassert>
 
@@ -73,6 +76,127 @@ CTransaction::CTransaction(const CMutableTransaction &tx)
 CTransaction::CTransaction(CMutableTransaction &&tx)
     : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion),
       nLockTime(tx.nLockTime), hash(ComputeHash()) {}
+CTransaction::CTransaction(CMutableTransaction &&tx, const uint256 &hashIn,
+                           PrecomputedHashKey)
+    : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion),
+      nLockTime(tx.nLockTime), hash(hashIn) {}
+
+/**
+ * Upper bound on the transactions serialized at once by MakeTransactionRefs,
+ * so a large block is not copied as a whole. A single larger transaction is
+ * still hashed on its own.
+ */
+static constexpr size_t MAX_HASH_BATCH_SIZE = 256 * 1024;
+
+std::vector<CTransactionRef>
+MakeTransactionRefs(std::vector<CMutableTransaction> &&txs) {
+    std::vector<CTransactionRef> vtx;
+    if (txs.empty()) {
+        return vtx;
+    }
+
+    // Serialize the transactions back to back, as the hashers would, and hash
+    // them in batches reusing the same buffer.
+    std::vector<uint256> hashes(txs.size());
+    std::vector<uint8_t> serialized;
+    std::vector<size_t> ends;
+    std::vector<Span<const uint8_t>> msgs;
+    size_t batch_begin = 0;
+    while (batch_begin < txs.size()) {
+        serialized.clear();
+        ends.clear();
+        CVectorWriter writer(SER_GETHASH, 0, serialized, 0);
+        size_t batch_end = batch_begin;
+        while (batch_end < txs.size() &&
+               serialized.size() < MAX_HASH_BATCH_SIZE) {
+            writer << txs[batch_end++];
+            ends.push_back(serialized.size());
+        }
+
+        msgs.clear();
+        size_t begin = 0;
+        for (const size_t end : ends) {
+            msgs.emplace_back(serialized.data() + begin, end - begin);
+            begin = end;
+        }
+        SHA256DMulti(hashes[batch_begin].begin(), msgs.data(), msgs.size());
+        batch_begin = batch_end;
+    }
+
+    vtx.reserve(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i) {
+        vtx.push_back(std::make_shared<const CTransaction>(
+            std::move(txs[i]), hashes[i], CTransaction::PrecomputedHashKey{}));
+    }
+    return vtx;
+}
+
+/**
+ * Read past a serialized transaction, with the same checks as deserializing
+ * it would do.
+ */
+static void SkipTransaction(SpanReader &s) {
+    // nVersion
+    s.ignore(4);
+    for (uint64_t n = ReadCompactSize(s); n > 0; --n) {
+        // prevout, scriptSig and nSequence
+        s.ignore(32 + 4);
+        s.ignore(ReadCompactSize(s));
+        s.ignore(4);
+    }
+    for (uint64_t n = ReadCompactSize(s); n > 0; --n) {
+        // nValue and scriptPubKey
+        s.ignore(8);
+        s.ignore(ReadCompactSize(s));
+    }
+    // nLockTime
+    s.ignore(4);
+}
+
+size_t UnserializeTransactions(Span<const uint8_t> buffer, uint64_t count,
+                               std::vector<CTransactionRef> &vtx,
+                               const TransactionLookup &lookup) {
+    SpanReader reader(SER_NETWORK, PROTOCOL_VERSION, buffer);
+    std::vector<Span<const uint8_t>> msgs;
+    // Only grow as transactions are actually read, so a bogus count cannot
+    // make us allocate a large amount of memory.
+    for (uint64_t i = 0; i < count; ++i) {
+        const size_t begin = buffer.size() - reader.size();
+        SkipTransaction(reader);
+        msgs.push_back(
+            buffer.subspan(begin, buffer.size() - reader.size() - begin));
+    }
+
+    std::vector<uint256> hashes(msgs.size());
+    if (!msgs.empty()) {
+        SHA256DMulti(hashes[0].begin(), msgs.data(), msgs.size());
+    }
+
+    std::vector<TxId> txids;
+    txids.reserve(hashes.size());
+    for (const uint256 &hash : hashes) {
+        txids.emplace_back(hash);
+    }
+    std::vector<CTransactionRef> known(txids.size());
+    lookup(txids, known);
+
+    vtx.clear();
+    vtx.reserve(msgs.size());
+    for (size_t i = 0; i < msgs.size(); ++i) {
+        if (known[i]) {
+            assert(known[i]->GetId() == txids[i]);
+            vtx.push_back(std::move(known[i]));
+            continue;
+        }
+
+        SpanReader tx_reader(SER_NETWORK, PROTOCOL_VERSION, msgs[i]);
+        vtx.push_back(std::make_shared<const CTransaction>(
+            CMutableTransaction(deserialize, tx_reader), hashes[i],
+            CTransaction::PrecomputedHashKey{}));
+    }
+
+    return buffer.size() - reader.size();
+}
 
 Amount CTransaction::GetValueOut() const {
     Amount nValueOut = Amount::zero();
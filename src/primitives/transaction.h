@@ -13,6 +13,10 @@
 #include <script/script.h>
 #include <serialize.h>
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 static const int SERIALIZE_TRANSACTION = 0x00;
 
 /**
@@ -187,6 +191,17 @@ inline void SerializeTransaction(const TxType &tx, Stream &s) {
     s << tx.nLockTime;
 }
 
+class CTransaction;
+
+/**
+ * Looks up already known transactions by txid, e.g. in the mempool. txs has the
+ * same size as txids, and the entries of the unknown transactions are left
+ * null.
+ */
+using TransactionLookup =
+    std::function<void(const std::vector<TxId> &txids,
+                       std::vector<std::shared_ptr<const CTransaction>> &txs)>;
+
 /**
  * The basic transaction that is broadcasted on the network and contained in
  * blocks. A transaction can contain multiple inputs and outputs.
@@ -218,6 +233,22 @@ private:
 
     uint256 ComputeHash() const;
 
+    /**
+     * Restricts construction from a precomputed hash to
+     * MakeTransactionRefs and UnserializeTransactions, which compute the
+     * hashes of many transactions at once.
+     */
+    class PrecomputedHashKey {
+    public:
+        explicit PrecomputedHashKey() = default;
+    };
+    friend std::vector<std::shared_ptr<const CTransaction>>
+    MakeTransactionRefs(std::vector<CMutableTransaction> &&txs);
+    friend size_t UnserializeTransactions(
+        Span<const uint8_t> buffer, uint64_t count,
+        std::vector<std::shared_ptr<const CTransaction>> &vtx,
+        const TransactionLookup &lookup);
+
 public:
     /** Construct a CTransaction that qualifies as IsNull() */
     CTransaction();
@@ -225,6 +256,8 @@ public:
     /** Convert a CMutableTransaction into a CTransaction. */
     explicit CTransaction(const CMutableTransaction &tx);
     explicit CTransaction(CMutableTransaction &&tx);
+    CTransaction(CMutableTransaction &&tx, const uint256 &hashIn,
+                 PrecomputedHashKey);
 
     template <typename Stream> inline void Serialize(Stream &s) const {
         SerializeTransaction(*this, s);
@@ -325,6 +358,39 @@ static inline CTransactionRef MakeTransactionRef(Tx &&txIn) {
     return std::make_shared<const CTransaction>(std::forward<Tx>(txIn));
 }
 
+/**
+ * Convert many transactions at once, computing their hashes together with
+ * SHA256DMulti rather than one at a time.
+ */
+std::vector<CTransactionRef>
+MakeTransactionRefs(std::vector<CMutableTransaction> &&txs);
+
+/**
+ * Deserialize a vector of transactions serialized as a std::vector of
+ * CTransactionRef, batching the computation of their hashes.
+ */
+template <typename Stream>
+void UnserializeTransactions(Stream &s, std::vector<CTransactionRef> &vtx) {
+    const uint64_t count = ReadCompactSize(s);
+    std::vector<CMutableTransaction> txs;
+    // Only grow as transactions are actually read, so a bogus count cannot
+    // make us allocate a large amount of memory.
+    for (uint64_t i = 0; i < count; ++i) {
+        txs.emplace_back(deserialize, s);
+    }
+    vtx = MakeTransactionRefs(std::move(txs));
+}
+
+/**
+ * Deserialize count transactions from the start of buffer. The boundaries and
+ * the hashes of the transactions are computed from the serialized bytes, so
+ * only the transactions that lookup doesn't know about are deserialized, the
+ * others are shared. Returns the number of bytes read.
+ */
+size_t UnserializeTransactions(Span<const uint8_t> buffer, uint64_t count,
+                               std::vector<CTransactionRef> &vtx,
+                               const TransactionLookup &lookup);
+
 /** Precompute sighash midstate to avoid quadratic hashing */
 struct PrecomputedTransactionData {
     uint256 hashPrevouts, hashSequence, hashOutputs;
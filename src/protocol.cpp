@@ -41,6 +41,9 @@ const char *SENDCMPCT = "sendcmpct";
 const char *CMPCTBLOCK = "cmpctblock";
 const char *GETBLOCKTXN = "getblocktxn";
 const char *BLOCKTXN = "blocktxn";
+const char *SENDRECONBLK = "sendreconblk";
+const char *GETRECONBLK = "getreconblk";
+const char *RECONBLOCK = "reconblock";
 const char *GETCFILTERS = "getcfilters";
 const char *CFILTER = "cfilter";
 const char *GETCFHEADERS = "getcfheaders";
@@ -59,7 +62,19 @@ const char *AVAPROOFSREQ = "avaproofsreq";
 bool IsBlockLike(const std::string &strCommand) {
     return strCommand == NetMsgType::BLOCK ||
            strCommand == NetMsgType::CMPCTBLOCK ||
-           strCommand == NetMsgType::BLOCKTXN;
+           strCommand == NetMsgType::BLOCKTXN ||
+           strCommand == NetMsgType::RECONBLOCK;
+}
+
+bool IsHighPriority(const std::string &strCommand) {
+    return strCommand == NetMsgType::HEADERS ||
+           strCommand == NetMsgType::BLOCK ||
+           strCommand == NetMsgType::CMPCTBLOCK ||
+           strCommand == NetMsgType::GETBLOCKTXN ||
+           strCommand == NetMsgType::BLOCKTXN ||
+           strCommand == NetMsgType::GETRECONBLK ||
+           strCommand == NetMsgType::RECONBLOCK ||
+           strCommand == NetMsgType::AVARESPONSE;
 }
 }; // namespace NetMsgType
 
@@ -77,6 +92,7 @@ static const std::string allNetMessageTypes[] = {
     NetMsgType::FILTERLOAD,  NetMsgType::FILTERADD,    NetMsgType::FILTERCLEAR,
     NetMsgType::SENDHEADERS, NetMsgType::FEEFILTER,    NetMsgType::SENDCMPCT,
     NetMsgType::CMPCTBLOCK,  NetMsgType::GETBLOCKTXN,  NetMsgType::BLOCKTXN,
+    NetMsgType::SENDRECONBLK, NetMsgType::GETRECONBLK, NetMsgType::RECONBLOCK,
     NetMsgType::GETCFILTERS, NetMsgType::CFILTER,      NetMsgType::GETCFHEADERS,
     NetMsgType::CFHEADERS,   NetMsgType::GETCFCHECKPT, NetMsgType::CFCHECKPT,
 };
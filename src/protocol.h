@@ -239,6 +239,22 @@ extern const char *GETBLOCKTXN;
  * @since protocol version 70014 as described by BIP 152
  */
 extern const char *BLOCKTXN;
+/**
+ * Indicates that a node is willing to provide and request blocks via
+ * "reconblock" messages.
+ */
+extern const char *SENDRECONBLK;
+/**
+ * Contains a BlockReconciliationRequest.
+ * Peer should respond with a "reconblock" message, or with a "cmpctblock" or
+ * "block" message if it cannot encode the block for reconciliation.
+ */
+extern const char *GETRECONBLK;
+/**
+ * Contains a CBlockHeaderAndReconciliation.
+ * Sent in response to a "getreconblk" message.
+ */
+extern const char *RECONBLOCK;
 /**
  * getcfilters requests compact filters for a range of blocks.
  * Only available with service bit NODE_COMPACT_FILTERS as described by
@@ -327,6 +343,19 @@ extern const char *AVAPROOFSREQ;
  * may need to be processed differently.
  */
 bool IsBlockLike(const std::string &strCommand);
+
+/**
+ * Indicate if the message is part of the block relay or is an avalanche
+ * response. These messages are latency sensitive and can be processed ahead
+ * of the other messages of the peer, e.g. the transaction relay, because their
+ * outcome doesn't depend on the messages received before them: a transaction
+ * missing from a compact or reconciled block is requested again, and a
+ * response only carries the votes for a poll we sent to a peer whose hello was
+ * already processed. The negotiation messages (e.g. SENDCMPCT) and the other
+ * avalanche messages, e.g. the polls whose answers depend on the transactions
+ * and proofs received earlier, keep their place in the queue.
+ */
+bool IsHighPriority(const std::string &strCommand);
 }; // namespace NetMsgType
 
 /** Get a vector of all valid message types (see above) */
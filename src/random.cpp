@@ -45,6 +45,7 @@
 
 [[noreturn]] static void RandFailure() {
     LogPrintf("Failed to read randomness, aborting\n");
+    LogInstance().Flush();
     std::abort();
 }
 
@@ -189,7 +189,7 @@ void RCUInfos::synchronize() {
     do {
         runCleanups();
         cond.notify_one();
-    } while (!cond.wait_for(lock, std::chrono::microseconds(1), [&] {
+    } while (!lock.WaitFor(cond, std::chrono::microseconds(1), [&] {
         return cleanups.empty() && hasSyncedTo(syncRev);
     }));
 }
@@ -14,6 +14,7 @@
 #include <consensus/params.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <dbwrapper.h>
 #include <deploymentinfo.h>
 #include <deploymentstatus.h>
 #include <hash.h>
@@ -31,6 +32,8 @@
 #include <rpc/server_util.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
+#include <script/scriptcache.h>
+#include <script/sigcache.h>
 #include <streams.h>
 #include <txdb.h>
 #include <txmempool.h>
@@ -293,16 +296,16 @@ static RPCHelpMan waitfornewblock() {
                 WAIT_LOCK(cs_blockchange, lock);
                 block = latestblock;
                 if (timeout) {
-                    cond_blockchange.wait_for(
-                        lock, std::chrono::milliseconds(timeout),
+                    lock.WaitFor(
+                        cond_blockchange, std::chrono::milliseconds(timeout),
                         [&block]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {
                             return latestblock.height != block.height ||
                                    latestblock.hash != block.hash ||
                                    !IsRPCRunning();
                         });
                 } else {
-                    cond_blockchange.wait(
-                        lock,
+                    lock.Wait(
+                        cond_blockchange,
                         [&block]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {
                             return latestblock.height != block.height ||
                                    latestblock.hash != block.hash ||
@@ -358,14 +361,14 @@ static RPCHelpMan waitforblock() {
             {
                 WAIT_LOCK(cs_blockchange, lock);
                 if (timeout) {
-                    cond_blockchange.wait_for(
-                        lock, std::chrono::milliseconds(timeout),
+                    lock.WaitFor(
+                        cond_blockchange, std::chrono::milliseconds(timeout),
                         [&hash]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {
                             return latestblock.hash == hash || !IsRPCRunning();
                         });
                 } else {
-                    cond_blockchange.wait(
-                        lock,
+                    lock.Wait(
+                        cond_blockchange,
                         [&hash]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {
                             return latestblock.hash == hash || !IsRPCRunning();
                         });
@@ -417,15 +420,15 @@ static RPCHelpMan waitforblockheight() {
             {
                 WAIT_LOCK(cs_blockchange, lock);
                 if (timeout) {
-                    cond_blockchange.wait_for(
-                        lock, std::chrono::milliseconds(timeout),
+                    lock.WaitFor(
+                        cond_blockchange, std::chrono::milliseconds(timeout),
                         [&height]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {
                             return latestblock.height >= height ||
                                    !IsRPCRunning();
                         });
                 } else {
-                    cond_blockchange.wait(
-                        lock,
+                    lock.Wait(
+                        cond_blockchange,
                         [&height]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {
                             return latestblock.height >= height ||
                                    !IsRPCRunning();
@@ -2837,6 +2840,179 @@ static RPCHelpMan getblockstats() {
     };
 }
 
+static RPCHelpMan getdbinfo() {
+    return RPCHelpMan{
+        "getdbinfo",
+        "Returns LevelDB statistics for every open database.\n",
+        {},
+        RPCResult{
+            RPCResult::Type::ARR,
+            "",
+            "",
+            {{RPCResult::Type::OBJ,
+              "",
+              "",
+              {
+                  {RPCResult::Type::STR, "name",
+                   "the name the database is tuned under with -dboption"},
+                  {RPCResult::Type::STR, "path", "the database location"},
+                  {RPCResult::Type::NUM, "memory_usage",
+                   "approximate memory used by the caches and memtables in "
+                   "bytes"},
+                  {RPCResult::Type::NUM, "cache_hits",
+                   "block cache lookups that were hits"},
+                  {RPCResult::Type::NUM, "cache_misses",
+                   "block cache lookups that were misses"},
+                  {RPCResult::Type::NUM, "cache_hit_rate",
+                   "fraction of block cache lookups that were hits"},
+                  {RPCResult::Type::NUM, "bytes_written",
+                   "bytes written to the database since it was opened"},
+                  {RPCResult::Type::NUM, "write_amplification",
+                   "bytes written by flushes and compactions per byte "
+                   "written to the database"},
+                  {RPCResult::Type::NUM, "read_amplification",
+                   "worst-case number of tables read by a lookup"},
+                  {RPCResult::Type::ARR,
+                   "levels",
+                   "the non-empty levels",
+                   {{RPCResult::Type::OBJ,
+                     "",
+                     "",
+                     {
+                         {RPCResult::Type::NUM, "level", "the level"},
+                         {RPCResult::Type::NUM, "files", "number of tables"},
+                         {RPCResult::Type::NUM, "size_mib",
+                          "size of the tables in MiB"},
+                         {RPCResult::Type::NUM, "compaction_time",
+                          "time spent compacting into this level in "
+                          "seconds"},
+                         {RPCResult::Type::NUM, "compaction_read_mib",
+                          "MiB read by compactions into this level"},
+                         {RPCResult::Type::NUM, "compaction_write_mib",
+                          "MiB written by compactions into this level"},
+                     }}}},
+              }}}},
+        RPCExamples{HelpExampleCli("getdbinfo", "") +
+                    HelpExampleRpc("getdbinfo", "")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            UniValue ret(UniValue::VARR);
+            ForEachDBWrapper([&ret](const CDBWrapper &db) {
+                const DBStats stats = db.GetStats();
+
+                UniValue obj(UniValue::VOBJ);
+                obj.pushKV("name", db.GetOptionsName());
+                obj.pushKV("path", fs::PathToString(db.GetPath()));
+                obj.pushKV("memory_usage", uint64_t(stats.memory_usage));
+                obj.pushKV("cache_hits", stats.cache_hits);
+                obj.pushKV("cache_misses", stats.cache_misses);
+                obj.pushKV("cache_hit_rate", stats.CacheHitRate());
+                obj.pushKV("bytes_written", stats.bytes_written);
+                obj.pushKV("write_amplification", stats.WriteAmplification());
+                obj.pushKV("read_amplification", stats.ReadAmplification());
+
+                UniValue levels(UniValue::VARR);
+                for (const DBLevelStats &level : stats.levels) {
+                    UniValue entry(UniValue::VOBJ);
+                    entry.pushKV("level", level.level);
+                    entry.pushKV("files", level.files);
+                    entry.pushKV("size_mib", level.size_mib);
+                    entry.pushKV("compaction_time", level.compaction_time_s);
+                    entry.pushKV("compaction_read_mib",
+                                 level.compaction_read_mib);
+                    entry.pushKV("compaction_write_mib",
+                                 level.compaction_write_mib);
+                    levels.push_back(entry);
+                }
+                obj.pushKV("levels", levels);
+                ret.push_back(obj);
+            });
+            return ret;
+        },
+    };
+}
+
+static RPCHelpMan compactdb() {
+    return RPCHelpMan{
+        "compactdb",
+        "Compacts the LevelDB databases with the given name. The call blocks "
+        "until the compaction is complete; validation keeps running "
+        "meanwhile.\n",
+        {
+            {"name", RPCArg::Type::STR, RPCArg::Optional::NO,
+             "The database name as reported by getdbinfo, or an empty string "
+             "for all the databases"},
+        },
+        RPCResult{RPCResult::Type::NUM, "",
+                  "The number of databases compacted"},
+        RPCExamples{HelpExampleCli("compactdb", "\"chainstate\"") +
+                    HelpExampleRpc("compactdb", "\"chainstate\"")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const std::string name = request.params[0].get_str();
+            const int compacted = CompactDBWrappers(name);
+            if (compacted == 0) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER,
+                                   strprintf("Unknown database %s", name));
+            }
+            return compacted;
+        },
+    };
+}
+
+static UniValue ValidationCacheStatsToJSON(const ValidationCacheStats &stats) {
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("max_entries", uint64_t(stats.max_entries));
+    obj.pushKV("hits", stats.hits);
+    obj.pushKV("misses", stats.misses);
+    const uint64_t lookups = stats.hits + stats.misses;
+    obj.pushKV("hit_rate", lookups == 0 ? 0. : double(stats.hits) / lookups);
+    obj.pushKV("inserts", stats.inserts);
+    obj.pushKV("evictions", stats.evictions);
+    return obj;
+}
+
+static RPCHelpMan getvalidationcacheinfo() {
+    const std::vector<RPCResult> cache_fields{
+        {RPCResult::Type::NUM, "max_entries",
+         "number of entries the cache can hold"},
+        {RPCResult::Type::NUM, "hits", "lookups that found an entry"},
+        {RPCResult::Type::NUM, "misses", "lookups that found no entry"},
+        {RPCResult::Type::NUM, "hit_rate",
+         "fraction of lookups that found an entry"},
+        {RPCResult::Type::NUM, "inserts", "entries added to the cache"},
+        {RPCResult::Type::NUM, "evictions",
+         "inserts that dropped an entry because the cache was full"},
+    };
+    return RPCHelpMan{
+        "getvalidationcacheinfo",
+        "Returns usage statistics of the signature and script execution "
+        "caches since startup, to help sizing -maxsigcachesize and "
+        "-maxscriptcachesize.\n",
+        {},
+        RPCResult{RPCResult::Type::OBJ,
+                  "",
+                  "",
+                  {
+                      {RPCResult::Type::OBJ, "signature",
+                       "the signature cache", cache_fields},
+                      {RPCResult::Type::OBJ, "script",
+                       "the script execution cache", cache_fields},
+                  }},
+        RPCExamples{HelpExampleCli("getvalidationcacheinfo", "") +
+                    HelpExampleRpc("getvalidationcacheinfo", "")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            UniValue ret(UniValue::VOBJ);
+            ret.pushKV("signature",
+                       ValidationCacheStatsToJSON(GetSignatureCacheStats()));
+            ret.pushKV("script", ValidationCacheStatsToJSON(
+                                     GetScriptExecutionCacheStats()));
+            return ret;
+        },
+    };
+}
+
 static RPCHelpMan savemempool() {
     return RPCHelpMan{
         "savemempool",
@@ -3407,6 +3583,7 @@ void RegisterBlockchainRPCCommands(CRPCTable &t) {
         { "blockchain",         getblockstats,                     },
         { "blockchain",         getchaintips,                      },
         { "blockchain",         getchaintxstats,                   },
+        { "blockchain",         getdbinfo,                         },
         { "blockchain",         getdifficulty,                     },
         { "blockchain",         getmempoolancestors,               },
         { "blockchain",         getmempooldescendants,             },
@@ -3415,6 +3592,7 @@ void RegisterBlockchainRPCCommands(CRPCTable &t) {
         { "blockchain",         getrawmempool,                     },
         { "blockchain",         gettxout,                          },
         { "blockchain",         gettxoutsetinfo,                   },
+        { "blockchain",         getvalidationcacheinfo,            },
         { "blockchain",         pruneblockchain,                   },
         { "blockchain",         savemempool,                       },
         { "blockchain",         verifychain,                       },
@@ -3423,6 +3601,7 @@ void RegisterBlockchainRPCCommands(CRPCTable &t) {
         { "blockchain",         getblockfilter,                    },
 
         /* Not shown in help */
+        { "hidden",             compactdb,                         },
         { "hidden",             getfinalizedblockhash,             },
         { "hidden",             finalizeblock,                     },
         { "hidden",             invalidateblock,                   },
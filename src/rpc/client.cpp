@@ -144,6 +144,8 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"disconnectnode", 1, "nodeid"},
     {"logging", 0, "include"},
     {"logging", 1, "exclude"},
+    {"getlockprofile", 0, "reset"},
+    {"setlockprofile", 0, "samplerate"},
     {"upgradewallet", 0, "version"},
     // Echo with conversion (For testing only)
     {"echojson", 0, "arg0"},
@@ -925,7 +925,7 @@ static RPCHelpMan getblocktemplate() {
 
                     WAIT_LOCK(g_best_block_mutex, lock);
                     while (g_best_block == hashWatchedChain && IsRPCRunning()) {
-                        if (g_best_block_cv.wait_until(lock, checktxtime) ==
+                        if (lock.WaitUntil(g_best_block_cv, checktxtime) ==
                             std::cv_status::timeout) {
                             // Timeout: Check transactions for update
                             // without holding the mempool look to avoid
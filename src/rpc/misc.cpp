@@ -21,14 +21,18 @@
 #include <rpc/util.h>
 #include <scheduler.h>
 #include <script/descriptor.h>
+#include <sync.h>
 #include <util/check.h>
 #include <util/message.h> // For MessageSign(), MessageVerify()
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <util/time.h>
 
 #include <univalue.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <tuple>
 #ifdef HAVE_MALLOC_INFO
 #include <malloc.h>
@@ -595,6 +599,17 @@ static RPCHelpMan getmemoryinfo() {
                          {RPCResult::Type::NUM, "chunks_free",
                           "Number unused chunks"},
                      }},
+                    {RPCResult::Type::OBJ,
+                     "logging",
+                     "Information about the asynchronous logging "
+                     "(-asynclogging)",
+                     {
+                         {RPCResult::Type::NUM, "queued",
+                          "Number of bytes of messages waiting to be written"},
+                         {RPCResult::Type::NUM, "dropped",
+                          "Number of messages dropped because too many were "
+                          "waiting"},
+                     }},
                 }},
             RPCResult{"mode \"mallocinfo\"", RPCResult::Type::STR, "",
                       "\"<malloc version=\"1\">...\""},
@@ -609,6 +624,11 @@ static RPCHelpMan getmemoryinfo() {
             if (mode == "stats") {
                 UniValue obj(UniValue::VOBJ);
                 obj.pushKV("locked", RPCLockedMemoryInfo());
+                UniValue logging(UniValue::VOBJ);
+                logging.pushKV("queued",
+                               uint64_t{LogInstance().GetAsyncQueuedBytes()});
+                logging.pushKV("dropped", LogInstance().GetAsyncDrops());
+                obj.pushKV("logging", logging);
                 return obj;
             } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -626,6 +646,143 @@ static RPCHelpMan getmemoryinfo() {
     };
 }
 
+static UniValue TimeHistogramToUniv(
+    const std::array<uint64_t, LockProfiler::NUM_TIME_BUCKETS> &histogram) {
+    UniValue ret(UniValue::VARR);
+    for (const uint64_t bucket : histogram) {
+        ret.push_back(bucket);
+    }
+    return ret;
+}
+
+static RPCHelpMan getlockprofile() {
+    return RPCHelpMan{
+        "getlockprofile",
+        "Returns the mutex acquisitions sampled by the lock profiler "
+        "(-lockprofile), by lock site, the most waited for first.\n"
+        "All the times are in microseconds.\n",
+        {
+            {"reset", RPCArg::Type::BOOL, /* default */ "false",
+             "Clear the statistics after returning them"},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ,
+            "",
+            "",
+            {
+                {RPCResult::Type::NUM, "samplerate",
+                 "One in samplerate acquisitions of each thread is sampled, "
+                 "0 if the profiler is disabled"},
+                {RPCResult::Type::ARR,
+                 "sites",
+                 "",
+                 {
+                     {RPCResult::Type::OBJ,
+                      "",
+                      "",
+                      {
+                          {RPCResult::Type::STR, "mutex", "The mutex name"},
+                          {RPCResult::Type::STR, "file",
+                           "The source file of the lock site"},
+                          {RPCResult::Type::NUM, "line",
+                           "The source line of the lock site"},
+                          {RPCResult::Type::NUM, "samples",
+                           "Number of sampled acquisitions"},
+                          {RPCResult::Type::NUM, "contended",
+                           "Number of them that found the mutex held by "
+                           "another thread"},
+                          {RPCResult::Type::NUM, "total_wait_time",
+                           "Total time waited for the mutex"},
+                          {RPCResult::Type::NUM, "max_wait_time",
+                           "Longest time waited for the mutex"},
+                          {RPCResult::Type::NUM, "total_hold_time",
+                           "Total time the mutex was held"},
+                          {RPCResult::Type::NUM, "max_hold_time",
+                           "Longest time the mutex was held"},
+                          {RPCResult::Type::ARR,
+                           "wait_histogram",
+                           "Number of samples by wait time, entry i counting "
+                           "the times below 2^i, the last one all the longer "
+                           "waits",
+                           {{RPCResult::Type::NUM, "", ""}}},
+                          {RPCResult::Type::ARR,
+                           "hold_histogram",
+                           "Number of samples by hold time, as above",
+                           {{RPCResult::Type::NUM, "", ""}}},
+                      }},
+                 }},
+            }},
+        RPCExamples{HelpExampleCli("getlockprofile", "") +
+                    HelpExampleCli("getlockprofile", "true") +
+                    HelpExampleRpc("getlockprofile", "")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const bool reset =
+                !request.params[0].isNull() && request.params[0].get_bool();
+            std::vector<LockProfiler::SiteStats> sites =
+                LockProfiler::GetStats(reset);
+            std::sort(sites.begin(), sites.end(),
+                      [](const LockProfiler::SiteStats &a,
+                         const LockProfiler::SiteStats &b) {
+                          return a.total_wait_time > b.total_wait_time;
+                      });
+
+            UniValue sites_univ(UniValue::VARR);
+            for (const LockProfiler::SiteStats &site : sites) {
+                UniValue obj(UniValue::VOBJ);
+                obj.pushKV("mutex", site.mutex_name);
+                obj.pushKV("file", site.file);
+                obj.pushKV("line", site.line);
+                obj.pushKV("samples", site.samples);
+                obj.pushKV("contended", site.contended);
+                obj.pushKV("total_wait_time",
+                           count_microseconds(site.total_wait_time));
+                obj.pushKV("max_wait_time",
+                           count_microseconds(site.max_wait_time));
+                obj.pushKV("total_hold_time",
+                           count_microseconds(site.total_hold_time));
+                obj.pushKV("max_hold_time",
+                           count_microseconds(site.max_hold_time));
+                obj.pushKV("wait_histogram",
+                           TimeHistogramToUniv(site.wait_histogram));
+                obj.pushKV("hold_histogram",
+                           TimeHistogramToUniv(site.hold_histogram));
+                sites_univ.push_back(obj);
+            }
+
+            UniValue ret(UniValue::VOBJ);
+            ret.pushKV("samplerate", uint64_t{LockProfiler::GetSampleRate()});
+            ret.pushKV("sites", sites_univ);
+            return ret;
+        },
+    };
+}
+
+static RPCHelpMan setlockprofile() {
+    return RPCHelpMan{
+        "setlockprofile",
+        "Sets the sample rate of the lock profiler, see getlockprofile.\n",
+        {
+            {"samplerate", RPCArg::Type::NUM, RPCArg::Optional::NO,
+             "Sample one in samplerate mutex acquisitions of each thread, or "
+             "0 to disable the profiler"},
+        },
+        RPCResult{RPCResult::Type::NONE, "", ""},
+        RPCExamples{HelpExampleCli("setlockprofile", "1000") +
+                    HelpExampleRpc("setlockprofile", "1000")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const int64_t rate = request.params[0].get_int64();
+            if (rate < 0 || rate > std::numeric_limits<uint32_t>::max()) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER,
+                                   "samplerate out of range");
+            }
+            LockProfiler::SetSampleRate(rate);
+            return NullUniValue;
+        },
+    };
+}
+
 static void EnableOrDisableLogCategories(UniValue cats, bool enable) {
     cats = cats.get_array();
     for (size_t i = 0; i < cats.size(); ++i) {
@@ -901,6 +1058,8 @@ void RegisterMiscRPCCommands(CRPCTable &t) {
         //  ------------------  ----------------------
         { "control",            getmemoryinfo,           },
         { "control",            logging,                 },
+        { "control",            getlockprofile,          },
+        { "control",            setlockprofile,          },
         { "util",               validateaddress,         },
         { "util",               createmultisig,          },
         { "util",               deriveaddresses,         },
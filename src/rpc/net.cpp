@@ -672,6 +672,123 @@ static RPCHelpMan getnettotals() {
     };
 }
 
+static RPCHelpMan getmessagestats() {
+    return RPCHelpMan{
+        "getmessagestats",
+        "Returns the time spent processing the received messages, by message "
+        "type, and the state of the message queues of each peer.\n"
+        "All the times are in microseconds.\n",
+        {},
+        RPCResult{
+            RPCResult::Type::OBJ,
+            "",
+            "",
+            {
+                {RPCResult::Type::OBJ_DYN,
+                 "messages",
+                 "The message types that were processed at least once. The "
+                 "unknown message types are listed under '" +
+                     NET_MESSAGE_COMMAND_OTHER + "'.",
+                 {
+                     {RPCResult::Type::OBJ,
+                      "msg",
+                      "",
+                      {
+                          {RPCResult::Type::NUM, "count",
+                           "Number of messages processed"},
+                          {RPCResult::Type::NUM, "total_time",
+                           "Total processing time"},
+                          {RPCResult::Type::NUM, "max_time",
+                           "Longest processing time"},
+                          {RPCResult::Type::NUM, "cs_main_time",
+                           "Total time cs_main was held while processing"},
+                          {RPCResult::Type::NUM, "queue_time",
+                           "Total time the messages waited to be processed"},
+                          {RPCResult::Type::ARR,
+                           "histogram",
+                           "Number of messages by processing time, entry i "
+                           "counting the times below 2^i, the last one all "
+                           "the slower messages",
+                           {{RPCResult::Type::NUM, "", ""}}},
+                      }},
+                 }},
+                {RPCResult::Type::ARR,
+                 "peers",
+                 "",
+                 {
+                     {RPCResult::Type::OBJ,
+                      "",
+                      "",
+                      {
+                          {RPCResult::Type::NUM, "id", "Peer index"},
+                          {RPCResult::Type::NUM, "process_queue_msgs",
+                           "Number of received messages waiting to be "
+                           "processed"},
+                          {RPCResult::Type::NUM, "process_queue_bytes",
+                           "Size of the received messages waiting to be "
+                           "processed"},
+                          {RPCResult::Type::NUM, "process_queue_age",
+                           "How long the oldest of them has been waiting"},
+                          {RPCResult::Type::NUM, "send_queue_bytes",
+                           "Size of the data waiting to be sent"},
+                          {RPCResult::Type::NUM, "send_queue_age",
+                           "How long the send queue has not been empty"},
+                      }},
+                 }},
+            }},
+        RPCExamples{HelpExampleCli("getmessagestats", "") +
+                    HelpExampleRpc("getmessagestats", "")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            NodeContext &node = EnsureAnyNodeContext(request.context);
+            const CConnman &connman = EnsureConnman(node);
+            const PeerManager &peerman = EnsurePeerman(node);
+
+            UniValue messages(UniValue::VOBJ);
+            for (const auto &[msg_type, stats] :
+                 peerman.GetMessageProcessingStats()) {
+                if (stats.count == 0) {
+                    continue;
+                }
+                UniValue obj(UniValue::VOBJ);
+                obj.pushKV("count", stats.count);
+                obj.pushKV("total_time", count_microseconds(stats.total_time));
+                obj.pushKV("max_time", count_microseconds(stats.max_time));
+                obj.pushKV("cs_main_time",
+                           count_microseconds(stats.cs_main_time));
+                obj.pushKV("queue_time", count_microseconds(stats.queue_time));
+                UniValue histogram(UniValue::VARR);
+                for (const uint64_t bucket : stats.time_histogram) {
+                    histogram.push_back(bucket);
+                }
+                obj.pushKV("histogram", histogram);
+                messages.pushKV(msg_type, obj);
+            }
+
+            std::vector<CNodeStats> vstats;
+            connman.GetNodeStats(vstats);
+            UniValue peers(UniValue::VARR);
+            for (const CNodeStats &stats : vstats) {
+                UniValue obj(UniValue::VOBJ);
+                obj.pushKV("id", stats.nodeid);
+                obj.pushKV("process_queue_msgs", stats.m_process_queue_msgs);
+                obj.pushKV("process_queue_bytes", stats.m_process_queue_bytes);
+                obj.pushKV("process_queue_age",
+                           count_microseconds(stats.m_process_queue_age));
+                obj.pushKV("send_queue_bytes", stats.m_send_queue_bytes);
+                obj.pushKV("send_queue_age",
+                           count_microseconds(stats.m_send_queue_age));
+                peers.push_back(obj);
+            }
+
+            UniValue ret(UniValue::VOBJ);
+            ret.pushKV("messages", messages);
+            ret.pushKV("peers", peers);
+            return ret;
+        },
+    };
+}
+
 static UniValue GetNetworksInfo() {
     UniValue networks(UniValue::VARR);
     for (int n = 0; n < NET_MAX; ++n) {
@@ -1179,6 +1296,7 @@ void RegisterNetRPCCommands(CRPCTable &t) {
         { "network",            disconnectnode,          },
         { "network",            getaddednodeinfo,        },
         { "network",            getnettotals,            },
+        { "network",            getmessagestats,         },
         { "network",            getnetworkinfo,          },
         { "network",            setban,                  },
         { "network",            listbanned,              },
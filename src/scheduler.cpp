@@ -30,7 +30,7 @@ void CScheduler::serviceQueue() {
         try {
             while (!shouldStop() && taskQueue.empty()) {
                 // Wait until there is something to do.
-                newTaskScheduled.wait(lock);
+                lock.Wait(newTaskScheduled);
             }
 
             // Wait until either there is a new task, or until
@@ -39,7 +39,7 @@ void CScheduler::serviceQueue() {
             while (!shouldStop() && !taskQueue.empty()) {
                 std::chrono::steady_clock::time_point timeToWaitFor =
                     taskQueue.begin()->first;
-                if (newTaskScheduled.wait_until(lock, timeToWaitFor) ==
+                if (lock.WaitUntil(newTaskScheduled, timeToWaitFor) ==
                     std::cv_status::timeout) {
                     // Exit loop after timeout, it means we reached the time of
                     // the event
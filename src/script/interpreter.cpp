@@ -9,6 +9,7 @@
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
+#include <hash.h>
 #include <pubkey.h>
 #include <script/bitfield.h>
 #include <script/script.h>
@@ -16,6 +17,9 @@
 #include <uint256.h>
 #include <util/bitmanip.h>
 
+#include <cstring>
+#include <optional>
+
 bool CastToBool(const valtype &vch) {
     for (size_t i = 0; i < vch.size(); i++) {
         if (vch[i] != 0) {
@@ -464,7 +468,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        altstack.push_back(stacktop(-1));
+                        altstack.push_back(std::move(stacktop(-1)));
                         popstack(stack);
                     } break;
 
@@ -474,7 +478,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror,
                                 ScriptError::INVALID_ALTSTACK_OPERATION);
                         }
-                        stack.push_back(altstacktop(-1));
+                        stack.push_back(std::move(altstacktop(-1)));
                         popstack(altstack);
                     } break;
 
@@ -496,8 +500,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                         }
                         valtype vch1 = stacktop(-2);
                         valtype vch2 = stacktop(-1);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        stack.push_back(std::move(vch1));
+                        stack.push_back(std::move(vch2));
                     } break;
 
                     case OP_3DUP: {
@@ -509,9 +513,9 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                         valtype vch1 = stacktop(-3);
                         valtype vch2 = stacktop(-2);
                         valtype vch3 = stacktop(-1);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
-                        stack.push_back(vch3);
+                        stack.push_back(std::move(vch1));
+                        stack.push_back(std::move(vch2));
+                        stack.push_back(std::move(vch3));
                     } break;
 
                     case OP_2OVER: {
@@ -522,8 +526,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                         }
                         valtype vch1 = stacktop(-4);
                         valtype vch2 = stacktop(-3);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        stack.push_back(std::move(vch1));
+                        stack.push_back(std::move(vch2));
                     } break;
 
                     case OP_2ROT: {
@@ -532,11 +536,11 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-6);
-                        valtype vch2 = stacktop(-5);
+                        valtype vch1 = std::move(stacktop(-6));
+                        valtype vch2 = std::move(stacktop(-5));
                         stack.erase(stack.end() - 6, stack.end() - 4);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        stack.push_back(std::move(vch1));
+                        stack.push_back(std::move(vch2));
                     } break;
 
                     case OP_2SWAP: {
@@ -555,9 +559,9 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-1);
-                        if (CastToBool(vch)) {
-                            stack.push_back(vch);
+                        if (CastToBool(stacktop(-1))) {
+                            valtype vch = stacktop(-1);
+                            stack.push_back(std::move(vch));
                         }
                     } break;
 
@@ -583,7 +587,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
                         valtype vch = stacktop(-1);
-                        stack.push_back(vch);
+                        stack.push_back(std::move(vch));
                     } break;
 
                     case OP_NIP: {
@@ -602,7 +606,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
                         valtype vch = stacktop(-2);
-                        stack.push_back(vch);
+                        stack.push_back(std::move(vch));
                     } break;
 
                     case OP_PICK:
@@ -620,11 +624,15 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-n - 1);
+                        // OP_ROLL removes the element, so it can be moved
+                        // rather than copied.
+                        valtype vch = opcode == OP_ROLL
+                                          ? std::move(stacktop(-n - 1))
+                                          : stacktop(-n - 1);
                         if (opcode == OP_ROLL) {
                             stack.erase(stack.end() - n - 1);
                         }
-                        stack.push_back(vch);
+                        stack.push_back(std::move(vch));
                     } break;
 
                     case OP_ROT: {
@@ -655,7 +663,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
                         valtype vch = stacktop(-1);
-                        stack.insert(stack.end() - 2, vch);
+                        stack.insert(stack.end() - 2, std::move(vch));
                     } break;
 
                     case OP_SIZE: {
@@ -734,8 +742,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             // if (opcode == OP_NOTEQUAL)
                             //    fEqual = !fEqual;
                             popstack(stack);
-                            popstack(stack);
-                            stack.push_back(fEqual ? vchTrue : vchFalse);
+                            stacktop(-1) = fEqual ? vchTrue : vchFalse;
                             if (opcode == OP_EQUALVERIFY) {
                                 if (fEqual) {
                                     popstack(stack);
@@ -904,8 +911,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                         bool fValue = (bn2 <= bn1 && bn1 < bn3);
                         popstack(stack);
                         popstack(stack);
-                        popstack(stack);
-                        stack.push_back(fValue ? vchTrue : vchFalse);
+                        stacktop(-1) = fValue ? vchTrue : vchFalse;
                     } break;
 
                     //
@@ -922,30 +928,32 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
                         valtype &vch = stacktop(-1);
-                        valtype vchHash((opcode == OP_RIPEMD160 ||
-                                         opcode == OP_SHA1 ||
-                                         opcode == OP_HASH160)
-                                            ? 20
-                                            : 32);
+                        // Hash into a local buffer, then overwrite the input
+                        // in place so its allocation is reused.
+                        uint8_t vchHash[CSHA256::OUTPUT_SIZE];
+                        const size_t hashSize = (opcode == OP_RIPEMD160 ||
+                                                 opcode == OP_SHA1 ||
+                                                 opcode == OP_HASH160)
+                                                    ? 20
+                                                    : 32;
                         if (opcode == OP_RIPEMD160) {
                             CRIPEMD160()
                                 .Write(vch.data(), vch.size())
-                                .Finalize(vchHash.data());
+                                .Finalize(vchHash);
                         } else if (opcode == OP_SHA1) {
-                            CSHA1()
-                                .Write(vch.data(), vch.size())
-                                .Finalize(vchHash.data());
+                            CSHA1().Write(vch.data(), vch.size()).Finalize(
+                                vchHash);
                         } else if (opcode == OP_SHA256) {
                             CSHA256()
                                 .Write(vch.data(), vch.size())
-                                .Finalize(vchHash.data());
+                                .Finalize(vchHash);
                         } else if (opcode == OP_HASH160) {
-                            CHash160().Write(vch).Finalize(vchHash);
+                            CHash160().Write(vch).Finalize(
+                                Span<uint8_t>(vchHash, CHash160::OUTPUT_SIZE));
                         } else if (opcode == OP_HASH256) {
                             CHash256().Write(vch).Finalize(vchHash);
                         }
-                        popstack(stack);
-                        stack.push_back(vchHash);
+                        vch.assign(vchHash, vchHash + hashSize);
                     } break;
 
                     case OP_CODESEPARATOR: {
@@ -970,8 +978,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return false;
                         }
                         popstack(stack);
-                        popstack(stack);
-                        stack.push_back(fSuccess ? vchTrue : vchFalse);
+                        stacktop(-1) = fSuccess ? vchTrue : vchFalse;
                         if (opcode == OP_CHECKSIGVERIFY) {
                             if (fSuccess) {
                                 popstack(stack);
@@ -1003,12 +1010,12 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
 
                         bool fSuccess = false;
                         if (vchSig.size()) {
-                            valtype vchHash(32);
+                            uint256 messageHash;
                             CSHA256()
                                 .Write(vchMessage.data(), vchMessage.size())
-                                .Finalize(vchHash.data());
+                                .Finalize(messageHash.begin());
                             fSuccess = checker.VerifySignature(
-                                vchSig, CPubKey(vchPubKey), uint256(vchHash));
+                                vchSig, CPubKey(vchPubKey), messageHash);
                             metrics.nSigChecks += 1;
 
                             if (!fSuccess && (flags & SCRIPT_VERIFY_NULLFAIL)) {
@@ -1019,8 +1026,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
 
                         popstack(stack);
                         popstack(stack);
-                        popstack(stack);
-                        stack.push_back(fSuccess ? vchTrue : vchFalse);
+                        stacktop(-1) = fSuccess ? vchTrue : vchFalse;
                         if (opcode == OP_CHECKDATASIGVERIFY) {
                             if (fSuccess) {
                                 popstack(stack);
@@ -1249,12 +1255,13 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             }
                         }
 
-                        // Clean up stack of all arguments
-                        for (size_t i = 0; i < idxDummy; i++) {
+                        // Clean up stack of all arguments, reusing the last one
+                        // for the result.
+                        for (size_t i = 1; i < idxDummy; i++) {
                             popstack(stack);
                         }
 
-                        stack.push_back(fSuccess ? vchTrue : vchFalse);
+                        stacktop(-1) = fSuccess ? vchTrue : vchFalse;
                         if (opcode == OP_CHECKMULTISIGVERIFY) {
                             if (fSuccess) {
                                 popstack(stack);
@@ -1291,7 +1298,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
 
-                        const valtype &data = stacktop(-2);
+                        valtype &data = stacktop(-2);
 
                         // Make sure the split point is appropriate.
                         uint64_t position =
@@ -1301,14 +1308,12 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                              ScriptError::INVALID_SPLIT_RANGE);
                         }
 
-                        // Prepare the results in their own buffer as `data`
-                        // will be invalidated.
-                        valtype n1(data.begin(), data.begin() + position);
-                        valtype n2(data.begin() + position, data.end());
-
-                        // Replace existing stack values by the new values.
-                        stacktop(-2) = std::move(n1);
-                        stacktop(-1) = std::move(n2);
+                        // The position is replaced by the tail and the data
+                        // is truncated in place, so only the tail may need a
+                        // new buffer.
+                        stacktop(-1).assign(data.begin() + position,
+                                            data.end());
+                        data.erase(data.begin() + position, data.end());
                     } break;
 
                     case OP_REVERSEBYTES: {
@@ -1774,6 +1779,92 @@ bool GenericTransactionSignatureChecker<T>::CheckSequence(
 template class GenericTransactionSignatureChecker<CTransaction>;
 template class GenericTransactionSignatureChecker<CMutableTransaction>;
 
+/**
+ * Evaluate a scriptSig made of exactly two pushes, followed by a standard
+ *   OP_DUP OP_HASH160 <20 bytes> OP_EQUALVERIFY OP_CHECKSIG
+ * scriptPubKey, without going through the generic EvalScript loop. The
+ * resulting stack, metrics and error are the same as running both scripts
+ * through EvalScript.
+ *
+ * Returns std::nullopt if the scripts do not have that shape, or if a push
+ * would fail one of EvalScript's checks; the generic path must be used then.
+ */
+static std::optional<bool>
+EvalPayToPubKeyHash(const CScript &scriptSig, const CScript &scriptPubKey,
+                    uint32_t flags, const BaseSignatureChecker &checker,
+                    ScriptExecutionMetrics &metrics,
+                    std::vector<valtype> &stack, ScriptError *serror) {
+    static const valtype vchFalse(0);
+    static const valtype vchTrue(1, 1);
+
+    if (!scriptPubKey.IsPayToPubKeyHash() ||
+        scriptSig.size() > MAX_SCRIPT_SIZE) {
+        return std::nullopt;
+    }
+
+    valtype vchSig, vchPubKey;
+    CScript::const_iterator pc = scriptSig.begin();
+    opcodetype opcode;
+    for (valtype *push : {&vchSig, &vchPubKey}) {
+        if (!scriptSig.GetOp(pc, opcode, *push) || opcode > OP_PUSHDATA4 ||
+            push->size() > MAX_SCRIPT_ELEMENT_SIZE ||
+            ((flags & SCRIPT_VERIFY_MINIMALDATA) &&
+             !CheckMinimalPush(*push, opcode))) {
+            return std::nullopt;
+        }
+    }
+    if (pc != scriptSig.end()) {
+        return std::nullopt;
+    }
+
+    // OP_DUP OP_HASH160 <hash> OP_EQUALVERIFY
+    uint8_t pubKeyHash[CHash160::OUTPUT_SIZE];
+    CHash160().Write(vchPubKey).Finalize(pubKeyHash);
+    if (memcmp(pubKeyHash, &scriptPubKey[3], sizeof(pubKeyHash)) != 0) {
+        return set_error(serror, ScriptError::EQUALVERIFY);
+    }
+
+    // OP_CHECKSIG, with the whole scriptPubKey as script code.
+    bool fSuccess = false;
+    if (!EvalChecksig(vchSig, vchPubKey, scriptPubKey.begin(),
+                      scriptPubKey.end(), flags, checker, metrics, serror,
+                      fSuccess)) {
+        return false;
+    }
+
+    stack.assign(1, fSuccess ? vchTrue : vchFalse);
+    return true;
+}
+
+/**
+ * Evaluate a standard OP_HASH160 <20 bytes> OP_EQUAL scriptPubKey on the
+ * stack left by the scriptSig, with the same result as EvalScript.
+ */
+static bool EvalPayToScriptHash(std::vector<valtype> &stack,
+                                const CScript &scriptPubKey,
+                                ScriptError *serror) {
+    static const valtype vchFalse(0);
+    static const valtype vchTrue(1, 1);
+
+    assert(scriptPubKey.IsPayToScriptHash());
+    if (stack.empty()) {
+        return set_error(serror, ScriptError::INVALID_STACK_OPERATION);
+    }
+    // EvalScript pushes the expected hash before OP_EQUAL consumes it, so
+    // the stack is briefly one element larger.
+    if (stack.size() + 1 > MAX_STACK_SIZE) {
+        return set_error(serror, ScriptError::STACK_SIZE);
+    }
+
+    valtype &vch = stack.back();
+    uint8_t scriptHash[CHash160::OUTPUT_SIZE];
+    CHash160().Write(vch).Finalize(scriptHash);
+    const bool fEqual =
+        memcmp(scriptHash, &scriptPubKey[2], sizeof(scriptHash)) == 0;
+    vch = fEqual ? vchTrue : vchFalse;
+    return set_success(serror);
+}
+
 bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
                   uint32_t flags, const BaseSignatureChecker &checker,
                   ScriptExecutionMetrics &metricsOut, ScriptError *serror) {
@@ -1793,16 +1884,28 @@ bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
     // scriptSig and scriptPubKey must be evaluated sequentially on the same
     // stack rather than being simply concatenated (see CVE-2010-5141)
     std::vector<valtype> stack, stackCopy;
-    if (!EvalScript(stack, scriptSig, flags, checker, metrics, serror)) {
-        // serror is set
-        return false;
-    }
-    if (flags & SCRIPT_VERIFY_P2SH) {
-        stackCopy = stack;
-    }
-    if (!EvalScript(stack, scriptPubKey, flags, checker, metrics, serror)) {
-        // serror is set
-        return false;
+    if (const std::optional<bool> p2pkh_result =
+            EvalPayToPubKeyHash(scriptSig, scriptPubKey, flags, checker,
+                                metrics, stack, serror)) {
+        if (!*p2pkh_result) {
+            // serror is set
+            return false;
+        }
+    } else {
+        if (!EvalScript(stack, scriptSig, flags, checker, metrics, serror)) {
+            // serror is set
+            return false;
+        }
+        if (flags & SCRIPT_VERIFY_P2SH) {
+            stackCopy = stack;
+        }
+        if (!(scriptPubKey.IsPayToScriptHash()
+                  ? EvalPayToScriptHash(stack, scriptPubKey, serror)
+                  : EvalScript(stack, scriptPubKey, flags, checker, metrics,
+                               serror))) {
+            // serror is set
+            return false;
+        }
     }
     if (stack.empty()) {
         return set_error(serror, ScriptError::EVAL_FALSE);
@@ -370,6 +370,13 @@ bool CScriptNum::MinimallyEncode(std::vector<uint8_t> &data) {
     return true;
 }
 
+bool CScript::IsPayToPubKeyHash() const {
+    // Extra-fast test for pay-to-pubkey-hash CScripts:
+    return (this->size() == 25 && (*this)[0] == OP_DUP &&
+            (*this)[1] == OP_HASH160 && (*this)[2] == 0x14 &&
+            (*this)[23] == OP_EQUALVERIFY && (*this)[24] == OP_CHECKSIG);
+}
+
 bool CScript::IsPayToScriptHash() const {
     // Extra-fast test for pay-to-script-hash CScripts:
     return (this->size() == 23 && (*this)[0] == OP_HASH160 &&
@@ -72,6 +72,7 @@ public:
 static CuckooCache::cache<ScriptCacheElement, ScriptCacheHasher>
     g_scriptExecutionCache;
 static CSHA256 g_scriptExecutionCacheHasher;
+static ValidationCacheStats g_scriptExecutionCacheStats GUARDED_BY(cs_main);
 
 void InitScriptExecutionCache() {
     // Setup the salted hasher
@@ -90,6 +91,7 @@ void InitScriptExecutionCache() {
                  MAX_MAX_SCRIPT_CACHE_SIZE) *
         (size_t(1) << 20);
     size_t nElems = g_scriptExecutionCache.setup_bytes(nMaxCacheSize);
+    WITH_LOCK(cs_main, g_scriptExecutionCacheStats.max_entries = nElems);
     LogPrintf("Using %zu MiB out of %zu requested for script execution cache, "
               "able to store %zu elements\n",
               (nElems * sizeof(uint256)) >> 20, nMaxCacheSize >> 20, nElems);
@@ -114,6 +116,8 @@ bool IsKeyInScriptCache(ScriptCacheKey key, bool erase, int &nSigChecksOut) {
     ScriptCacheElement elem(key, 0);
     bool ret = g_scriptExecutionCache.get(elem, erase);
     nSigChecksOut = elem.nSigChecks;
+    ++(ret ? g_scriptExecutionCacheStats.hits
+           : g_scriptExecutionCacheStats.misses);
     return ret;
 }
 
@@ -123,5 +127,13 @@ void AddKeyInScriptCache(ScriptCacheKey key, int nSigChecks) {
     AssertLockHeld(cs_main);
 
     ScriptCacheElement elem(key, nSigChecks);
-    g_scriptExecutionCache.insert(elem);
+    ++g_scriptExecutionCacheStats.inserts;
+    if (g_scriptExecutionCache.insert(elem)) {
+        ++g_scriptExecutionCacheStats.evictions;
+    }
+}
+
+ValidationCacheStats GetScriptExecutionCacheStats() {
+    LOCK(cs_main);
+    return g_scriptExecutionCacheStats;
 }
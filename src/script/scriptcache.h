@@ -15,6 +15,7 @@
 extern RecursiveMutex cs_main;
 
 class CTransaction;
+struct ValidationCacheStats;
 
 /**
  * The script cache is a map using a key/value element, that caches the
@@ -65,4 +66,7 @@ bool IsKeyInScriptCache(ScriptCacheKey key, bool erase, int &nSigChecksOut)
 void AddKeyInScriptCache(ScriptCacheKey key, int nSigChecks)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/** Return the usage counters of the script execution cache since startup. */
+ValidationCacheStats GetScriptExecutionCacheStats();
+
 #endif // BITCOIN_SCRIPT_SCRIPTCACHE_H
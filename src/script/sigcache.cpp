@@ -14,22 +14,51 @@
 #include <boost/thread/lock_types.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
+#include <array>
+#include <atomic>
+
 namespace {
 
 /**
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
  * again when accepted into the block chain)
+ *
+ * The cache is split into independently locked shards so that script check
+ * threads inserting entries do not serialize on a single exclusive lock.
  */
 class CSignatureCache {
 private:
+    //! Number of shards, must be a power of two.
+    static constexpr size_t SHARD_COUNT = 16;
+    static_assert((SHARD_COUNT & (SHARD_COUNT - 1)) == 0,
+                  "SHARD_COUNT must be a power of two");
+
     //! Entries are SHA256(nonce || signature hash || public key || signature):
     CSHA256 m_salted_hasher;
     typedef CuckooCache::cache<CuckooCache::KeyOnly<uint256>,
                                SignatureCacheHasher>
         map_type;
-    map_type setValid;
-    boost::shared_mutex cs_sigcache;
+
+    //! Keep each shard on its own cache lines to avoid false sharing between
+    //! the locks and counters of neighbouring shards.
+    struct alignas(64) Shard {
+        map_type setValid;
+        boost::shared_mutex cs_sigcache;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> inserts{0};
+        std::atomic<uint64_t> evictions{0};
+    };
+    std::array<Shard, SHARD_COUNT> m_shards;
+    std::atomic<size_t> m_max_entries{0};
+
+    Shard &GetShard(const uint256 &entry) {
+        // The cuckoo cache maps each 32-bit word of the entry to a slot by
+        // multiplying it into the table size, which mostly uses the high
+        // bits. Use the low bits of the first byte to select the shard.
+        return m_shards[entry.begin()[0] & (SHARD_COUNT - 1)];
+    }
 
 public:
     CSignatureCache() {
@@ -52,15 +81,51 @@ public:
     }
 
     bool Get(const uint256 &entry, const bool erase) {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
-        return setValid.contains(entry, erase);
+        Shard &shard = GetShard(entry);
+        bool found;
+        {
+            boost::shared_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+            found = shard.setValid.contains(entry, erase);
+        }
+        (found ? shard.hits : shard.misses)
+            .fetch_add(1, std::memory_order_relaxed);
+        return found;
     }
 
     void Set(const uint256 &entry) {
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
+        Shard &shard = GetShard(entry);
+        bool evicted;
+        {
+            boost::unique_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+            evicted = shard.setValid.insert(entry);
+        }
+        shard.inserts.fetch_add(1, std::memory_order_relaxed);
+        if (evicted) {
+            shard.evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t setup_bytes(size_t n) {
+        size_t nElems = 0;
+        for (Shard &shard : m_shards) {
+            boost::unique_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+            nElems += shard.setValid.setup_bytes(n / SHARD_COUNT);
+        }
+        m_max_entries = nElems;
+        return nElems;
+    }
+
+    ValidationCacheStats GetStats() const {
+        ValidationCacheStats stats;
+        for (const Shard &shard : m_shards) {
+            stats.hits += shard.hits.load(std::memory_order_relaxed);
+            stats.misses += shard.misses.load(std::memory_order_relaxed);
+            stats.inserts += shard.inserts.load(std::memory_order_relaxed);
+            stats.evictions += shard.evictions.load(std::memory_order_relaxed);
+        }
+        stats.max_entries = m_max_entries;
+        return stats;
     }
-    uint32_t setup_bytes(size_t n) { return setValid.setup_bytes(n); }
 };
 
 /**
@@ -77,7 +142,7 @@ static CSignatureCache signatureCache;
 // signatureCache.
 void InitSignatureCache() {
     // nMaxCacheSize is unsigned. If -maxsigcachesize is set to zero,
-    // setup_bytes creates the minimum possible cache (2 elements).
+    // setup_bytes creates the minimum possible cache (2 elements per shard).
     size_t nMaxCacheSize =
         std::min(
             std::max(int64_t(0), gArgs.GetIntArg("-maxsigcachesize",
@@ -90,6 +155,10 @@ void InitSignatureCache() {
               (nElems * sizeof(uint256)) >> 20, nMaxCacheSize >> 20, nElems);
 }
 
+ValidationCacheStats GetSignatureCacheStats() {
+    return signatureCache.GetStats();
+}
+
 template <typename F>
 bool RunMemoizedCheck(const std::vector<uint8_t> &vchSig, const CPubKey &pubkey,
                       const uint256 &sighash, bool storeOrErase, const F &fun) {
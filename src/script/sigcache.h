@@ -9,6 +9,7 @@
 #include <script/interpreter.h>
 #include <util/hasher.h>
 
+#include <cstdint>
 #include <vector>
 
 // DoS prevention: limit cache size to 32MB (over 1000000 entries on 64-bit
@@ -28,10 +29,9 @@ private:
                   const uint256 &sighash) const;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction *txToIn,
-                                       unsigned int nInIn,
-                                       const Amount amountIn, bool storeIn,
-                                       PrecomputedTransactionData &txdataIn)
+    CachingTransactionSignatureChecker(
+        const CTransaction *txToIn, unsigned int nInIn, const Amount amountIn,
+        bool storeIn, const PrecomputedTransactionData &txdataIn)
         : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn),
           store(storeIn) {}
 
@@ -42,6 +42,23 @@ public:
     friend class TestCachingTransactionSignatureChecker;
 };
 
+/** Usage counters of a signature or script execution cache. */
+struct ValidationCacheStats {
+    //! Lookups that found a matching entry
+    uint64_t hits{0};
+    //! Lookups that did not find a matching entry
+    uint64_t misses{0};
+    //! Entries added to the cache
+    uint64_t inserts{0};
+    //! Inserts that dropped an entry because no free slot was found
+    uint64_t evictions{0};
+    //! Number of entries the cache can hold
+    size_t max_entries{0};
+};
+
 void InitSignatureCache();
 
+/** Return the usage counters of the signature cache since startup. */
+ValidationCacheStats GetSignatureCacheStats();
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
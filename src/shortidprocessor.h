@@ -93,6 +93,11 @@ public:
     /** Unique shortid count */
     size_t getShortIdCount() const { return shortIdIndexMap.size(); }
 
+    /** Whether the shortid is one of the supplied ones */
+    bool hasShortId(uint64_t shortid) const {
+        return shortIdIndexMap.count(shortid) != 0;
+    }
+
     /**
      * Attempts to add a known item by matching its shortid with the supplied
      * ones. The shortids must be processed prior from calling this method.
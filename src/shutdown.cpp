@@ -20,6 +20,8 @@
 bool AbortNode(const std::string &strMessage, bilingual_str user_message) {
     SetMiscWarning(Untranslated(strMessage));
     LogPrintf("*** %s\n", strMessage);
+    // Don't lose the log messages if the node doesn't shut down cleanly
+    LogInstance().Flush();
     if (user_message.empty()) {
         user_message =
             _("A fatal internal error occurred, see debug.log for details");
@@ -187,6 +187,57 @@ public:
     }
 };
 
+/**
+ * Minimal stream for reading from an existing span of bytes, which must
+ * outlive the reader.
+ */
+class SpanReader {
+private:
+    const int m_type;
+    const int m_version;
+    Span<const uint8_t> m_data;
+
+public:
+    /**
+     * @param[in]  type Serialization Type
+     * @param[in]  version Serialization Version (including any flags)
+     * @param[in]  data Referenced bytes to read from
+     */
+    SpanReader(int type, int version, Span<const uint8_t> data)
+        : m_type(type), m_version(version), m_data(data) {}
+
+    template <typename T> SpanReader &operator>>(T &obj) {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+
+    int GetVersion() const { return m_version; }
+    int GetType() const { return m_type; }
+
+    size_t size() const { return m_data.size(); }
+    bool empty() const { return m_data.empty(); }
+
+    void read(char *dst, size_t n) {
+        if (n == 0) {
+            return;
+        }
+
+        if (n > m_data.size()) {
+            throw std::ios_base::failure("SpanReader::read(): end of data");
+        }
+        memcpy(dst, m_data.data(), n);
+        m_data = m_data.subspan(n);
+    }
+
+    void ignore(size_t n) {
+        if (n > m_data.size()) {
+            throw std::ios_base::failure("SpanReader::ignore(): end of data");
+        }
+        m_data = m_data.subspan(n);
+    }
+};
+
 /**
  * Double ended buffer combining vector and stream-like interfaces.
  *
@@ -281,6 +332,7 @@ public:
     bool empty() const { return vch.size() == nReadPos; }
     void resize(size_type n, value_type c = 0) { vch.resize(n + nReadPos, c); }
     void reserve(size_type n) { vch.reserve(n + nReadPos); }
+    size_type capacity() const { return vch.capacity() - nReadPos; }
     const_reference operator[](size_type pos) const {
         return vch[pos + nReadPos];
     }
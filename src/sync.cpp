@@ -4,17 +4,21 @@
 
 #include <sync.h>
 
+#include <crypto/common.h>
 #include <logging.h>
 #include <tinyformat.h>
 #include <util/strencodings.h>
 #include <util/threadnames.h>
+#include <util/trace.h>
 
 #include <tinyformat.h>
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <system_error>
 #include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -293,3 +297,110 @@ bool LockStackEmpty() {
 bool g_debug_lockorder_abort = true;
 
 #endif /* DEBUG_LOCKORDER */
+
+namespace {
+/**
+ * The sampled lock sites, by the address of their mutex name and file
+ * strings. They are protected by a std::mutex, which is not profiled.
+ */
+struct LockProfileData {
+    using SiteKey = std::tuple<const char *, const char *, int>;
+
+    std::mutex m_mutex;
+    std::map<SiteKey, LockProfiler::SiteStats> m_sites;
+};
+
+LockProfileData &GetLockProfileData() {
+    // This approach guarantees that the object is not destroyed until after
+    // its last use, as mutexes may still be released during shutdown.
+    static LockProfileData &lock_profile_data = *new LockProfileData();
+    return lock_profile_data;
+}
+
+void AddTime(std::chrono::microseconds time, std::chrono::microseconds &total,
+             std::chrono::microseconds &max,
+             std::array<uint64_t, LockProfiler::NUM_TIME_BUCKETS> &histogram) {
+    total += time;
+    max = std::max(max, time);
+    ++histogram[std::min<uint64_t>(CountBits(time.count()),
+                                   LockProfiler::NUM_TIME_BUCKETS - 1)];
+}
+} // namespace
+
+void LockProfiler::Record(const char *mutex_name, const char *file, int line,
+                          std::chrono::steady_clock::duration wait_time,
+                          std::chrono::steady_clock::duration hold_time,
+                          bool contended) {
+    const auto wait_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(wait_time);
+    const auto hold_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(hold_time);
+    TRACE6(sync, lock_sample, mutex_name, file, line, wait_us.count(),
+           hold_us.count(), contended);
+
+    LockProfileData &data = GetLockProfileData();
+    std::lock_guard<std::mutex> lock(data.m_mutex);
+    auto [it, inserted] = data.m_sites.try_emplace({mutex_name, file, line});
+    SiteStats &stats = it->second;
+    if (inserted) {
+        stats.mutex_name = mutex_name;
+        stats.file = file;
+        stats.line = line;
+    }
+    ++stats.samples;
+    if (contended) {
+        ++stats.contended;
+    }
+    AddTime(wait_us, stats.total_wait_time, stats.max_wait_time,
+            stats.wait_histogram);
+    AddTime(hold_us, stats.total_hold_time, stats.max_hold_time,
+            stats.hold_histogram);
+}
+
+std::vector<LockProfiler::SiteStats> LockProfiler::GetStats(bool reset) {
+    LockProfileData &data = GetLockProfileData();
+    std::map<LockProfileData::SiteKey, SiteStats> sites;
+    {
+        std::lock_guard<std::mutex> lock(data.m_mutex);
+        if (reset) {
+            sites.swap(data.m_sites);
+        } else {
+            sites = data.m_sites;
+        }
+    }
+
+    // The same lock site may be seen through several copies of its strings,
+    // e.g. when it is in a header.
+    std::map<std::tuple<std::string, std::string, int>, SiteStats> merged;
+    for (const auto &[key, site] : sites) {
+        auto [it, inserted] =
+            merged.try_emplace({site.mutex_name, site.file, site.line}, site);
+        if (inserted) {
+            continue;
+        }
+        SiteStats &stats = it->second;
+        stats.samples += site.samples;
+        stats.contended += site.contended;
+        stats.total_wait_time += site.total_wait_time;
+        stats.max_wait_time = std::max(stats.max_wait_time, site.max_wait_time);
+        stats.total_hold_time += site.total_hold_time;
+        stats.max_hold_time = std::max(stats.max_hold_time, site.max_hold_time);
+        for (size_t i = 0; i < NUM_TIME_BUCKETS; i++) {
+            stats.wait_histogram[i] += site.wait_histogram[i];
+            stats.hold_histogram[i] += site.hold_histogram[i];
+        }
+    }
+
+    std::vector<SiteStats> stats;
+    stats.reserve(merged.size());
+    for (auto &[key, site] : merged) {
+        stats.push_back(std::move(site));
+    }
+    return stats;
+}
+
+void LockProfiler::Reset() {
+    LockProfileData &data = GetLockProfileData();
+    std::lock_guard<std::mutex> lock(data.m_mutex);
+    data.m_sites.clear();
+}
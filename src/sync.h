@@ -14,10 +14,16 @@
 #include <threadsafety.h>
 #include <util/macros.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 /////////////////////////////////////////////////
 //                                             //
@@ -132,21 +138,193 @@ using RecursiveMutex = AnnotatedMixin<std::recursive_mutex>;
 /** Wrapped mutex: supports waiting but not recursive locking */
 typedef AnnotatedMixin<std::mutex> Mutex;
 
+/**
+ * Measure how long the current thread holds a mutex through LOCK and its
+ * variants, for as long as the timer exists, e.g. to attribute the time cs_main
+ * is held to the work done by the thread. Only the outermost lock of a
+ * recursive mutex counts, and a mutex already held as the timer is created is
+ * not accounted for until it is released. The waits on a condition variable
+ * through UniqueLock::Wait() and its variants don't count. Only the innermost
+ * timer of a thread is updated.
+ */
+class LockHoldTimer {
+public:
+    explicit LockHoldTimer(const void *mutex)
+        : m_mutex(mutex), m_prev(g_current) {
+        g_current = this;
+    }
+    ~LockHoldTimer() { g_current = m_prev; }
+
+    LockHoldTimer(const LockHoldTimer &) = delete;
+    LockHoldTimer &operator=(const LockHoldTimer &) = delete;
+
+    std::chrono::microseconds GetHeldTime() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(m_held);
+    }
+
+    //! Called as the current thread acquires a mutex
+    static void Acquired(const void *mutex) {
+        LockHoldTimer *timer = g_current;
+        if (timer && timer->m_mutex == mutex && timer->m_depth++ == 0) {
+            timer->m_locked_since = std::chrono::steady_clock::now();
+        }
+    }
+
+    //! Called as the current thread releases a mutex
+    static void Released(const void *mutex) {
+        LockHoldTimer *timer = g_current;
+        if (timer && timer->m_mutex == mutex && timer->m_depth > 0 &&
+            --timer->m_depth == 0) {
+            timer->m_held +=
+                std::chrono::steady_clock::now() - timer->m_locked_since;
+        }
+    }
+
+private:
+    static inline thread_local LockHoldTimer *g_current{nullptr};
+
+    const void *const m_mutex;
+    LockHoldTimer *const m_prev;
+    int m_depth{0};
+    std::chrono::steady_clock::time_point m_locked_since;
+    std::chrono::steady_clock::duration m_held{0};
+};
+
+/** Default for -lockprofile */
+static constexpr uint32_t DEFAULT_LOCK_PROFILE_SAMPLE_RATE{0};
+
+/**
+ * Lock contention profiler (-lockprofile). One in every sample rate
+ * acquisitions made by a thread through LOCK and its variants is timed, and
+ * the time spent waiting for the mutex and holding it is accumulated per lock
+ * site. With a sample rate of 0 the profiler is disabled and only costs a
+ * relaxed atomic load per acquisition. A wait on a condition variable through
+ * UniqueLock::Wait() and its variants ends the sample.
+ */
+class LockProfiler {
+public:
+    //! Number of histogram buckets, the last one counts all the longer times
+    static constexpr size_t NUM_TIME_BUCKETS = 24;
+
+    /** Sampled acquisitions of a lock site */
+    struct SiteStats {
+        std::string mutex_name;
+        std::string file;
+        int line{0};
+        uint64_t samples{0};
+        //! Samples for which the mutex was held by another thread
+        uint64_t contended{0};
+        std::chrono::microseconds total_wait_time{0};
+        std::chrono::microseconds max_wait_time{0};
+        std::chrono::microseconds total_hold_time{0};
+        std::chrono::microseconds max_hold_time{0};
+        //! Bucket i counts the times below 2^i microseconds
+        std::array<uint64_t, NUM_TIME_BUCKETS> wait_histogram{};
+        std::array<uint64_t, NUM_TIME_BUCKETS> hold_histogram{};
+    };
+
+    /** An acquisition being timed, recorded as the mutex is released */
+    class Sample {
+    public:
+        //! Whether the next acquisition of the current thread is sampled
+        static bool Take() {
+            const uint32_t rate = g_sample_rate.load(std::memory_order_relaxed);
+            if (rate == 0) {
+                return false;
+            }
+            static thread_local uint32_t count{0};
+            if (++count < rate) {
+                return false;
+            }
+            count = 0;
+            return true;
+        }
+
+        void Start(const char *mutex_name, const char *file, int line) {
+            m_mutex_name = mutex_name;
+            m_file = file;
+            m_line = line;
+            m_start = std::chrono::steady_clock::now();
+        }
+
+        void Acquired(bool contended) {
+            m_contended = contended;
+            m_acquired = std::chrono::steady_clock::now();
+        }
+
+        //! Record the sample, if any, as the mutex is released
+        void Released() {
+            if (!m_mutex_name) {
+                return;
+            }
+            Record(m_mutex_name, m_file, m_line, m_acquired - m_start,
+                   std::chrono::steady_clock::now() - m_acquired, m_contended);
+            m_mutex_name = nullptr;
+        }
+
+    private:
+        const char *m_mutex_name{nullptr};
+        const char *m_file{nullptr};
+        int m_line{0};
+        bool m_contended{false};
+        std::chrono::steady_clock::time_point m_start;
+        std::chrono::steady_clock::time_point m_acquired;
+    };
+
+    //! Sample one in rate acquisitions, or none if 0
+    static void SetSampleRate(uint32_t rate) {
+        g_sample_rate.store(rate, std::memory_order_relaxed);
+    }
+    static uint32_t GetSampleRate() {
+        return g_sample_rate.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Statistics of the lock sites sampled so far. With reset, they are
+     * cleared in the same step, so no sample is lost or counted twice.
+     */
+    static std::vector<SiteStats> GetStats(bool reset = false);
+    static void Reset();
+
+private:
+    static inline std::atomic<uint32_t> g_sample_rate{
+        DEFAULT_LOCK_PROFILE_SAMPLE_RATE};
+
+    static void Record(const char *mutex_name, const char *file, int line,
+                       std::chrono::steady_clock::duration wait_time,
+                       std::chrono::steady_clock::duration hold_time,
+                       bool contended);
+};
+
 /** Wrapper around std::unique_lock style lock for Mutex. */
 template <typename Mutex, typename Base = typename Mutex::UniqueLock>
 class SCOPED_LOCKABLE UniqueLock : public Base {
 private:
+    LockProfiler::Sample m_profile_sample;
+
     void Enter(const char *pszName, const char *pszFile, int nLine) {
         EnterCritical(pszName, pszFile, nLine, (void *)(Base::mutex()));
-#ifdef DEBUG_LOCKCONTENTION
-        if (Base::try_lock()) {
+        if (LockProfiler::Sample::Take()) {
+            m_profile_sample.Start(pszName, pszFile, nLine);
+            const bool contended = !Base::try_lock();
+            if (contended) {
+                Base::lock();
+            }
+            m_profile_sample.Acquired(contended);
+            LockHoldTimer::Acquired(Base::mutex());
             return;
         }
-        LOG_TIME_MICROS_WITH_CATEGORY(
-            strprintf("lock contention %s, %s:%d", pszName, pszFile, nLine),
-            BCLog::LOCK);
-#endif
+#ifdef DEBUG_LOCKCONTENTION
+        if (!Base::try_lock()) {
+            LOG_TIME_MICROS_WITH_CATEGORY(
+                strprintf("lock contention %s, %s:%d", pszName, pszFile, nLine),
+                BCLog::LOCK);
+            Base::lock();
+        }
+#else
         Base::lock();
+#endif
+        LockHoldTimer::Acquired(Base::mutex());
     }
 
     bool TryEnter(const char *pszName, const char *pszFile, int nLine) {
@@ -154,8 +332,14 @@ private:
         Base::try_lock();
         if (!Base::owns_lock()) {
             LeaveCritical();
+            return false;
+        }
+        if (LockProfiler::Sample::Take()) {
+            m_profile_sample.Start(pszName, pszFile, nLine);
+            m_profile_sample.Acquired(/*contended=*/false);
         }
-        return Base::owns_lock();
+        LockHoldTimer::Acquired(Base::mutex());
+        return true;
     }
 
 public:
@@ -185,12 +369,54 @@ public:
 
     ~UniqueLock() UNLOCK_FUNCTION() {
         if (Base::owns_lock()) {
+            m_profile_sample.Released();
+            LockHoldTimer::Released(Base::mutex());
             LeaveCritical();
         }
     }
 
     operator bool() { return Base::owns_lock(); }
 
+    /**
+     * Wait on a condition variable with cv.wait(), cv.wait_for() or
+     * cv.wait_until(). The mutex is released during the wait, which is not
+     * counted as held by the lock profiler nor the LockHoldTimer, and its
+     * re-acquisition by the wait is not sampled.
+     */
+    template <typename CV, typename... Args> void Wait(CV &cv, Args &&...args) {
+        WaitScope scope(*this);
+        cv.wait(static_cast<Base &>(*this), std::forward<Args>(args)...);
+    }
+    template <typename CV, typename... Args>
+    auto WaitFor(CV &cv, Args &&...args) {
+        WaitScope scope(*this);
+        return cv.wait_for(static_cast<Base &>(*this),
+                           std::forward<Args>(args)...);
+    }
+    template <typename CV, typename... Args>
+    auto WaitUntil(CV &cv, Args &&...args) {
+        WaitScope scope(*this);
+        return cv.wait_until(static_cast<Base &>(*this),
+                             std::forward<Args>(args)...);
+    }
+
+private:
+    /** Account for the mutex as released for the duration of a wait */
+    class WaitScope {
+    public:
+        explicit WaitScope(UniqueLock &lock) : m_lock(lock) {
+            m_lock.m_profile_sample.Released();
+            LockHoldTimer::Released(m_lock.mutex());
+        }
+        ~WaitScope() { LockHoldTimer::Acquired(m_lock.mutex()); }
+
+        WaitScope(const WaitScope &) = delete;
+        WaitScope &operator=(const WaitScope &) = delete;
+
+    private:
+        UniqueLock &m_lock;
+    };
+
 protected:
     // needed for reverse_lock
     UniqueLock() {}
@@ -207,6 +433,8 @@ public:
             : lock(_lock), file(_file), line(_line) {
             CheckLastCritical((void *)lock.mutex(), lockname, _guardname, _file,
                               _line);
+            lock.m_profile_sample.Released();
+            LockHoldTimer::Released(lock.mutex());
             lock.unlock();
             LeaveCritical();
             lock.swap(templock);
@@ -217,6 +445,7 @@ public:
             EnterCritical(lockname.c_str(), file.c_str(), line,
                           (void *)lock.mutex());
             lock.lock();
+            LockHoldTimer::Acquired(lock.mutex());
         }
 
     private:
@@ -509,7 +509,7 @@ BOOST_AUTO_TEST_CASE(caddrinfo_get_tried_bucket_legacy) {
     uint256 nKey2 = (uint256)(CHashWriter(SER_GETHASH, 0) << 2).GetHash();
 
     // use /16
-    std::vector<bool> asmap;
+    const CompiledAsmap asmap;
 
     BOOST_CHECK_EQUAL(info1.GetTriedBucket(nKey1, asmap), 40);
 
@@ -565,7 +565,7 @@ BOOST_AUTO_TEST_CASE(caddrinfo_get_new_bucket_legacy) {
     uint256 nKey2 = (uint256)(CHashWriter(SER_GETHASH, 0) << 2).GetHash();
 
     // use /16
-    std::vector<bool> asmap;
+    const CompiledAsmap asmap;
 
     // Test: Make sure the buckets are what we expect
     BOOST_CHECK_EQUAL(info1.GetNewBucket(nKey1, asmap), 786);
@@ -645,7 +645,7 @@ BOOST_AUTO_TEST_CASE(caddrinfo_get_tried_bucket) {
     uint256 nKey1 = (uint256)(CHashWriter(SER_GETHASH, 0) << 1).GetHash();
     uint256 nKey2 = (uint256)(CHashWriter(SER_GETHASH, 0) << 2).GetHash();
 
-    std::vector<bool> asmap = FromBytes(asmap_raw, sizeof(asmap_raw) * 8);
+    const CompiledAsmap asmap{FromBytes(asmap_raw, sizeof(asmap_raw) * 8)};
 
     BOOST_CHECK_EQUAL(info1.GetTriedBucket(nKey1, asmap), 236);
 
@@ -700,7 +700,7 @@ BOOST_AUTO_TEST_CASE(caddrinfo_get_new_bucket) {
     uint256 nKey1 = (uint256)(CHashWriter(SER_GETHASH, 0) << 1).GetHash();
     uint256 nKey2 = (uint256)(CHashWriter(SER_GETHASH, 0) << 2).GetHash();
 
-    std::vector<bool> asmap = FromBytes(asmap_raw, sizeof(asmap_raw) * 8);
+    const CompiledAsmap asmap{FromBytes(asmap_raw, sizeof(asmap_raw) * 8)};
 
     // Test: Make sure the buckets are what we expect
     BOOST_CHECK_EQUAL(info1.GetNewBucket(nKey1, asmap), 795);
@@ -768,6 +768,36 @@ BOOST_AUTO_TEST_CASE(caddrinfo_get_new_bucket) {
     BOOST_CHECK(buckets.size() == 1);
 }
 
+BOOST_AUTO_TEST_CASE(compiled_asmap) {
+    const std::vector<bool> asmap =
+        FromBytes(asmap_raw, sizeof(asmap_raw) * 8);
+    const CompiledAsmap compiled{asmap};
+    BOOST_CHECK(!compiled.empty());
+    BOOST_CHECK(compiled.CheckEquivalence(asmap));
+
+    for (const auto &[ip, asn] :
+         std::vector<std::pair<std::string, uint32_t>>{
+             {"250.1.1.1", 1000},
+             {"101.1.0.1", 1},
+             {"101.8.255.255", 8},
+             {"1.2.3.4", 0},
+             {"2001:db8::1", 0},
+         }) {
+        const CNetAddr addr = ResolveIP(ip);
+        BOOST_CHECK_EQUAL(addr.GetMappedAS(compiled), asn);
+        BOOST_CHECK_EQUAL(addr.GetMappedAS(asmap), asn);
+    }
+
+    // Nothing is mapped without an asmap, or with a truncated one
+    BOOST_CHECK(CompiledAsmap{}.empty());
+    BOOST_CHECK(CompiledAsmap{std::vector<bool>{}}.CheckEquivalence({}));
+    const std::vector<bool> truncated(asmap.begin(), asmap.end() - 32);
+    BOOST_CHECK(CompiledAsmap{truncated}.empty());
+    BOOST_CHECK_EQUAL(ResolveIP("250.1.1.1").GetMappedAS(
+                          CompiledAsmap{truncated}),
+                      0U);
+}
+
 BOOST_AUTO_TEST_CASE(addrman_serialization) {
     std::vector<bool> asmap1 = FromBytes(asmap_raw, sizeof(asmap_raw) * 8);
 
@@ -5,6 +5,7 @@
 #include <chainparams.h>
 #include <config.h>
 #include <consensus/consensus.h>
+#include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <validation.h>
 
@@ -100,4 +101,70 @@ BOOST_AUTO_TEST_CASE(blockfail) {
     RunCheckOnBlock(config, block, "bad-blk-length");
 }
 
+BOOST_FIXTURE_TEST_CASE(large_block, TestChain100Setup) {
+    // Enough transactions for the checks to be split in several chunks, plus
+    // the coinbase so the block has an odd number of transactions.
+    std::vector<CMutableTransaction> txns(3 * 4096);
+    for (CMutableTransaction &tx : txns) {
+        tx.vin.resize(1);
+        tx.vin[0].prevout = InsecureRandOutPoint();
+        tx.vin[0].scriptSig.resize(100);
+        tx.vout.resize(1);
+        tx.vout[0].nValue = 42 * SATOSHI;
+    }
+
+    const Config &config = GetConfig();
+    const Consensus::Params &params = config.GetChainParams().GetConsensus();
+    CChainState &chainstate = m_node.chainman->ActiveChainstate();
+    const CBlock block = CreateBlock(txns, CScript() << OP_TRUE, chainstate);
+    BOOST_CHECK_EQUAL(block.vtx.size() % 2, 1U);
+
+    const auto check_block = [&](const CBlock &block,
+                                 const std::string &reason) {
+        block.fChecked = false;
+        BlockValidationState state;
+        BOOST_CHECK_EQUAL(
+            CheckBlock(block, state, params,
+                       BlockValidationOptions(config).withCheckPoW(false)),
+            reason.empty());
+        BOOST_CHECK_EQUAL(state.GetRejectReason(), reason);
+    };
+    // The transactions inputs don't exist, so the contextual checks pass iff
+    // the failure comes from ConnectBlock.
+    const auto test_block_validity = [&](const CBlock &block,
+                                         const std::string &reason) {
+        LOCK(cs_main);
+        BlockValidationState state;
+        BOOST_CHECK(!TestBlockValidity(
+            state, config.GetChainParams(), chainstate, block,
+            chainstate.m_chain.Tip(),
+            BlockValidationOptions(config).withCheckPoW(false)));
+        BOOST_CHECK_EQUAL(state.GetRejectReason(), reason);
+    };
+
+    check_block(block, "");
+    test_block_validity(block, "bad-txns-inputs-missingorspent");
+
+    // Repeating the last transaction doesn't change the merkle root.
+    CBlock mutated_block = block;
+    mutated_block.vtx.push_back(mutated_block.vtx.back());
+    check_block(mutated_block, "bad-txns-duplicate");
+
+    // Invalid transaction in the middle of the block.
+    CBlock invalid_block = block;
+    CMutableTransaction invalid_tx(*invalid_block.vtx[5000]);
+    invalid_tx.vout.clear();
+    invalid_block.vtx[5000] = MakeTransactionRef(invalid_tx);
+    invalid_block.hashMerkleRoot = BlockMerkleRoot(invalid_block);
+    check_block(invalid_block, "bad-txns-vout-empty");
+
+    // Unordered transactions at the end of the block.
+    CBlock unordered_block = block;
+    std::swap(unordered_block.vtx[block.vtx.size() - 1],
+              unordered_block.vtx[block.vtx.size() - 2]);
+    unordered_block.hashMerkleRoot = BlockMerkleRoot(unordered_block);
+    check_block(unordered_block, "");
+    test_block_validity(unordered_block, "tx-ordering");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
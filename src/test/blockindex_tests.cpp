@@ -11,6 +11,8 @@
 #include <boost/test/unit_test.hpp>
 
 #include <limits>
+#include <set>
+#include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(blockindex_tests, BasicTestingSetup)
 
@@ -463,4 +465,46 @@ BOOST_AUTO_TEST_CASE(index_assumevalid_tests) {
         }
     }
 }
+
+BOOST_AUTO_TEST_CASE(block_index_arena) {
+    BlockIndexArena arena;
+    BOOST_CHECK_EQUAL(arena.size(), 0U);
+    BOOST_CHECK_EQUAL(arena.DynamicMemoryUsage(), 0U);
+
+    // Span several chunks to check entries are not reused across chunks.
+    const size_t count = 2 * BlockIndexArena::CHUNK_SIZE + 1;
+    std::vector<CBlockIndex *> entries;
+    for (size_t i = 0; i < count; i++) {
+        CBlockIndex *entry = arena.Allocate();
+        BOOST_CHECK(entry->pprev == nullptr);
+        BOOST_CHECK_EQUAL(entry->nHeight, 0);
+        entry->nHeight = i;
+        entry->pprev = entries.empty() ? nullptr : entries.back();
+        entries.push_back(entry);
+    }
+    BOOST_CHECK_EQUAL(arena.size(), count);
+    BOOST_CHECK_EQUAL(std::set<CBlockIndex *>(entries.begin(), entries.end())
+                          .size(),
+                      count);
+    BOOST_CHECK(arena.DynamicMemoryUsage() >= count * sizeof(CBlockIndex));
+
+    // Entries keep their address while the arena grows.
+    for (size_t i = 0; i < count; i++) {
+        BOOST_CHECK_EQUAL(entries[i]->nHeight, int(i));
+        BOOST_CHECK(entries[i]->pprev == (i ? entries[i - 1] : nullptr));
+    }
+
+    arena.Clear();
+    BOOST_CHECK_EQUAL(arena.size(), 0U);
+
+    arena.Reserve(BlockIndexArena::CHUNK_SIZE + 1);
+    const size_t reserved_usage = arena.DynamicMemoryUsage();
+    BOOST_CHECK(reserved_usage >=
+                2 * BlockIndexArena::CHUNK_SIZE * sizeof(CBlockIndex));
+    for (size_t i = 0; i <= BlockIndexArena::CHUNK_SIZE; i++) {
+        BOOST_CHECK_EQUAL(arena.Allocate()->nHeight, 0);
+    }
+    BOOST_CHECK_EQUAL(arena.DynamicMemoryUsage(), reserved_usage);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,237 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockreconciliation.h>
+
+#include <chainparams.h>
+#include <config.h>
+#include <consensus/merkle.h>
+#include <pow/pow.h>
+#include <streams.h>
+#include <txmempool.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+BOOST_FIXTURE_TEST_SUITE(blockreconciliation_tests, RegTestingSetup)
+
+static CTransactionRef RandomTransaction() {
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(TxId(InsecureRand256()), 0);
+    tx.vin[0].scriptSig.resize(10);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 42 * SATOSHI;
+    return MakeTransactionRef(tx);
+}
+
+static CBlock BuildCanonicalBlock(size_t tx_count) {
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig.resize(10);
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = 42 * SATOSHI;
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    block.nVersion = 42;
+    block.hashPrevBlock = BlockHash(InsecureRand256());
+    block.nBits = 0x207fffff;
+
+    for (size_t i = 0; i < tx_count; i++) {
+        block.vtx.push_back(RandomTransaction());
+    }
+    std::sort(block.vtx.begin() + 1, block.vtx.end(),
+              [](const CTransactionRef &a, const CTransactionRef &b) {
+                  return a->GetId() < b->GetId();
+              });
+
+    bool mutated;
+    block.hashMerkleRoot = BlockMerkleRoot(block, &mutated);
+    assert(!mutated);
+
+    const Consensus::Params &params =
+        GetConfig().GetChainParams().GetConsensus();
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, params)) {
+        ++block.nNonce;
+    }
+
+    return block;
+}
+
+static CBlockHeaderAndReconciliation
+RoundTrip(const CBlockHeaderAndReconciliation &reconblock) {
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << reconblock;
+    CBlockHeaderAndReconciliation reconblock2;
+    stream >> reconblock2;
+    return reconblock2;
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter) {
+    ShortIdBloomFilter empty;
+    BOOST_CHECK(empty.IsEmpty());
+    BOOST_CHECK(empty.contains(g_insecure_rand_ctx.rand64()));
+
+    std::vector<uint64_t> shortids(1000);
+    for (uint64_t &shortid : shortids) {
+        shortid = g_insecure_rand_ctx.rand64() & 0xffffffffffffULL;
+    }
+
+    ShortIdBloomFilter filter(shortids.size(), 0.01);
+    for (const uint64_t shortid : shortids) {
+        filter.insert(shortid);
+    }
+    for (const uint64_t shortid : shortids) {
+        BOOST_CHECK(filter.contains(shortid));
+    }
+
+    size_t false_positives = 0;
+    for (size_t i = 0; i < 10000; i++) {
+        const uint64_t shortid =
+            g_insecure_rand_ctx.rand64() & 0xffffffffffffULL;
+        false_positives += filter.contains(shortid);
+    }
+    BOOST_CHECK(false_positives < 200);
+}
+
+BOOST_AUTO_TEST_CASE(iblt_list_entries) {
+    ShortIdIBLT a(50), b(50);
+    BOOST_CHECK_EQUAL(a.size() % ShortIdIBLT::NUM_HASHES, 0U);
+
+    // 1000 shortids in common, 20 only in a and 30 only in b.
+    std::vector<uint64_t> only_a, only_b;
+    for (size_t i = 0; i < 1050; i++) {
+        const uint64_t shortid =
+            g_insecure_rand_ctx.rand64() & 0xffffffffffffULL;
+        if (i < 1000) {
+            a.insert(shortid);
+            b.insert(shortid);
+        } else if (i < 1020) {
+            a.insert(shortid);
+            only_a.push_back(shortid);
+        } else {
+            b.insert(shortid);
+            only_b.push_back(shortid);
+        }
+    }
+
+    BOOST_CHECK(!ShortIdIBLT(10).Subtract(a));
+    BOOST_CHECK(a.Subtract(b));
+
+    std::vector<uint64_t> positive, negative;
+    BOOST_CHECK(a.ListEntries(positive, negative));
+    std::sort(only_a.begin(), only_a.end());
+    std::sort(only_b.begin(), only_b.end());
+    std::sort(positive.begin(), positive.end());
+    std::sort(negative.begin(), negative.end());
+    BOOST_CHECK(positive == only_a);
+    BOOST_CHECK(negative == only_b);
+
+    // Erasing is the same as subtracting.
+    for (const uint64_t shortid : only_a) {
+        a.erase(shortid);
+    }
+    for (const uint64_t shortid : only_b) {
+        a.insert(shortid);
+    }
+    positive.clear();
+    negative.clear();
+    BOOST_CHECK(a.ListEntries(positive, negative));
+    BOOST_CHECK(positive.empty() && negative.empty());
+
+    // A table that is too small for the difference cannot be decoded.
+    ShortIdIBLT small(0);
+    for (size_t i = 0; i < 1000; i++) {
+        small.insert(g_insecure_rand_ctx.rand64() & 0xffffffffffffULL);
+    }
+    BOOST_CHECK(!small.ListEntries(positive, negative));
+}
+
+BOOST_AUTO_TEST_CASE(reconcile_block) {
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+    const CBlock block = BuildCanonicalBlock(500);
+    const std::vector<std::pair<TxHash, CTransactionRef>> no_extra_txn;
+
+    LOCK2(cs_main, pool.cs);
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        pool.addUnchecked(entry.FromTx(block.vtx[i]));
+    }
+    // Unrelated transactions the filter has to weed out.
+    for (size_t i = 0; i < 5000; i++) {
+        pool.addUnchecked(entry.FromTx(RandomTransaction()));
+    }
+
+    const CBlockHeaderAndShortTxIDs cmpctblock(block);
+    const CBlockHeaderAndReconciliation reconblock =
+        RoundTrip(CBlockHeaderAndReconciliation(cmpctblock, pool.size()));
+    BOOST_CHECK_EQUAL(reconblock.BlockTxCount(), block.vtx.size());
+    BOOST_CHECK(GetSerializeSize(reconblock, PROTOCOL_VERSION) <
+                GetSerializeSize(cmpctblock, PROTOCOL_VERSION));
+
+    {
+        CBlock block2;
+        BOOST_CHECK(reconblock.FillBlock(GetConfig(), pool, no_extra_txn,
+                                         block2) == READ_STATUS_OK);
+        BOOST_CHECK_EQUAL(block.GetHash().ToString(),
+                          block2.GetHash().ToString());
+        BOOST_CHECK_EQUAL(block.vtx.size(), block2.vtx.size());
+        bool mutated;
+        BOOST_CHECK_EQUAL(block.hashMerkleRoot.ToString(),
+                          BlockMerkleRoot(block2, &mutated).ToString());
+        BOOST_CHECK(!mutated);
+    }
+
+    // Once a transaction is missing from the mempool, the block can only be
+    // reconciled if it is available in the extra transactions.
+    pool.removeRecursive(*block.vtx[42], MemPoolRemovalReason::REPLACED);
+    {
+        CBlock block2;
+        BOOST_CHECK(reconblock.FillBlock(GetConfig(), pool, no_extra_txn,
+                                         block2) == READ_STATUS_FAILED);
+    }
+    {
+        const std::vector<std::pair<TxHash, CTransactionRef>> extra_txn{
+            {block.vtx[42]->GetHash(), block.vtx[42]}};
+        CBlock block2;
+        BOOST_CHECK(reconblock.FillBlock(GetConfig(), pool, extra_txn,
+                                         block2) == READ_STATUS_OK);
+        BOOST_CHECK_EQUAL(block.GetHash().ToString(),
+                          block2.GetHash().ToString());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(reconcile_block_small_mempool) {
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+    const CBlock block = BuildCanonicalBlock(100);
+    const std::vector<std::pair<TxHash, CTransactionRef>> no_extra_txn;
+
+    LOCK2(cs_main, pool.cs);
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        pool.addUnchecked(entry.FromTx(block.vtx[i]));
+    }
+
+    // Without excess transactions in the receiver's mempool there is no need
+    // for a filter, only a tiny table is sent.
+    const CBlockHeaderAndShortTxIDs cmpctblock(block);
+    const CBlockHeaderAndReconciliation reconblock =
+        RoundTrip(CBlockHeaderAndReconciliation(cmpctblock, pool.size()));
+
+    CBlock block2;
+    BOOST_CHECK(reconblock.FillBlock(GetConfig(), pool, no_extra_txn,
+                                     block2) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(block.GetHash().ToString(),
+                          block2.GetHash().ToString());
+
+    // Bogus sizes are rejected.
+    CBlockHeaderAndReconciliation empty;
+    BOOST_CHECK(empty.FillBlock(GetConfig(), pool, no_extra_txn, block2) ==
+                READ_STATUS_INVALID);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1168,4 +1168,84 @@ BOOST_AUTO_TEST_CASE(rolling_bloom) {
     g_mock_deterministic_tests = false;
 }
 
+BOOST_AUTO_TEST_CASE(blocked_rolling_bloom) {
+    SeedInsecureRand(SeedRand::ZEROS);
+    g_mock_deterministic_tests = true;
+
+    // last-100-entry, 1% false positive:
+    CBlockedRollingBloomFilter rb1(100, 0.01);
+
+    // Overfill:
+    static const int DATASIZE = 399;
+    std::vector<uint8_t> data[DATASIZE];
+    for (int i = 0; i < DATASIZE; i++) {
+        data[i] = RandomData();
+        rb1.insert(data[i]);
+    }
+    // Last 100 guaranteed to be remembered:
+    for (int i = 299; i < DATASIZE; i++) {
+        BOOST_CHECK(rb1.contains(data[i]));
+    }
+
+    // Worst-case false positive behavior, as in the rolling_bloom test.
+    unsigned int nHits = 0;
+    for (int i = 0; i < 10000; i++) {
+        if (rb1.contains(RandomData())) {
+            ++nHits;
+        }
+    }
+    // Expect about 100 hits
+    BOOST_CHECK_EQUAL(nHits, 85U);
+
+    BOOST_CHECK(rb1.contains(data[DATASIZE - 1]));
+    rb1.reset();
+    BOOST_CHECK(!rb1.contains(data[DATASIZE - 1]));
+
+    // Now roll through data, make sure last 100 entries
+    // are always remembered:
+    for (int i = 0; i < DATASIZE; i++) {
+        if (i >= 100) {
+            BOOST_CHECK(rb1.contains(data[i - 100]));
+        }
+        rb1.insert(data[i]);
+        BOOST_CHECK(rb1.contains(data[i]));
+    }
+
+    // Insert 999 more random entries:
+    for (int i = 0; i < 999; i++) {
+        std::vector<uint8_t> d = RandomData();
+        rb1.insert(d);
+        BOOST_CHECK(rb1.contains(d));
+    }
+    // Sanity check to make sure the filter isn't just filling up:
+    nHits = 0;
+    for (int i = 0; i < DATASIZE; i++) {
+        if (rb1.contains(data[i])) {
+            ++nHits;
+        }
+    }
+    // Expect about 5 false positives
+    BOOST_CHECK_EQUAL(nHits, 2U);
+
+    // Hashes are tracked the same way, 0.01% false positive when full:
+    CBlockedRollingBloomFilter rb2(10000, 0.0001);
+    std::vector<uint256> hashes;
+    for (int i = 0; i < 14999; i++) {
+        hashes.push_back(InsecureRand256());
+        rb2.insert(hashes.back());
+    }
+    for (int i = 14999 - 10000; i < 14999; i++) {
+        BOOST_CHECK(rb2.contains(hashes[i]));
+    }
+    nHits = 0;
+    for (int i = 0; i < 100000; i++) {
+        if (rb2.contains(InsecureRand256())) {
+            ++nHits;
+        }
+    }
+    // Expect about 10 hits
+    BOOST_CHECK_EQUAL(nHits, 12U);
+    g_mock_deterministic_tests = false;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
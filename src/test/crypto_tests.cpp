@@ -1073,6 +1073,28 @@ BOOST_AUTO_TEST_CASE(sha256d64) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(sha256d_multi) {
+    for (size_t count : {0, 1, 2, 7, 8, 9, 31, 100}) {
+        std::vector<std::vector<uint8_t>> msgs(count);
+        std::vector<Span<const uint8_t>> spans;
+        for (size_t i = 0; i < count; ++i) {
+            // Mostly short messages that exercise every padding case, and
+            // the occasional long one.
+            const size_t len = InsecureRandBool() ? InsecureRandRange(130)
+                                                  : InsecureRandRange(5000);
+            msgs[i] = g_insecure_rand_ctx.randbytes(len);
+            spans.emplace_back(msgs[i]);
+        }
+
+        std::vector<uint8_t> out1(32 * count), out2(32 * count);
+        for (size_t i = 0; i < count; ++i) {
+            CHash256().Write(spans[i]).Finalize({out1.data() + 32 * i, 32});
+        }
+        SHA256DMulti(out2.data(), spans.data(), count);
+        BOOST_CHECK(out1 == out2);
+    }
+}
+
 static void TestSHA3_256(const std::string &input, const std::string &output) {
     const auto in_bytes = ParseHex(input);
     const auto out_bytes = ParseHex(output);
@@ -434,4 +434,88 @@ BOOST_AUTO_TEST_CASE(unicodepath) {
     BOOST_CHECK(fs::exists(lockPath));
 }
 
+BOOST_AUTO_TEST_CASE(dboption_parsing) {
+    std::string db_name, option, error;
+    uint64_t value;
+    BOOST_CHECK(ParseDBOption("chainstate:writebuffer=64", db_name, option,
+                              value, error));
+    BOOST_CHECK_EQUAL(db_name, "chainstate");
+    BOOST_CHECK_EQUAL(option, "writebuffer");
+    BOOST_CHECK_EQUAL(value, 64U);
+
+    for (const std::string str :
+         {"", "chainstate", ":writebuffer=1", "chainstate:=1",
+          "chainstate:writebuffer", "chainstate:writebuffer=",
+          "chainstate:writebuffer=-1", "chainstate:unknown=1",
+          "chainstate:compression=2", "chainstate:bloombits=65"}) {
+        BOOST_CHECK_MESSAGE(
+            !ParseDBOption(str, db_name, option, value, error), str);
+    }
+
+    ArgsManager args;
+    args.AddArg("-dboption", "", ArgsManager::ALLOW_ANY,
+                OptionsCategory::OPTIONS);
+    const char *argv[] = {"ignored", "-dboption=chainstate:blockcache=8",
+                          "-dboption=chainstate:blocksize=16",
+                          "-dboption=chainstate:compression=1",
+                          "-dboption=txindex:bloombits=0"};
+    BOOST_REQUIRE(args.ParseParameters(std::size(argv), argv, error));
+
+    const DBOptions chainstate = ReadDBOptions(args, "chainstate");
+    BOOST_CHECK_EQUAL(chainstate.name, "chainstate");
+    BOOST_CHECK_EQUAL(chainstate.block_cache_size, 8U << 20);
+    BOOST_CHECK_EQUAL(chainstate.write_buffer_size, 0U);
+    BOOST_CHECK_EQUAL(chainstate.block_size, 16U << 10);
+    BOOST_CHECK(chainstate.compression);
+    BOOST_CHECK_EQUAL(chainstate.bloom_bits_per_key, 10);
+
+    const DBOptions txindex = ReadDBOptions(args, "txindex");
+    BOOST_CHECK_EQUAL(txindex.block_cache_size, 0U);
+    BOOST_CHECK(!txindex.compression);
+    BOOST_CHECK_EQUAL(txindex.bloom_bits_per_key, 0);
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_stats) {
+    fs::path ph = m_args.GetDataDirBase() / "dbwrapper_stats";
+    DBOptions db_options;
+    db_options.name = "stats_test";
+    db_options.write_buffer_size = 64 << 10;
+    db_options.compression = true;
+    auto dbw = std::make_unique<CDBWrapper>(ph, (1 << 20), false, true, false,
+                                            db_options);
+    BOOST_CHECK_EQUAL(dbw->GetOptionsName(), "stats_test");
+
+    // Write enough data to trigger a few memtable flushes.
+    for (uint32_t i = 0; i < 4096; ++i) {
+        BOOST_CHECK(dbw->Write(i, InsecureRand256()));
+    }
+    dbw->CompactFull();
+
+    uint256 res;
+    for (uint32_t i = 0; i < 4096; ++i) {
+        BOOST_CHECK(dbw->Read(i, res));
+    }
+
+    const DBStats stats = dbw->GetStats();
+    BOOST_CHECK(stats.bytes_written > 4096 * 32);
+    BOOST_CHECK(!stats.levels.empty());
+    BOOST_CHECK(stats.cache_hits > 0);
+    BOOST_CHECK(stats.CacheHitRate() > 0 && stats.CacheHitRate() <= 1);
+    BOOST_CHECK(stats.ReadAmplification() >= 1);
+
+    auto count_registered = [] {
+        int count = 0;
+        ForEachDBWrapper([&count](const CDBWrapper &db) {
+            count += db.GetOptionsName() == "stats_test";
+        });
+        return count;
+    };
+    BOOST_CHECK_EQUAL(count_registered(), 1);
+    BOOST_CHECK_EQUAL(CompactDBWrappers("stats_test"), 1);
+    BOOST_CHECK_EQUAL(CompactDBWrappers("unknown"), 0);
+    dbw.reset();
+    BOOST_CHECK_EQUAL(count_registered(), 0);
+    BOOST_CHECK_EQUAL(CompactDBWrappers("stats_test"), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
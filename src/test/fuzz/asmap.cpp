@@ -76,5 +76,7 @@ void test_one_input(const std::vector<uint8_t> &buffer) {
         memcpy(&ipv4, addr_data, addr_size);
         net_addr.SetIP(CNetAddr{ipv4});
     }
-    (void)net_addr.GetMappedAS(asmap);
+    const CompiledAsmap compiled{asmap};
+    assert(compiled.CheckEquivalence(asmap));
+    assert(net_addr.GetMappedAS(compiled) == net_addr.GetMappedAS(asmap));
 }
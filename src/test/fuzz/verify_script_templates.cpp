@@ -0,0 +1,154 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <hash.h>
+#include <pubkey.h>
+#include <script/interpreter.h>
+#include <script/script.h>
+#include <script/script_error.h>
+
+#include <test/fuzz/FuzzedDataProvider.h>
+#include <test/fuzz/fuzz.h>
+#include <test/fuzz/util.h>
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+bool CastToBool(const std::vector<uint8_t> &vch);
+
+namespace {
+/**
+ * The signature result only depends on the signature itself, so both
+ * evaluations below see the same outcome for the same inputs.
+ */
+class DeterministicSignatureChecker : public BaseSignatureChecker {
+public:
+    bool CheckSig(const std::vector<uint8_t> &vchSig,
+                  const std::vector<uint8_t> &vchPubKey,
+                  const CScript &scriptCode, uint32_t flags) const override {
+        return !vchSig.empty() && (vchSig.front() & 1);
+    }
+};
+
+/**
+ * VerifyScript as it would be without the specialized standard template
+ * paths: every script is run through EvalScript.
+ */
+bool VerifyScriptGeneric(const CScript &scriptSig, const CScript &scriptPubKey,
+                         uint32_t flags, const BaseSignatureChecker &checker,
+                         ScriptExecutionMetrics &metricsOut,
+                         ScriptError *serror) {
+    set_error(serror, ScriptError::UNKNOWN);
+    if (flags & SCRIPT_ENABLE_SIGHASH_FORKID) {
+        flags |= SCRIPT_VERIFY_STRICTENC;
+    }
+    if ((flags & SCRIPT_VERIFY_SIGPUSHONLY) != 0 && !scriptSig.IsPushOnly()) {
+        return set_error(serror, ScriptError::SIG_PUSHONLY);
+    }
+
+    ScriptExecutionMetrics metrics = {};
+    std::vector<std::vector<uint8_t>> stack, stackCopy;
+    if (!EvalScript(stack, scriptSig, flags, checker, metrics, serror)) {
+        return false;
+    }
+    if (flags & SCRIPT_VERIFY_P2SH) {
+        stackCopy = stack;
+    }
+    if (!EvalScript(stack, scriptPubKey, flags, checker, metrics, serror)) {
+        return false;
+    }
+    if (stack.empty() || !CastToBool(stack.back())) {
+        return set_error(serror, ScriptError::EVAL_FALSE);
+    }
+
+    if ((flags & SCRIPT_VERIFY_P2SH) && scriptPubKey.IsPayToScriptHash()) {
+        if (!scriptSig.IsPushOnly()) {
+            return set_error(serror, ScriptError::SIG_PUSHONLY);
+        }
+        std::swap(stack, stackCopy);
+        assert(!stack.empty());
+        CScript pubKey2(stack.back().begin(), stack.back().end());
+        stack.pop_back();
+        if ((flags & SCRIPT_DISALLOW_SEGWIT_RECOVERY) == 0 && stack.empty() &&
+            pubKey2.IsWitnessProgram()) {
+            metricsOut = metrics;
+            return set_success(serror);
+        }
+        if (!EvalScript(stack, pubKey2, flags, checker, metrics, serror)) {
+            return false;
+        }
+        if (stack.empty() || !CastToBool(stack.back())) {
+            return set_error(serror, ScriptError::EVAL_FALSE);
+        }
+    }
+
+    if ((flags & SCRIPT_VERIFY_CLEANSTACK) != 0 && stack.size() != 1) {
+        return set_error(serror, ScriptError::CLEANSTACK);
+    }
+    if ((flags & SCRIPT_VERIFY_INPUT_SIGCHECKS) &&
+        int(scriptSig.size()) < metrics.nSigChecks * 43 - 60) {
+        return set_error(serror, ScriptError::INPUT_SIGCHECKS);
+    }
+
+    metricsOut = metrics;
+    return set_success(serror);
+}
+} // namespace
+
+void test_one_input(const std::vector<uint8_t> &buffer) {
+    FuzzedDataProvider fuzzed_data_provider(buffer.data(), buffer.size());
+    const uint32_t flags = fuzzed_data_provider.ConsumeIntegral<uint32_t>();
+    if ((flags & SCRIPT_VERIFY_CLEANSTACK) != 0 &&
+        (flags & SCRIPT_VERIFY_P2SH) == 0) {
+        return;
+    }
+
+    // Build a scriptSig out of pushes, occasionally followed by arbitrary
+    // bytes, so that most inputs have the shape of a standard spend.
+    CScript scriptSig;
+    std::vector<std::vector<uint8_t>> pushes;
+    const size_t num_pushes =
+        fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, 3);
+    for (size_t i = 0; i < num_pushes; ++i) {
+        pushes.push_back(
+            ConsumeRandomLengthByteVector(fuzzed_data_provider, 600));
+        scriptSig << pushes.back();
+    }
+    if (fuzzed_data_provider.ConsumeBool()) {
+        const std::vector<uint8_t> extra =
+            ConsumeRandomLengthByteVector(fuzzed_data_provider, 16);
+        scriptSig.insert(scriptSig.end(), extra.begin(), extra.end());
+    }
+
+    // The template hash usually commits to the last push, so that the
+    // signature check is reached.
+    uint160 hash;
+    if (!pushes.empty() && fuzzed_data_provider.ConsumeBool()) {
+        hash = Hash160(pushes.back());
+    } else {
+        const std::vector<uint8_t> bytes =
+            ConsumeFixedLengthByteVector(fuzzed_data_provider, 20);
+        hash = uint160(bytes);
+    }
+    const CScript scriptPubKey =
+        fuzzed_data_provider.ConsumeBool()
+            ? CScript() << OP_DUP << OP_HASH160 << ToByteVector(hash)
+                        << OP_EQUALVERIFY << OP_CHECKSIG
+            : CScript() << OP_HASH160 << ToByteVector(hash) << OP_EQUAL;
+
+    const DeterministicSignatureChecker checker;
+    ScriptExecutionMetrics metrics = {}, metrics_generic = {};
+    ScriptError serror, serror_generic;
+    const bool ret =
+        VerifyScript(scriptSig, scriptPubKey, flags, checker, metrics, &serror);
+    const bool ret_generic = VerifyScriptGeneric(
+        scriptSig, scriptPubKey, flags, checker, metrics_generic,
+        &serror_generic);
+    assert(ret == ret_generic);
+    assert(serror == serror_generic);
+    if (ret) {
+        assert(metrics.nSigChecks == metrics_generic.nSigChecks);
+    }
+}
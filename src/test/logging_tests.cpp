@@ -2,14 +2,33 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <fs.h>
 #include <logging.h>
 #include <logging/timer.h>
 #include <test/util/setup_common.h>
+#include <tinyformat.h>
 
 #include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
+namespace {
+std::vector<std::string> ReadLines(const fs::path &path) {
+    fsbridge::ifstream file{path};
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+} // namespace
+
 BOOST_FIXTURE_TEST_SUITE(logging_tests, BasicTestingSetup)
 
 BOOST_AUTO_TEST_CASE(logging_timer) {
@@ -34,4 +53,58 @@ BOOST_AUTO_TEST_CASE(logging_timer) {
     SetMockTime(0);
 }
 
+BOOST_AUTO_TEST_CASE(logging_async) {
+    BCLog::Logger logger;
+    logger.m_print_to_file = true;
+    logger.m_file_path = m_path_root / "async.log";
+    logger.m_log_timestamps = false;
+    BOOST_REQUIRE(logger.StartLogging());
+    logger.StartAsyncLogging();
+
+    const auto log = [&](const std::string &str) {
+        logger.LogPrintStr(str, __func__, __FILE__, __LINE__);
+    };
+    for (int i = 0; i < 1000; i++) {
+        log(strprintf("message %d\n", i));
+    }
+    logger.Flush();
+    std::vector<std::string> lines = ReadLines(logger.m_file_path);
+    BOOST_REQUIRE_EQUAL(lines.size(), 1000U);
+    for (int i = 0; i < 1000; i++) {
+        BOOST_CHECK_EQUAL(lines[i], strprintf("message %d", i));
+    }
+
+    // The messages are dropped when too many are waiting to be written, and
+    // the number of dropped messages is written instead, in order.
+    logger.m_async_max_bytes = 100;
+    for (int i = 0; i < 10000; i++) {
+        log(strprintf("burst %d\n", i));
+    }
+    logger.StopAsyncLogging();
+    log("synchronous\n");
+
+    lines = ReadLines(logger.m_file_path);
+    BOOST_REQUIRE(lines.size() > 1001);
+    BOOST_CHECK_EQUAL(lines.back(), "synchronous");
+    int next = 0;
+    uint64_t dropped = 0;
+    uint64_t reported = 0;
+    for (size_t i = 1000; i < lines.size() - 1; i++) {
+        int n;
+        if (sscanf(lines[i].c_str(), "burst %d", &n) == 1) {
+            BOOST_CHECK(n >= next);
+            dropped += n - next;
+            next = n + 1;
+            continue;
+        }
+        unsigned int count;
+        BOOST_REQUIRE(sscanf(lines[i].c_str(),
+                             "*** %u log messages were dropped", &count) == 1);
+        reported += count;
+    }
+    dropped += 10000 - next;
+    BOOST_CHECK_EQUAL(reported, dropped);
+    BOOST_CHECK_EQUAL(logger.GetAsyncDrops(), dropped);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -374,4 +374,42 @@ BOOST_AUTO_TEST_CASE(merkle_test_LeftSubtreeRightSubtree) {
 
     BOOST_CHECK_EQUAL(root, rootOfLR);
 }
+
+BOOST_AUTO_TEST_CASE(merkle_test_subtrees) {
+    for (size_t height = 0; height < 4; height++) {
+        const size_t subtree_size = size_t(1) << height;
+        // A single subtree would be padded up to its height, unlike a tree.
+        for (size_t count = subtree_size + 1; count < 40; count++) {
+            std::vector<uint256> hashes(count);
+            for (uint256 &hash : hashes) {
+                hash = InsecureRand256();
+            }
+            // Repeat the last two hashes half of the time.
+            if (count >= 4 && InsecureRandBool()) {
+                hashes[count - 2] = hashes[count - 4];
+                hashes[count - 1] = hashes[count - 3];
+            }
+
+            bool mutated;
+            const uint256 root = ComputeMerkleRoot(hashes, &mutated);
+
+            std::vector<uint256> subtree_roots;
+            bool subtree_mutated = false;
+            for (size_t begin = 0; begin < count; begin += subtree_size) {
+                const size_t end = std::min(count, begin + subtree_size);
+                bool mutation;
+                subtree_roots.push_back(ComputeMerkleSubtreeRoot(
+                    std::vector<uint256>(hashes.begin() + begin,
+                                         hashes.begin() + end),
+                    height, &mutation));
+                subtree_mutated |= mutation;
+            }
+            bool roots_mutated;
+            BOOST_CHECK_EQUAL(ComputeMerkleRoot(subtree_roots, &roots_mutated),
+                              root);
+            BOOST_CHECK_EQUAL(subtree_mutated || roots_mutated, mutated);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
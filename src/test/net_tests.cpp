@@ -16,11 +16,13 @@
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
+#include <util/asmap.h>
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/translation.h> // for bilingual_str
 #include <version.h>
 
+#include <test/util/net.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
@@ -30,6 +32,7 @@
 #include <cmath>
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <ios>
 #include <memory>
@@ -1168,4 +1171,258 @@ BOOST_FIXTURE_TEST_CASE(net_group_limit, TestChain100Setup) {
     g_avalanche.reset();
 }
 
+BOOST_AUTO_TEST_CASE(recv_buffer_pool) {
+    const Config &config = GetConfig();
+    RecvBufferPool pool;
+    V1TransportDeserializer deserializer(config.GetChainParams().NetMagic(),
+                                         SER_NETWORK, PROTOCOL_VERSION, pool);
+
+    V1TransportSerializer serializer;
+    const auto receive = [&](size_t payload_size) {
+        CSerializedNetMsg msg;
+        msg.m_type = NetMsgType::TX;
+        msg.data.resize(payload_size);
+        for (size_t i = 0; i < payload_size; i++) {
+            msg.data[i] = i;
+        }
+        std::vector<uint8_t> wire;
+        serializer.prepareForTransport(config, msg, wire);
+        wire.insert(wire.end(), msg.data.begin(), msg.data.end());
+
+        // Feed the data byte by byte to check the incremental checksum
+        Span<const uint8_t> bytes{wire};
+        while (!bytes.empty()) {
+            Span<const uint8_t> byte = bytes.first(1);
+            BOOST_CHECK_EQUAL(deserializer.Read(config, byte), 1);
+            bytes = bytes.subspan(1);
+        }
+        BOOST_CHECK(deserializer.Complete());
+
+        CNetMessage netmsg =
+            deserializer.GetMessage(config, std::chrono::microseconds{0});
+        BOOST_CHECK(netmsg.m_valid_checksum);
+        BOOST_CHECK_EQUAL(netmsg.m_recv.size(), payload_size);
+        BOOST_CHECK(netmsg.m_recv.capacity() >= payload_size);
+        const Span<const uint8_t> payload = MakeUCharSpan(netmsg.m_recv);
+        BOOST_CHECK(std::equal(payload.begin(), payload.end(),
+                               msg.data.begin(), msg.data.end()));
+    };
+
+    // Small messages are allocated to size and not pooled
+    receive(10);
+    BOOST_CHECK_EQUAL(pool.GetStats().allocated, 1U);
+    receive(10);
+    BOOST_CHECK_EQUAL(pool.GetStats().allocated, 2U);
+    BOOST_CHECK_EQUAL(pool.GetStats().reused, 0U);
+
+    // Messages of the same size class share the buffer
+    receive(1000);
+    BOOST_CHECK_EQUAL(pool.GetStats().allocated, 3U);
+    receive(513);
+    receive(1024);
+    BOOST_CHECK_EQUAL(pool.GetStats().allocated, 3U);
+    BOOST_CHECK_EQUAL(pool.GetStats().reused, 2U);
+    receive(1025);
+    BOOST_CHECK_EQUAL(pool.GetStats().allocated, 4U);
+
+    // The buffer of an aborted message goes back to the pool
+    CDataStream stream = pool.Get(2000, SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_CHECK_EQUAL(pool.GetStats().reused, 3U);
+    BOOST_CHECK(stream.capacity() >= 2000);
+    stream << uint32_t{42};
+    pool.Put(std::move(stream));
+    BOOST_CHECK(stream.empty());
+    stream = pool.Get(2000, SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_CHECK_EQUAL(pool.GetStats().reused, 4U);
+    BOOST_CHECK(stream.empty());
+
+    // Buffers are not pooled past the pool size
+    RecvBufferPool empty_pool(0);
+    empty_pool.Put(std::move(stream));
+    empty_pool.Get(2000, SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_CHECK_EQUAL(empty_pool.GetStats().reused, 0U);
+    BOOST_CHECK_EQUAL(empty_pool.GetStats().allocated, 1U);
+
+    // The buffer of a message goes back to the pool once, when the last
+    // message it was moved to is destroyed
+    {
+        CNetMessage msg(pool.Get(2000, SER_NETWORK, PROTOCOL_VERSION), &pool);
+        BOOST_CHECK_EQUAL(pool.GetStats().allocated, 5U);
+        CNetMessage moved(std::move(msg));
+        BOOST_CHECK(msg.m_recv_pool == nullptr);
+        CNetMessage assigned(CDataStream(SER_NETWORK, PROTOCOL_VERSION));
+        assigned = std::move(moved);
+        BOOST_CHECK(moved.m_recv_pool == nullptr);
+        BOOST_CHECK(assigned.m_recv_pool == &pool);
+        BOOST_CHECK(assigned.m_recv.capacity() >= 2000);
+    }
+    stream = pool.Get(2000, SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_CHECK_EQUAL(pool.GetStats().reused, 5U);
+    pool.Get(2000, SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_CHECK_EQUAL(pool.GetStats().allocated, 6U);
+}
+
+BOOST_AUTO_TEST_CASE(priority_messages) {
+    const Config &config = GetConfig();
+    ConnmanTestMsg connman(config, 0x1337, 0x1337, *m_node.addrman);
+    CNode node(0, NODE_NETWORK, INVALID_SOCKET, CAddress(),
+               /*nKeyedNetGroupIn=*/0, /*nLocalHostNonceIn=*/0,
+               /*nLocalExtraEntropyIn=*/0, CAddress(), /*pszDest=*/"",
+               ConnectionType::OUTBOUND_FULL_RELAY, /*inbound_onion=*/false);
+
+    const auto receive = [&](const std::string &msg_type) {
+        CSerializedNetMsg msg;
+        msg.m_type = msg_type;
+        msg.data = {0};
+        BOOST_CHECK(connman.ReceiveMsgFrom(node, msg));
+    };
+    const auto process_queue = [&] {
+        std::vector<std::string> msg_types;
+        LOCK(node.cs_vProcessMsg);
+        for (const CNetMessage &msg : node.vProcessMsg) {
+            msg_types.push_back(msg.m_command);
+        }
+        node.vProcessMsg.clear();
+        node.nProcessQueueSize = 0;
+        return msg_types;
+    };
+    const auto check_queue = [&](const std::vector<std::string> &expected) {
+        const std::vector<std::string> msg_types = process_queue();
+        BOOST_CHECK_EQUAL_COLLECTIONS(msg_types.begin(), msg_types.end(),
+                                      expected.begin(), expected.end());
+    };
+
+    // The prioritization is disabled by default
+    node.fSuccessfullyConnected = true;
+    receive(NetMsgType::TX);
+    receive(NetMsgType::HEADERS);
+    check_queue({NetMsgType::TX, NetMsgType::HEADERS});
+
+    // The messages are queued in order until the handshake is complete
+    connman.SetPriorityMessages(true);
+    node.fSuccessfullyConnected = false;
+    receive(NetMsgType::VERSION);
+    receive(NetMsgType::TX);
+    receive(NetMsgType::HEADERS);
+    check_queue({NetMsgType::VERSION, NetMsgType::TX, NetMsgType::HEADERS});
+
+    // Then the block relay messages and the avalanche responses jump ahead of
+    // the other ones, but stay in order. The avalanche polls and the
+    // negotiation messages keep their place.
+    node.fSuccessfullyConnected = true;
+    receive(NetMsgType::TX);
+    receive(NetMsgType::INV);
+    receive(NetMsgType::CMPCTBLOCK);
+    receive(NetMsgType::TX);
+    receive(NetMsgType::AVAPOLL);
+    receive(NetMsgType::AVARESPONSE);
+    receive(NetMsgType::SENDCMPCT);
+    receive(NetMsgType::BLOCKTXN);
+    check_queue({NetMsgType::CMPCTBLOCK, NetMsgType::AVARESPONSE,
+                 NetMsgType::BLOCKTXN, NetMsgType::TX, NetMsgType::INV,
+                 NetMsgType::TX, NetMsgType::AVAPOLL, NetMsgType::SENDCMPCT});
+
+    // Unless the prioritization is disabled
+    connman.SetPriorityMessages(false);
+    receive(NetMsgType::TX);
+    receive(NetMsgType::HEADERS);
+    check_queue({NetMsgType::TX, NetMsgType::HEADERS});
+}
+
+BOOST_AUTO_TEST_CASE(send_short_writes) {
+    const Config &config = GetConfig();
+    ConnmanTestMsg connman(config, 0x1337, 0x1337, *m_node.addrman);
+    // SocketSendData only needs a valid socket, nothing is written to it.
+    const SOCKET hSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    BOOST_REQUIRE(hSocket != INVALID_SOCKET);
+    CNode node(0, NODE_NETWORK, hSocket, CAddress(),
+               /*nKeyedNetGroupIn=*/0, /*nLocalHostNonceIn=*/0,
+               /*nLocalExtraEntropyIn=*/0, CAddress(), /*pszDest=*/"",
+               ConnectionType::OUTBOUND_FULL_RELAY, /*inbound_onion=*/false);
+
+    // Each call sends at most the next number of bytes in the list, and
+    // nothing once the list is exhausted.
+    std::deque<size_t> write_sizes;
+    std::vector<uint8_t> sent;
+    const auto send_buffers = SendBuffers;
+    SendBuffers = [&](SOCKET,
+                      Span<const Span<const uint8_t>> buffers) -> ssize_t {
+        if (write_sizes.empty()) {
+            return 0;
+        }
+        size_t remaining = write_sizes.front();
+        write_sizes.pop_front();
+        ssize_t written = 0;
+        for (const Span<const uint8_t> &buffer : buffers) {
+            const size_t size = std::min(remaining, buffer.size());
+            sent.insert(sent.end(), buffer.begin(), buffer.begin() + size);
+            written += size;
+            remaining -= size;
+        }
+        return written;
+    };
+
+    const auto push = [&](size_t payload_size) {
+        CSerializedNetMsg msg;
+        msg.m_type = NetMsgType::TX;
+        msg.data.resize(payload_size);
+        for (size_t i = 0; i < payload_size; i++) {
+            msg.data[i] = i;
+        }
+        connman.PushMessage(&node, std::move(msg));
+    };
+
+    // The optimistic sends don't write anything, so the queue holds the
+    // header (24 bytes) and the payload of each message:
+    // [0, 24) [24, 34) [34, 58) [58, 158)
+    push(10);
+    push(100);
+    std::vector<uint8_t> expected;
+    {
+        LOCK(node.cs_vSend);
+        BOOST_CHECK_EQUAL(node.vSendMsg.size(), 4U);
+        BOOST_CHECK_EQUAL(node.nSendSize, 158U);
+        for (const auto &buffer : node.vSendMsg) {
+            expected.insert(expected.end(), buffer->begin(), buffer->end());
+        }
+    }
+    BOOST_REQUIRE_EQUAL(expected.size(), 158U);
+
+    const auto send = [&](size_t write_size, size_t queued_buffers,
+                          size_t send_offset) {
+        write_sizes.push_back(write_size);
+        LOCK(node.cs_vSend);
+        BOOST_CHECK_EQUAL(connman.SocketSendData(node), write_size);
+        BOOST_CHECK_EQUAL(node.vSendMsg.size(), queued_buffers);
+        BOOST_CHECK_EQUAL(node.nSendOffset, send_offset);
+        // The partially sent buffer still counts in full
+        size_t queued_size = 0;
+        for (const auto &buffer : node.vSendMsg) {
+            queued_size += buffer->size();
+        }
+        BOOST_CHECK_EQUAL(node.nSendSize, queued_size);
+    };
+
+    // A short write ending inside the first header
+    send(10, 4, 10);
+    // Across the end of the first header and payload, ending inside the
+    // second header
+    send(30, 2, 6);
+    // Ending exactly at the end of the second header
+    send(18, 1, 0);
+    // Ending inside the second payload
+    send(32, 1, 32);
+    // The rest
+    send(68, 0, 0);
+    // Nothing left to send
+    {
+        LOCK(node.cs_vSend);
+        BOOST_CHECK_EQUAL(connman.SocketSendData(node), 0U);
+        BOOST_CHECK_EQUAL(node.nSendBytes, 158U);
+    }
+    BOOST_CHECK(sent == expected);
+
+    SendBuffers = send_buffers;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
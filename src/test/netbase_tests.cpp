@@ -9,6 +9,7 @@
 #include <protocol.h>
 #include <serialize.h>
 #include <streams.h>
+#include <util/asmap.h>
 #include <util/strencodings.h>
 #include <util/translation.h>
 #include <version.h>
@@ -325,7 +326,7 @@ BOOST_AUTO_TEST_CASE(subnet_test) {
 
 BOOST_AUTO_TEST_CASE(netbase_getgroup) {
     // use /16
-    std::vector<bool> asmap;
+    const CompiledAsmap asmap;
     typedef std::vector<uint8_t> Vec8;
     // Local -> !Routable()
     BOOST_CHECK(ResolveIP("127.0.0.1").GetGroup(asmap) == Vec8{0});
@@ -115,4 +115,41 @@ BOOST_AUTO_TEST_CASE(sig_pubkey_hash_variations) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(cache_stats) {
+    CDataStream stream(
+        ParseHex(
+            "010000000122739e70fbee987a8be1788395a2f2e6ad18ccb7ff611cd798071539"
+            "dde3c38e000000000151ffffffff010000000000000000016a00000000"),
+        SER_NETWORK, PROTOCOL_VERSION);
+    CTransaction dummyTx(deserialize, stream);
+    PrecomputedTransactionData txdata(dummyTx);
+    CachingTransactionSignatureChecker checker(&dummyTx, 0, 0 * SATOSHI, true,
+                                               txdata);
+    TestCachingTransactionSignatureChecker testChecker(checker);
+
+    CKey key = DecodeSecret(strSecret1C);
+    CPubKey pubkey = key.GetPubKey();
+
+    const ValidationCacheStats before = GetSignatureCacheStats();
+    BOOST_CHECK(before.max_entries > 0);
+
+    // Spread the entries over the shards.
+    for (int n = 0; n < 64; n++) {
+        uint256 hashMsg = Hash(strprintf("Sigcache stats %i", n));
+        std::vector<uint8_t> sig;
+        BOOST_CHECK(key.SignECDSA(hashMsg, sig));
+
+        BOOST_CHECK(!testChecker.IsCached(sig, pubkey, hashMsg));
+        BOOST_CHECK(testChecker.VerifyAndStore(sig, pubkey, hashMsg));
+        BOOST_CHECK(testChecker.IsCached(sig, pubkey, hashMsg));
+    }
+
+    const ValidationCacheStats after = GetSignatureCacheStats();
+    BOOST_CHECK_EQUAL(after.max_entries, before.max_entries);
+    BOOST_CHECK_EQUAL(after.hits - before.hits, 64U);
+    BOOST_CHECK_EQUAL(after.misses - before.misses, 128U);
+    BOOST_CHECK_EQUAL(after.inserts - before.inserts, 64U);
+    BOOST_CHECK(after.evictions - before.evictions <= 64U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,9 +4,15 @@
 
 #include <sync.h>
 #include <test/util/setup_common.h>
+#include <util/time.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
 namespace {
 template <typename MutexType>
 void TestPotentialDeadLockDetected(MutexType &mutex1, MutexType &mutex2) {
@@ -43,6 +49,22 @@ void TestInconsistentLockOrderDetected(MutexType &mutex1, MutexType &mutex2)
     LEAVE_CRITICAL_SECTION(mutex1);
     BOOST_CHECK(LockStackEmpty());
 }
+
+//! The lock profiler statistics of the sites locking the named mutex
+LockProfiler::SiteStats GetLockProfile(const std::string &mutex_name) {
+    LockProfiler::SiteStats ret;
+    for (const LockProfiler::SiteStats &site : LockProfiler::GetStats()) {
+        if (site.mutex_name != mutex_name) {
+            continue;
+        }
+        ret.samples += site.samples;
+        ret.contended += site.contended;
+        ret.total_wait_time += site.total_wait_time;
+        ret.total_hold_time += site.total_hold_time;
+        ret.max_hold_time = std::max(ret.max_hold_time, site.max_hold_time);
+    }
+    return ret;
+}
 } // namespace
 
 BOOST_FIXTURE_TEST_SUITE(sync_tests, BasicTestingSetup)
@@ -95,4 +117,151 @@ BOOST_AUTO_TEST_CASE(inconsistent_lock_order_detected) {
 #endif // DEBUG_LOCKORDER
 }
 
+BOOST_AUTO_TEST_CASE(lock_hold_timer) {
+    using namespace std::chrono_literals;
+
+    RecursiveMutex rmutex;
+    Mutex other;
+    const auto start = std::chrono::steady_clock::now();
+    LockHoldTimer timer{&rmutex};
+    BOOST_CHECK(timer.GetHeldTime() == 0us);
+
+    {
+        // Only the outermost lock is accounted for
+        LOCK(rmutex);
+        {
+            LOCK(rmutex);
+            UninterruptibleSleep(10ms);
+        }
+        UninterruptibleSleep(10ms);
+    }
+    const auto held = timer.GetHeldTime();
+    BOOST_CHECK(held >= 20ms);
+
+    // Neither the time the mutex is released, nor the other mutexes count
+    {
+        WAIT_LOCK(rmutex, lock);
+        {
+            REVERSE_LOCK(lock);
+            LOCK(other);
+            UninterruptibleSleep(10ms);
+        }
+    }
+    BOOST_CHECK(timer.GetHeldTime() >= held);
+    BOOST_CHECK(timer.GetHeldTime() + 10ms <=
+                std::chrono::steady_clock::now() - start);
+
+    // Nor the time waiting on a condition variable
+    {
+        Mutex waited;
+        std::condition_variable cv;
+        LockHoldTimer wait_timer{&waited};
+        {
+            WAIT_LOCK(waited, lock);
+            lock.WaitFor(cv, 10ms);
+        }
+        BOOST_CHECK(wait_timer.GetHeldTime() < 10ms);
+    }
+
+    // The locks taken through try-lock are accounted for
+    {
+        TRY_LOCK(rmutex, locked);
+        BOOST_CHECK(bool(locked));
+        UninterruptibleSleep(10ms);
+    }
+    BOOST_CHECK(timer.GetHeldTime() >= held + 10ms);
+
+    // Only the innermost timer of the thread is updated
+    const auto outer_held = timer.GetHeldTime();
+    {
+        LockHoldTimer inner{&rmutex};
+        LOCK(rmutex);
+        UninterruptibleSleep(1ms);
+    }
+    BOOST_CHECK(timer.GetHeldTime() == outer_held);
+}
+
+BOOST_AUTO_TEST_CASE(lock_profiler) {
+    using namespace std::chrono_literals;
+
+    LockProfiler::Reset();
+    Mutex profiled;
+    { LOCK(profiled); }
+    BOOST_CHECK_EQUAL(GetLockProfile("profiled").samples, 0U);
+
+    LockProfiler::SetSampleRate(1);
+    {
+        LOCK(profiled);
+        UninterruptibleSleep(10ms);
+    }
+    {
+        TRY_LOCK(profiled, locked);
+        BOOST_CHECK(bool(locked));
+    }
+    LockProfiler::SiteStats stats = GetLockProfile("profiled");
+    BOOST_CHECK_EQUAL(stats.samples, 2U);
+    BOOST_CHECK_EQUAL(stats.contended, 0U);
+    BOOST_CHECK(stats.max_hold_time >= 10ms);
+
+    // The time waiting for another thread to release the mutex is recorded
+    std::atomic<bool> holding{false};
+    std::thread holder([&] {
+        LOCK(profiled);
+        holding = true;
+        UninterruptibleSleep(20ms);
+    });
+    while (!holding) {
+        std::this_thread::yield();
+    }
+    { LOCK(profiled); }
+    holder.join();
+    stats = GetLockProfile("profiled");
+    BOOST_CHECK_EQUAL(stats.samples, 4U);
+    BOOST_CHECK_EQUAL(stats.contended, 1U);
+    BOOST_CHECK(stats.total_wait_time >= 10ms);
+
+    // A reverse lock ends the sample
+    LockProfiler::Reset();
+    {
+        WAIT_LOCK(profiled, lock);
+        REVERSE_LOCK(lock);
+        UninterruptibleSleep(10ms);
+    }
+    stats = GetLockProfile("profiled");
+    BOOST_CHECK_EQUAL(stats.samples, 1U);
+    BOOST_CHECK(stats.total_hold_time < 10ms);
+
+    // So does a condition variable wait
+    LockProfiler::Reset();
+    {
+        std::condition_variable cv;
+        WAIT_LOCK(profiled, lock);
+        lock.WaitFor(cv, 10ms);
+    }
+    stats = GetLockProfile("profiled");
+    BOOST_CHECK_EQUAL(stats.samples, 1U);
+    BOOST_CHECK(stats.total_hold_time < 10ms);
+
+    // Only one in sample rate acquisitions of the thread is sampled
+    LockProfiler::Reset();
+    LockProfiler::SetSampleRate(4);
+    for (int i = 0; i < 8; i++) {
+        LOCK(profiled);
+    }
+    BOOST_CHECK_EQUAL(GetLockProfile("profiled").samples, 2U);
+
+    // The statistics can be read and cleared at once
+    std::vector<LockProfiler::SiteStats> sites =
+        LockProfiler::GetStats(/*reset=*/true);
+    BOOST_CHECK(std::any_of(sites.begin(), sites.end(),
+                            [](const LockProfiler::SiteStats &site) {
+                                return site.mutex_name == "profiled" &&
+                                       site.samples == 2;
+                            }));
+    BOOST_CHECK_EQUAL(GetLockProfile("profiled").samples, 0U);
+
+    LockProfiler::SetSampleRate(DEFAULT_LOCK_PROFILE_SAMPLE_RATE);
+    LockProfiler::Reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -931,4 +931,95 @@ BOOST_AUTO_TEST_CASE(tx_getvalueout) {
     BOOST_CHECK_THROW(overflow_sum_tx.GetValueOut(), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(unserialize_block_lookup) {
+    CBlock block;
+    block.nVersion = 42;
+    block.nBits = 0x207fffff;
+    for (size_t i = 0; i < 50; i++) {
+        CMutableTransaction tx;
+        tx.nVersion = 2;
+        tx.nLockTime = i;
+        tx.vin.resize(1 + InsecureRandRange(3));
+        for (CTxIn &txin : tx.vin) {
+            txin.prevout = COutPoint(TxId(InsecureRand256()), i);
+            // Some scripts need a multi-byte length.
+            txin.scriptSig.resize(InsecureRandRange(300));
+        }
+        tx.vout.resize(InsecureRandRange(3));
+        for (CTxOut &txout : tx.vout) {
+            txout.nValue = int64_t(InsecureRandRange(1000)) * SATOSHI;
+            txout.scriptPubKey = CScript() << OP_TRUE;
+        }
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+    }
+
+    // Only every other transaction is known.
+    std::map<TxId, CTransactionRef> known;
+    for (size_t i = 0; i < block.vtx.size(); i += 2) {
+        known.emplace(block.vtx[i]->GetId(), block.vtx[i]);
+    }
+    const TransactionLookup lookup = [&](const std::vector<TxId> &txids,
+                                         std::vector<CTransactionRef> &txs) {
+        BOOST_CHECK_EQUAL(txids.size(), txs.size());
+        for (size_t i = 0; i < txids.size(); i++) {
+            auto it = known.find(txids[i]);
+            if (it != known.end()) {
+                txs[i] = it->second;
+            }
+        }
+    };
+
+    CDataStream serialized(SER_NETWORK, PROTOCOL_VERSION);
+    serialized << block;
+
+    // Trailing data is left in the stream, as with operator>>.
+    CDataStream stream = serialized;
+    stream << uint8_t(0xff);
+
+    CBlock block2;
+    UnserializeBlock(stream, block2, lookup);
+    BOOST_CHECK_EQUAL(stream.size(), 1U);
+    BOOST_CHECK_EQUAL(block2.GetHash(), block.GetHash());
+    BOOST_REQUIRE_EQUAL(block2.vtx.size(), block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        BOOST_CHECK_EQUAL(block2.vtx[i]->GetId(), block.vtx[i]->GetId());
+        BOOST_CHECK(*block2.vtx[i] == *block.vtx[i]);
+        // The known transactions are shared, the others are new copies.
+        BOOST_CHECK_EQUAL(block2.vtx[i] == block.vtx[i], i % 2 == 0);
+    }
+
+    // Truncated blocks are rejected.
+    for (size_t size = 0; size < serialized.size(); size += 1 + size / 4) {
+        CDataStream truncated(serialized.begin(), serialized.begin() + size,
+                              SER_NETWORK, PROTOCOL_VERSION);
+        CBlock block3;
+        BOOST_CHECK_THROW(UnserializeBlock(truncated, block3, lookup),
+                          std::ios_base::failure);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(make_transaction_refs) {
+    BOOST_CHECK(MakeTransactionRefs({}).empty());
+
+    // Enough data for the hashes to be computed in several batches, with a
+    // transaction larger than a batch in the middle.
+    std::vector<CMutableTransaction> txs;
+    for (size_t i = 0; i < 300; i++) {
+        CMutableTransaction tx;
+        tx.nLockTime = i;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(TxId(InsecureRand256()), i);
+        tx.vin[0].scriptSig.resize(i == 150 ? 400000
+                                            : InsecureRandRange(5000));
+        txs.push_back(tx);
+    }
+
+    const std::vector<CTransactionRef> vtx =
+        MakeTransactionRefs(std::vector<CMutableTransaction>(txs));
+    BOOST_REQUIRE_EQUAL(vtx.size(), txs.size());
+    for (size_t i = 0; i < txs.size(); i++) {
+        BOOST_CHECK_EQUAL(vtx[i]->GetHash(), CTransaction(txs[i]).GetHash());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
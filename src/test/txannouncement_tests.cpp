@@ -0,0 +1,295 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txannouncement.h>
+
+#include <chainparams.h>
+#include <config.h>
+#include <consensus/amount.h>
+#include <net.h>
+#include <net_processing.h>
+#include <primitives/transaction.h>
+#include <protocol.h>
+#include <script/script.h>
+#include <streams.h>
+#include <txmempool.h>
+#include <util/time.h>
+#include <validation.h>
+#include <version.h>
+
+#include <test/util/net.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <optional>
+#include <set>
+#include <vector>
+
+namespace {
+struct TxAnnouncementSetup : public BasicTestingSetup {
+    CTxMemPool pool;
+    uint32_t next_prevout{0};
+
+    CTransactionRef MakeTx(const std::optional<TxId> &parent = std::nullopt) {
+        CMutableTransaction mtx;
+        mtx.vin.resize(1);
+        mtx.vin[0].prevout =
+            parent ? COutPoint(*parent, 0)
+                   : COutPoint(TxId(InsecureRand256()), next_prevout++);
+        mtx.vout.resize(1);
+        mtx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+        mtx.vout[0].nValue = 1000 * SATOSHI;
+        return MakeTransactionRef(mtx);
+    }
+
+    void AddToMempool(const CTransactionRef &tx, Amount fee) {
+        LOCK2(cs_main, pool.cs);
+        pool.addUnchecked(TestMemPoolEntryHelper().Fee(fee).FromTx(tx));
+    }
+
+    static std::vector<TxId> GetTxIds(
+        const std::vector<std::shared_ptr<const TxAnnouncementBatch>>
+            &batches) {
+        std::vector<TxId> txids;
+        for (const auto &batch : batches) {
+            for (const TxMempoolInfo &txinfo : batch->txs) {
+                txids.push_back(txinfo.tx->GetId());
+            }
+        }
+        return txids;
+    }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(txannouncement_tests, TxAnnouncementSetup)
+
+BOOST_AUTO_TEST_CASE(cursor_advance) {
+    TxAnnouncementQueue queue(1000);
+    uint64_t cursor = queue.GetNextSequence();
+    BOOST_CHECK_EQUAL(cursor, 0U);
+    BOOST_CHECK(queue.GetBatches(cursor, pool).empty());
+
+    // The batch is sorted topologically, then by fee rate
+    const CTransactionRef low_fee = MakeTx();
+    const CTransactionRef high_fee = MakeTx();
+    const CTransactionRef child = MakeTx(high_fee->GetId());
+    AddToMempool(low_fee, 1000 * SATOSHI);
+    AddToMempool(high_fee, 5000 * SATOSHI);
+    AddToMempool(child, 10000 * SATOSHI);
+    queue.Add(child->GetId());
+    queue.Add(low_fee->GetId());
+    queue.Add(high_fee->GetId());
+    // Nothing is batched until a peer asks for the transactions
+    BOOST_CHECK_EQUAL(queue.GetNextSequence(), 0U);
+
+    auto batches = queue.GetBatches(cursor, pool);
+    BOOST_REQUIRE_EQUAL(batches.size(), 1U);
+    BOOST_CHECK_EQUAL(batches[0]->first_sequence, 0U);
+    BOOST_CHECK_EQUAL(batches[0]->EndSequence(), 3U);
+    const std::vector<TxId> expected{high_fee->GetId(), low_fee->GetId(),
+                                     child->GetId()};
+    const std::vector<TxId> txids = GetTxIds(batches);
+    BOOST_CHECK(txids == expected);
+    // The cursor is only moved by the peer
+    BOOST_CHECK_EQUAL(cursor, 0U);
+    BOOST_CHECK_EQUAL(queue.GetNextSequence(), 3U);
+
+    // Another peer gets the same batch
+    uint64_t other_cursor = 0;
+    BOOST_CHECK(queue.GetBatches(other_cursor, pool) == batches);
+
+    // A peer that announced part of the batch still gets it
+    cursor = 2;
+    BOOST_CHECK(queue.GetBatches(cursor, pool) == batches);
+    cursor = 3;
+    BOOST_CHECK(queue.GetBatches(cursor, pool).empty());
+
+    // The next batch follows
+    const CTransactionRef tx = MakeTx();
+    AddToMempool(tx, 1000 * SATOSHI);
+    queue.Add(tx->GetId());
+    auto new_batches = queue.GetBatches(cursor, pool);
+    BOOST_REQUIRE_EQUAL(new_batches.size(), 1U);
+    BOOST_CHECK_EQUAL(new_batches[0]->first_sequence, 3U);
+    BOOST_CHECK(GetTxIds(new_batches) == std::vector<TxId>{tx->GetId()});
+    BOOST_CHECK_EQUAL(GetTxIds(queue.GetBatches(other_cursor, pool)).size(),
+                      4U);
+    BOOST_CHECK_EQUAL(queue.GetDroppedCount(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(mempool_filtering) {
+    TxAnnouncementQueue queue(1000);
+    uint64_t cursor = queue.GetNextSequence();
+
+    // Transactions which are not in the mempool anymore are not batched
+    const CTransactionRef in_mempool = MakeTx();
+    const CTransactionRef removed = MakeTx();
+    AddToMempool(in_mempool, 1000 * SATOSHI);
+    AddToMempool(removed, 1000 * SATOSHI);
+    {
+        LOCK(pool.cs);
+        pool.removeRecursive(*removed, MemPoolRemovalReason::CONFLICT);
+    }
+    queue.Add(in_mempool->GetId());
+    queue.Add(removed->GetId());
+    queue.Add(TxId(InsecureRand256()));
+
+    const auto batches = queue.GetBatches(cursor, pool);
+    BOOST_CHECK(GetTxIds(batches) ==
+                std::vector<TxId>{in_mempool->GetId()});
+    BOOST_CHECK_EQUAL(queue.GetNextSequence(), 1U);
+
+    // An empty batch is not created
+    queue.Add(removed->GetId());
+    cursor = 1;
+    BOOST_CHECK(queue.GetBatches(cursor, pool).empty());
+    BOOST_CHECK_EQUAL(queue.GetNextSequence(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(size_limit) {
+    TxAnnouncementQueue queue(3);
+    uint64_t slow_cursor = queue.GetNextSequence();
+    uint64_t slower_cursor = slow_cursor;
+
+    const auto add_batch = [&](size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            const CTransactionRef tx = MakeTx();
+            AddToMempool(tx, 1000 * SATOSHI);
+            queue.Add(tx->GetId());
+        }
+        uint64_t cursor = queue.GetNextSequence();
+        return queue.GetBatches(cursor, pool);
+    };
+
+    // [0, 2) [2, 4): the first batch is dropped
+    BOOST_CHECK_EQUAL(add_batch(2).size(), 1U);
+    slow_cursor = 1;
+    BOOST_CHECK_EQUAL(add_batch(2).size(), 1U);
+    auto batches = queue.GetBatches(slow_cursor, pool);
+    BOOST_REQUIRE_EQUAL(batches.size(), 1U);
+    BOOST_CHECK_EQUAL(batches[0]->first_sequence, 2U);
+    // The peer skips the announcements it did not make
+    BOOST_CHECK_EQUAL(slow_cursor, 2U);
+    BOOST_CHECK_EQUAL(queue.GetDroppedCount(), 1U);
+
+    // The latest batch is kept even if it is larger than the limit
+    BOOST_CHECK_EQUAL(add_batch(5).size(), 1U);
+    batches = queue.GetBatches(slower_cursor, pool);
+    BOOST_REQUIRE_EQUAL(batches.size(), 1U);
+    BOOST_CHECK_EQUAL(batches[0]->first_sequence, 4U);
+    BOOST_CHECK_EQUAL(batches[0]->txs.size(), 5U);
+    BOOST_CHECK_EQUAL(slower_cursor, 4U);
+    BOOST_CHECK_EQUAL(queue.GetDroppedCount(), 5U);
+}
+
+//! The transactions announced to the node by the INV messages it was sent
+static std::set<TxId> TakeAnnouncedTxs(CNode &node) {
+    std::set<TxId> txids;
+    LOCK(node.cs_vSend);
+    for (size_t i = 0; i < node.vSendMsg.size(); i++) {
+        CMessageHeader header(Params().NetMagic());
+        CDataStream(*node.vSendMsg[i], SER_NETWORK, PROTOCOL_VERSION) >>
+            header;
+        if (header.nMessageSize == 0) {
+            continue;
+        }
+        // The payload follows the header in its own buffer
+        const std::vector<uint8_t> &payload = *node.vSendMsg[++i];
+        if (header.GetCommand() != NetMsgType::INV) {
+            continue;
+        }
+        std::vector<CInv> invs;
+        CDataStream(payload, SER_NETWORK, PROTOCOL_VERSION) >> invs;
+        for (const CInv &inv : invs) {
+            if (inv.IsMsgTx()) {
+                txids.insert(TxId(inv.hash));
+            }
+        }
+    }
+    node.vSendMsg.clear();
+    node.nSendSize = 0;
+    node.nSendOffset = 0;
+    node.fPauseSend = false;
+    return txids;
+}
+
+BOOST_FIXTURE_TEST_CASE(lagging_peer_skips_confirmed_tx, TestingSetup) {
+    const Config &config = GetConfig();
+    CTxMemPool &mempool = *m_node.mempool;
+    ConnmanTestMsg connman(config, 0x1337, 0x1337, *m_node.addrman);
+    connman.SetPeerConnectTimeout(99999s);
+    const std::unique_ptr<PeerManager> peerman =
+        PeerManager::make(config.GetChainParams(), connman, *m_node.addrman,
+                          /*banman=*/nullptr, *m_node.chainman, mempool,
+                          /*ignore_incoming_txs=*/false);
+
+    std::vector<CNode *> nodes;
+    for (NodeId id = 0; id < 2; id++) {
+        CNode *node = new CNode(
+            id, NODE_NETWORK, INVALID_SOCKET, CAddress(),
+            /*nKeyedNetGroupIn=*/0, /*nLocalHostNonceIn=*/0,
+            /*nLocalExtraEntropyIn=*/0, CAddress(), /*pszDest=*/"",
+            ConnectionType::OUTBOUND_FULL_RELAY, /*inbound_onion=*/false);
+        node->SetCommonVersion(PROTOCOL_VERSION);
+        peerman->InitializeNode(config, node);
+        node->fSuccessfullyConnected = true;
+        WITH_LOCK(node->m_tx_relay->cs_filter,
+                  node->m_tx_relay->fRelayTxes = true);
+        connman.AddTestNode(*node);
+        nodes.push_back(node);
+    }
+    CNode &fast_peer = *nodes[0];
+    CNode &lagging_peer = *nodes[1];
+
+    // The outbound peers announce transactions each time the clock moves
+    int64_t now = GetTime();
+    const auto send_messages = [&](CNode &node) {
+        SetMockTime(++now);
+        LOCK(node.cs_sendProcessing);
+        peerman->SendMessages(config, &node);
+        return TakeAnnouncedTxs(node);
+    };
+    send_messages(fast_peer);
+    send_messages(lagging_peer);
+
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].prevout = COutPoint(TxId(InsecureRand256()), 0);
+    mtx.vout.resize(1);
+    mtx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    mtx.vout[0].nValue = 1000 * SATOSHI;
+    const CTransactionRef confirmed = MakeTransactionRef(mtx);
+    mtx.vin[0].prevout = COutPoint(TxId(InsecureRand256()), 0);
+    const CTransactionRef unconfirmed = MakeTransactionRef(mtx);
+    for (const CTransactionRef &tx : {confirmed, unconfirmed}) {
+        {
+            LOCK2(cs_main, mempool.cs);
+            mempool.addUnchecked(
+                TestMemPoolEntryHelper().Fee(1000 * SATOSHI).FromTx(tx));
+        }
+        peerman->RelayTransaction(tx->GetId());
+    }
+
+    // The fast peer gets the batch of both transactions announced
+    BOOST_CHECK(send_messages(fast_peer) ==
+                std::set<TxId>({confirmed->GetId(), unconfirmed->GetId()}));
+
+    // One of them is mined before the lagging peer reaches the batch
+    {
+        LOCK2(cs_main, mempool.cs);
+        mempool.removeForBlock({confirmed}, /*nBlockHeight=*/1);
+    }
+    BOOST_CHECK(send_messages(lagging_peer) ==
+                std::set<TxId>({unconfirmed->GetId()}));
+
+    SetMockTime(0);
+    for (CNode *node : nodes) {
+        peerman->FinalizeNode(config, *node);
+    }
+    connman.ClearTestNodes();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
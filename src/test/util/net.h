@@ -17,11 +17,16 @@
 
 struct ConnmanTestMsg : public CConnman {
     using CConnman::CConnman;
+    using CConnman::SocketSendData;
 
     void SetPeerConnectTimeout(std::chrono::seconds timeout) {
         m_peer_connect_timeout = timeout;
     }
 
+    void SetPriorityMessages(bool priority_messages) {
+        m_priority_messages = priority_messages;
+    }
+
     void AddTestNode(CNode &node) {
         LOCK(cs_vNodes);
         vNodes.push_back(&node);
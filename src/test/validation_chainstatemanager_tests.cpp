@@ -5,6 +5,7 @@
 #include <chainparams.h>
 #include <config.h>
 #include <consensus/validation.h>
+#include <node/coinstats.h>
 #include <node/utxo_snapshot.h>
 #include <random.h>
 #include <rpc/blockchain.h>
@@ -20,6 +21,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+using node::CCoinsStats;
+using node::CoinStatsHashType;
+using node::SerializedCoinsHasher;
 using node::SnapshotMetadata;
 
 BOOST_FIXTURE_TEST_SUITE(validation_chainstatemanager_tests, ChainTestingSetup)
@@ -411,4 +415,41 @@ BOOST_FIXTURE_TEST_CASE(chainstatemanager_loadblockindex, TestChain100Setup) {
     BOOST_CHECK_EQUAL(cs2.setBlockIndexCandidates.size(), num_indexes);
 }
 
+//! Check that hashing coins as they are streamed in database order gives the
+//! same commitment as GetUTXOStats, and that out of order coins are detected.
+BOOST_FIXTURE_TEST_CASE(serialized_coins_hasher, TestChain100Setup) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    CChainState &chainstate = chainman.ActiveChainstate();
+    LOCK(::cs_main);
+    chainstate.ForceFlushStateToDisk();
+
+    CCoinsViewDB &coinsdb = chainstate.CoinsDB();
+    CCoinsStats stats{CoinStatsHashType::HASH_SERIALIZED};
+    BOOST_REQUIRE(GetUTXOStats(&coinsdb, chainman.m_blockman, stats,
+                               /*interruption_point=*/[] {}));
+
+    SerializedCoinsHasher hasher{coinsdb.GetBestBlock()};
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    std::unique_ptr<CCoinsViewCursor> cursor{coinsdb.Cursor()};
+    for (; cursor->Valid(); cursor->Next()) {
+        COutPoint outpoint;
+        Coin coin;
+        BOOST_REQUIRE(cursor->GetKey(outpoint) && cursor->GetValue(coin));
+        BOOST_CHECK(hasher.Add(outpoint, coin));
+        coins.emplace_back(outpoint, coin);
+    }
+    BOOST_REQUIRE_GE(coins.size(), 2U);
+    BOOST_CHECK_EQUAL(hasher.Finalize(), stats.hashSerialized);
+
+    // Coins must be strictly increasing, so neither reordered nor repeated
+    // coins are accepted.
+    SerializedCoinsHasher reordered{coinsdb.GetBestBlock()};
+    BOOST_CHECK(reordered.Add(coins[1].first, coins[1].second));
+    BOOST_CHECK(!reordered.Add(coins[0].first, coins[0].second));
+
+    SerializedCoinsHasher repeated{coinsdb.GetBestBlock()};
+    BOOST_CHECK(repeated.Add(coins[0].first, coins[0].second));
+    BOOST_CHECK(!repeated.Add(coins[0].first, coins[0].second));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,7 @@
 #include <config.h>
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
+#include <flatfile.h>
 #include <net.h>
 #include <primitives/transaction.h>
 #include <streams.h>
@@ -24,6 +25,7 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <memory>
 #include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(validation_tests, TestingSetup)
@@ -161,4 +163,43 @@ BOOST_AUTO_TEST_CASE(test_assumeutxo) {
     BOOST_CHECK_EQUAL(out210.nChainTx, (unsigned int)210);
 }
 
+BOOST_AUTO_TEST_CASE(block_prefetcher) {
+    const Config &config = GetConfig();
+    const Consensus::Params &params = config.GetChainParams().GetConsensus();
+    BlockHash hash;
+    FlatFilePos pos;
+    {
+        LOCK(cs_main);
+        const CBlockIndex *tip = m_node.chainman->ActiveTip();
+        hash = tip->GetBlockHash();
+        pos = tip->GetBlockPos();
+    }
+
+    BlockPrefetcher prefetcher;
+    // Nothing was prefetched
+    BOOST_CHECK(!prefetcher.Take(hash));
+
+    prefetcher.Prefetch(hash, pos, params, BlockValidationOptions(config));
+    std::shared_ptr<const CBlock> block = prefetcher.Take(hash);
+    BOOST_REQUIRE(block);
+    BOOST_CHECK(block->GetHash() == hash);
+    // The block is only handed out once
+    BOOST_CHECK(!prefetcher.Take(hash));
+
+    // Another block is released without being waited for
+    prefetcher.Prefetch(hash, pos, params, BlockValidationOptions(config));
+    BOOST_CHECK(!prefetcher.Take(BlockHash(InsecureRand256())));
+    BOOST_CHECK(!prefetcher.Take(hash));
+
+    prefetcher.Prefetch(hash, pos, params, BlockValidationOptions(config));
+    prefetcher.Cancel();
+    BOOST_CHECK(!prefetcher.Take(hash));
+
+    // A block that doesn't match the requested hash is reported as missing
+    const BlockHash other_hash(InsecureRand256());
+    prefetcher.Prefetch(other_hash, pos, params,
+                        BlockValidationOptions(config));
+    BOOST_CHECK(!prefetcher.Take(other_hash));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
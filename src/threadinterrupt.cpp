@@ -25,7 +25,7 @@ void CThreadInterrupt::operator()() {
 
 bool CThreadInterrupt::sleep_for(std::chrono::milliseconds rel_time) {
     WAIT_LOCK(mut, lock);
-    return !cond.wait_for(lock, rel_time, [this]() {
+    return !lock.WaitFor(cond, rel_time, [this]() {
         return flag.load(std::memory_order_acquire);
     });
 }
@@ -0,0 +1,82 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txannouncement.h>
+
+#include <logging.h>
+
+#include <algorithm>
+
+void TxAnnouncementQueue::Add(const TxId &txid) {
+    LOCK(m_mutex);
+    m_pending.insert(txid);
+}
+
+uint64_t TxAnnouncementQueue::GetNextSequence() const {
+    LOCK(m_mutex);
+    // The pending transactions get numbered after that
+    return m_next_sequence;
+}
+
+std::vector<std::shared_ptr<const TxAnnouncementBatch>>
+TxAnnouncementQueue::GetBatches(uint64_t &cursor, CTxMemPool &mempool) {
+    LOCK(m_mutex);
+
+    if (!m_pending.empty()) {
+        auto batch = std::make_shared<TxAnnouncementBatch>();
+        batch->first_sequence = m_next_sequence;
+
+        std::vector<TxId> txids(m_pending.begin(), m_pending.end());
+        m_pending.clear();
+        {
+            LOCK(mempool.cs);
+            std::sort(txids.begin(), txids.end(),
+                      [&mempool](const TxId &a, const TxId &b) {
+                          return mempool.CompareDepthAndScore(a, b);
+                      });
+            // The transactions which left the mempool are filtered out once
+            // here, rather than by every peer.
+            batch->txs.reserve(txids.size());
+            for (const TxId &txid : txids) {
+                TxMempoolInfo txinfo = mempool.info(txid);
+                if (txinfo.tx) {
+                    batch->txs.push_back(std::move(txinfo));
+                }
+            }
+        }
+
+        if (!batch->txs.empty()) {
+            m_next_sequence = batch->EndSequence();
+            m_batched_txs += batch->txs.size();
+            m_batches.push_back(std::move(batch));
+        }
+    }
+
+    // Keep at least the latest batch, however large
+    while (m_batched_txs > m_max_txs && m_batches.size() > 1) {
+        m_batched_txs -= m_batches.front()->txs.size();
+        m_batches.pop_front();
+    }
+
+    const uint64_t first_available =
+        m_batches.empty() ? m_next_sequence : m_batches.front()->first_sequence;
+    if (cursor < first_available) {
+        LogPrint(BCLog::NET,
+                 "Dropped %u transaction announcements to a slow peer\n",
+                 first_available - cursor);
+        m_dropped += first_available - cursor;
+        cursor = first_available;
+    }
+
+    auto it = std::partition_point(
+        m_batches.begin(), m_batches.end(), [cursor](const auto &batch) {
+            return batch->EndSequence() <= cursor;
+        });
+    return {it, m_batches.end()};
+}
+
+uint64_t TxAnnouncementQueue::GetDroppedCount() const {
+    LOCK(m_mutex);
+    return m_dropped;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2022 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_TXANNOUNCEMENT_H
+#define BITCOIN_TXANNOUNCEMENT_H
+
+#include <primitives/txid.h>
+#include <sync.h>
+#include <txmempool.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <set>
+#include <vector>
+
+/**
+ * Transactions relayed during an interval, sorted once in mempool order
+ * (topologically, then by fee rate) and shared by all the peers which announce
+ * them. The transactions are numbered across the batches.
+ */
+struct TxAnnouncementBatch {
+    //! Sequence number of the first transaction in the batch
+    uint64_t first_sequence;
+    std::vector<TxMempoolInfo> txs;
+
+    //! Sequence number following the last transaction in the batch
+    uint64_t EndSequence() const { return first_sequence + txs.size(); }
+};
+
+/**
+ * The transactions waiting to be announced to our peers.
+ *
+ * Relayed transactions are collected into a pending set. When a peer is about
+ * to announce transactions, the pending ones that are still in the mempool are
+ * sealed into a new batch. Each peer keeps a cursor, the sequence number of the
+ * next transaction it has to consider, and only applies its own filters.
+ *
+ * Once more than max_txs transactions are batched, the oldest batches are
+ * dropped. The peers which did not announce them yet skip them, and the
+ * announcements they miss that way are counted.
+ */
+class TxAnnouncementQueue {
+    mutable Mutex m_mutex;
+    //! Transactions relayed since the last batch was created
+    std::set<TxId> m_pending GUARDED_BY(m_mutex);
+    std::deque<std::shared_ptr<const TxAnnouncementBatch>>
+        m_batches GUARDED_BY(m_mutex);
+    //! Number of transactions in m_batches
+    size_t m_batched_txs GUARDED_BY(m_mutex){0};
+    //! Sequence number of the next transaction added to a batch
+    uint64_t m_next_sequence GUARDED_BY(m_mutex){0};
+    //! Announcements skipped by the peers because their batch was dropped
+    uint64_t m_dropped GUARDED_BY(m_mutex){0};
+    const size_t m_max_txs;
+
+public:
+    explicit TxAnnouncementQueue(size_t max_txs) : m_max_txs(max_txs) {}
+
+    /** Queue a transaction for announcement */
+    void Add(const TxId &txid) LOCKS_EXCLUDED(m_mutex);
+
+    /**
+     * Cursor of a peer that only announces the transactions queued from now
+     * on.
+     */
+    uint64_t GetNextSequence() const LOCKS_EXCLUDED(m_mutex);
+
+    /**
+     * Seal the pending transactions into a new batch and return the batches
+     * containing the transactions numbered from cursor onwards. If some of
+     * these were dropped, cursor is moved past them.
+     */
+    std::vector<std::shared_ptr<const TxAnnouncementBatch>>
+    GetBatches(uint64_t &cursor, CTxMemPool &mempool) LOCKS_EXCLUDED(m_mutex);
+
+    /** Number of announcements the peers skipped because of the size limit */
+    uint64_t GetDroppedCount() const LOCKS_EXCLUDED(m_mutex);
+};
+
+#endif // BITCOIN_TXANNOUNCEMENT_H
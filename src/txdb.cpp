@@ -75,7 +75,8 @@ struct CoinEntry {
 CCoinsViewDB::CCoinsViewDB(fs::path ldb_path, size_t nCacheSize, bool fMemory,
                            bool fWipe)
     : m_db(std::make_unique<CDBWrapper>(ldb_path, nCacheSize, fMemory, fWipe,
-                                        true)),
+                                        true,
+                                        ReadDBOptions(gArgs, "chainstate"))),
       m_ldb_path(ldb_path), m_is_memory(fMemory) {}
 
 void CCoinsViewDB::ResizeCache(size_t new_cache_size) {
@@ -85,9 +86,9 @@ void CCoinsViewDB::ResizeCache(size_t new_cache_size) {
         // Have to do a reset first to get the original `m_db` state to release
         // its filesystem lock.
         m_db.reset();
-        m_db = std::make_unique<CDBWrapper>(m_ldb_path, new_cache_size,
-                                            m_is_memory, /*fWipe*/ false,
-                                            /*obfuscate*/ true);
+        m_db = std::make_unique<CDBWrapper>(
+            m_ldb_path, new_cache_size, m_is_memory, /*fWipe*/ false,
+            /*obfuscate*/ true, ReadDBOptions(gArgs, "chainstate"));
     }
 }
 
@@ -189,7 +190,8 @@ size_t CCoinsViewDB::EstimateSize() const {
 
 CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe)
     : CDBWrapper(gArgs.GetDataDirNet() / "blocks" / "index", nCacheSize,
-                 fMemory, fWipe) {}
+                 fMemory, fWipe, /*obfuscate*/ false,
+                 ReadDBOptions(gArgs, "blockindex")) {}
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
     return Read(std::make_pair(DB_BLOCK_FILES, nFile), info);
@@ -297,6 +299,14 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+size_t CBlockTreeDB::EstimateBlockIndexEntries() const {
+    // A serialized entry takes about 140 bytes with its key: 33 bytes of key,
+    // the 80 bytes header and the varint encoded position and status fields.
+    static constexpr size_t BLOCK_INDEX_ENTRY_DISK_SIZE = 140;
+    return EstimateSize(DB_BLOCK_INDEX, char(DB_BLOCK_INDEX + 1)) /
+           BLOCK_INDEX_ENTRY_DISK_SIZE;
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts(
     const Consensus::Params &params,
     std::function<CBlockIndex *(const BlockHash &)> insertBlockIndex) {
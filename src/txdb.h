@@ -120,6 +120,8 @@ public:
     bool LoadBlockIndexGuts(
         const Consensus::Params &params,
         std::function<CBlockIndex *(const BlockHash &)> insertBlockIndex);
+    //! Estimate the number of block index entries from their size on disk.
+    size_t EstimateBlockIndexEntries() const;
 
     //! Attempt to update from an older database format.
     //! Returns whether an error occurred.
@@ -556,6 +556,9 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry,
     cachedInnerUsage += entry.DynamicMemoryUsage();
 
     const CTransaction &tx = newit->GetTx();
+    vTxHashes.emplace_back(tx.GetHash(), newit);
+    newit->vTxHashesIdx = vTxHashes.size() - 1;
+
     std::set<TxId> setParentTransactions;
     for (const CTxIn &in : tx.vin) {
         mapNextTx.insert(std::make_pair(&in.prevout, &tx));
@@ -606,6 +609,18 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason) {
     cachedInnerUsage -= it->DynamicMemoryUsage();
     cachedInnerUsage -= memusage::DynamicUsage(it->GetMemPoolParentsConst()) +
                         memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+
+    if (vTxHashes.size() > 1) {
+        vTxHashes[it->vTxHashesIdx] = std::move(vTxHashes.back());
+        vTxHashes[it->vTxHashesIdx].second->vTxHashesIdx = it->vTxHashesIdx;
+        vTxHashes.pop_back();
+        if (vTxHashes.size() * 2 < vTxHashes.capacity()) {
+            vTxHashes.shrink_to_fit();
+        }
+    } else {
+        vTxHashes.clear();
+    }
+
     mapTx.erase(it);
     nTransactionsUpdated++;
 }
@@ -756,6 +771,7 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef> &vtx,
 }
 
 void CTxMemPool::_clear() {
+    vTxHashes.clear();
     mapTx.clear();
     mapNextTx.clear();
     totalTxSize = 0;
@@ -1149,7 +1165,8 @@ size_t CTxMemPool::DynamicMemoryUsage() const {
                                  12 * sizeof(void *)) *
                mapTx.size() +
            memusage::DynamicUsage(mapNextTx) +
-           memusage::DynamicUsage(mapDeltas) + cachedInnerUsage;
+           memusage::DynamicUsage(mapDeltas) +
+           memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const TxId &txid, const bool unchecked) {
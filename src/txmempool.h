@@ -189,6 +189,9 @@ public:
 
     //! epoch when last touched, useful for graph algorithms
     mutable Epoch::Marker m_epoch_marker;
+
+    //! Index in the mempool's vTxHashes
+    mutable size_t vTxHashesIdx;
 };
 
 // extracts a transaction id from CTxMemPoolEntry or CTransactionRef
@@ -521,6 +524,12 @@ public:
     using txiter = indexed_transaction_set::nth_index<0>::type::const_iterator;
     typedef std::set<txiter, CompareIteratorById> setEntries;
 
+    /**
+     * All tx hashes/entries in mapTx, in random order. Kept contiguous so that
+     * compact block reconstruction can snapshot the hashes cheaply.
+     */
+    std::vector<std::pair<TxHash, txiter>> vTxHashes GUARDED_BY(cs);
+
     uint64_t CalculateDescendantMaximum(txiter entry) const
         EXCLUSIVE_LOCKS_REQUIRED(cs);
 
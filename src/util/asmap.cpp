@@ -9,6 +9,7 @@
 #include <logging.h>
 #include <streams.h>
 
+#include <algorithm>
 #include <cassert>
 #include <map>
 #include <vector>
@@ -165,6 +166,215 @@ uint32_t Interpret(const std::vector<bool> &asmap,
     return 0;
 }
 
+namespace {
+
+//! Maximum number of bits compared by a merged MATCH
+constexpr uint32_t MAX_MATCH_BITS = 32;
+
+/**
+ * Read len (1 to 64) bits of the address, starting at bit. The bits must lie
+ * within the address, which SanityCheckASMap guarantees for a valid map.
+ */
+uint64_t ReadBits(const std::array<uint64_t, 2> &ip, uint32_t bit,
+                  uint32_t len) {
+    assert(len >= 1 && len <= 64 && bit + len <= 128);
+    uint64_t window;
+    if (bit == 0) {
+        window = ip[0];
+    } else if (bit < 64) {
+        window = (ip[0] << bit) | (ip[1] >> (64 - bit));
+    } else {
+        window = ip[1] << (bit - 64);
+    }
+    return window >> (64 - len);
+}
+
+void SetBit(std::array<uint8_t, 16> &ip, uint32_t bit, bool value) {
+    const uint8_t mask = 0x80 >> (bit % 8);
+    ip[bit / 8] = value ? (ip[bit / 8] | mask) : (ip[bit / 8] & ~mask);
+}
+
+} // namespace
+
+CompiledAsmap::CompiledAsmap(const std::vector<bool> &asmap) {
+    const std::vector<bool>::const_iterator begin = asmap.begin(),
+                                            endpos = asmap.end();
+    std::vector<bool>::const_iterator pos = begin;
+    // Bit offset of each instruction in the program, to resolve the jumps
+    std::vector<uint32_t> offsets;
+    // Bit offsets that are jumped to. As the jumps are all forward, an
+    // instruction is known to be a jump target once it is reached.
+    std::vector<uint32_t> targets;
+    bool malformed = false;
+    while (pos != endpos && !malformed) {
+        const uint32_t offset = pos - begin;
+        const bool is_target =
+            std::binary_search(targets.begin(), targets.end(), offset);
+        const Instruction opcode = DecodeType(pos, endpos);
+        Op op{uint8_t(opcode), 0, 0};
+        if (opcode == Instruction::RETURN || opcode == Instruction::DEFAULT) {
+            op.arg = DecodeASN(pos, endpos);
+            malformed = op.arg == INVALID;
+        } else if (opcode == Instruction::JUMP) {
+            const uint32_t jump = DecodeJump(pos, endpos);
+            malformed = jump == INVALID || uint64_t(pos - begin) + jump >
+                                               uint64_t(endpos - begin);
+            // Resolved to an instruction index below
+            op.arg = (pos - begin) + jump;
+            targets.insert(
+                std::upper_bound(targets.begin(), targets.end(), op.arg),
+                op.arg);
+        } else if (opcode == Instruction::MATCH) {
+            const uint32_t match = DecodeMatch(pos, endpos);
+            malformed = match == INVALID;
+            op.match_len = CountBits(match) - 1;
+            op.arg = match & ((uint32_t(1) << op.match_len) - 1);
+            Op *prev = m_program.empty() ? nullptr : &m_program.back();
+            if (!malformed && !is_target && prev &&
+                prev->opcode == uint8_t(Instruction::MATCH) &&
+                prev->match_len + op.match_len <= MAX_MATCH_BITS) {
+                // Compare both runs of bits at once
+                prev->arg = (uint64_t(prev->arg) << op.match_len) | op.arg;
+                prev->match_len += op.match_len;
+                continue;
+            }
+        } else {
+            // Instruction straddles EOF
+            malformed = true;
+        }
+        offsets.push_back(offset);
+        m_program.push_back(op);
+        while (!targets.empty() && targets.front() <= offset) {
+            targets.erase(targets.begin());
+        }
+        if (opcode == Instruction::RETURN && targets.empty()) {
+            // The rest is padding
+            break;
+        }
+    }
+
+    for (Op &op : m_program) {
+        if (op.opcode != uint8_t(Instruction::JUMP)) {
+            continue;
+        }
+        auto it = std::lower_bound(offsets.begin(), offsets.end(), op.arg);
+        if (it == offsets.end() || *it != op.arg) {
+            // Jump into the middle of an instruction
+            malformed = true;
+            break;
+        }
+        op.arg = it - offsets.begin();
+    }
+
+    if (malformed) {
+        m_program.clear();
+    }
+}
+
+uint32_t CompiledAsmap::Lookup(const std::array<uint8_t, 16> &ip) const {
+    if (m_program.empty()) {
+        return 0;
+    }
+    const std::array<uint64_t, 2> ip_words{
+        {ReadBE64(ip.data()), ReadBE64(ip.data() + 8)}};
+    uint32_t default_asn = 0;
+    uint32_t bit = 0;
+    size_t pc = 0;
+    while (true) {
+        assert(pc < m_program.size() && bit <= 128);
+        const Op &op = m_program[pc];
+        switch (Instruction(op.opcode)) {
+            case Instruction::RETURN:
+                return op.arg;
+            case Instruction::JUMP:
+                pc = ReadBits(ip_words, bit++, 1) ? op.arg : pc + 1;
+                break;
+            case Instruction::MATCH:
+                if (ReadBits(ip_words, bit, op.match_len) != op.arg) {
+                    return default_asn;
+                }
+                bit += op.match_len;
+                ++pc;
+                break;
+            case Instruction::DEFAULT:
+                default_asn = op.arg;
+                ++pc;
+                break;
+        }
+    }
+}
+
+bool CompiledAsmap::CheckEquivalence(const std::vector<bool> &asmap) const {
+    if (m_program.empty()) {
+        return asmap.empty();
+    }
+
+    // Check the addresses sharing the first bits of ip, with the remaining
+    // bits all unset, then all set.
+    const auto check = [&](const std::array<uint8_t, 16> &ip, uint32_t bits) {
+        for (const bool fill : {false, true}) {
+            std::array<uint8_t, 16> addr = ip;
+            std::vector<bool> addr_bits(128);
+            for (uint32_t bit = 0; bit < 128; ++bit) {
+                if (bit >= bits) {
+                    SetBit(addr, bit, fill);
+                }
+                addr_bits[bit] = (addr[bit / 8] >> (7 - bit % 8)) & 1;
+            }
+            if (Interpret(asmap, addr_bits) != Lookup(addr)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    struct Path {
+        size_t pc;
+        //! Number of bits of ip fixed by the path so far
+        uint32_t bits;
+        std::array<uint8_t, 16> ip;
+    };
+    std::vector<Path> paths{{0, 0, {}}};
+    while (!paths.empty()) {
+        Path path = paths.back();
+        paths.pop_back();
+        const Op &op = m_program[path.pc];
+        switch (Instruction(op.opcode)) {
+            case Instruction::RETURN:
+                if (!check(path.ip, path.bits)) {
+                    return false;
+                }
+                break;
+            case Instruction::JUMP:
+                for (const bool bit : {false, true}) {
+                    Path next{bit ? op.arg : path.pc + 1, path.bits + 1,
+                              path.ip};
+                    SetBit(next.ip, path.bits, bit);
+                    paths.push_back(next);
+                }
+                break;
+            case Instruction::MATCH:
+                for (uint32_t i = 0; i < op.match_len; ++i) {
+                    const bool bit = (op.arg >> (op.match_len - 1 - i)) & 1;
+                    // An address that differs from the match at bit i
+                    std::array<uint8_t, 16> mismatch = path.ip;
+                    SetBit(mismatch, path.bits + i, !bit);
+                    if (!check(mismatch, path.bits + i + 1)) {
+                        return false;
+                    }
+                    SetBit(path.ip, path.bits + i, bit);
+                }
+                paths.push_back({path.pc + 1, path.bits + op.match_len,
+                                 path.ip});
+                break;
+            case Instruction::DEFAULT:
+                paths.push_back({path.pc + 1, path.bits, path.ip});
+                break;
+        }
+    }
+    return true;
+}
+
 bool SanityCheckASMap(const std::vector<bool> &asmap, int bits) {
     const std::vector<bool>::const_iterator begin = asmap.begin(),
                                             endpos = asmap.end();
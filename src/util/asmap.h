@@ -7,11 +7,47 @@
 
 #include <fs.h>
 
+#include <array>
 #include <cstdint>
 #include <vector>
 
 uint32_t Interpret(const std::vector<bool> &asmap, const std::vector<bool> &ip);
 
+/**
+ * An asmap decoded once into a compact prefix trie: an array of instructions
+ * with the jump targets resolved and the runs of MATCH instructions merged,
+ * so looking up an address no longer decodes the bytecode bit by bit.
+ *
+ * The asmap must pass SanityCheckASMap(asmap, 128), otherwise nothing is
+ * mapped.
+ */
+class CompiledAsmap {
+public:
+    CompiledAsmap() = default;
+    explicit CompiledAsmap(const std::vector<bool> &asmap);
+
+    bool empty() const { return m_program.empty(); }
+
+    /** Same as Interpret() for the 128 bits of the address. */
+    uint32_t Lookup(const std::array<uint8_t, 16> &ip) const;
+
+    /**
+     * Check that Lookup() and Interpret() agree on every path through the
+     * trie, for addresses taking that path.
+     */
+    bool CheckEquivalence(const std::vector<bool> &asmap) const;
+
+private:
+    struct Op {
+        uint8_t opcode;
+        //! Number of bits compared by a MATCH
+        uint8_t match_len;
+        //! The ASN, the index of the jump target or the bits to match
+        uint32_t arg;
+    };
+    std::vector<Op> m_program;
+};
+
 bool SanityCheckASMap(const std::vector<bool> &asmap, int bits);
 
 /** Read asmap from provided binary file */
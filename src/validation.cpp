@@ -50,6 +50,7 @@
 #include <util/check.h> // For NDEBUG compile time check
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <util/thread.h>
 #include <util/trace.h>
 #include <util/translation.h>
 #include <validationinterface.h>
@@ -58,6 +59,7 @@
 #include <boost/algorithm/string/replace.hpp>
 
 #include <algorithm>
+#include <future>
 #include <numeric>
 #include <optional>
 #include <string>
@@ -76,6 +78,7 @@ using node::GetUTXOStats;
 using node::nPruneTarget;
 using node::OpenBlockFile;
 using node::ReadBlockFromDisk;
+using node::SerializedCoinsHasher;
 using node::SnapshotMetadata;
 using node::UNDOFILE_CHUNK_SIZE;
 using node::UndoReadFromDisk;
@@ -1432,7 +1435,7 @@ bool CScriptCheck::operator()() {
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
     if (!VerifyScript(scriptSig, m_tx_out.scriptPubKey, nFlags,
                       CachingTransactionSignatureChecker(
-                          ptxTo, nIn, m_tx_out.nValue, cacheStore, txdata),
+                          ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata),
                       metrics, &error)) {
         return false;
     }
@@ -1678,12 +1681,132 @@ DisconnectResult ApplyBlockUndo(const CBlockUndo &blockUndo,
 
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
+/**
+ * Closure over a chunk of the transactions of a block, so the context free and
+ * contextual block checks can be spread over the script check threads.
+ */
+class CBlockChunkCheck {
+private:
+    const std::function<bool(size_t)> *m_check{nullptr};
+    size_t m_begin{0};
+    size_t m_end{0};
+
+public:
+    CBlockChunkCheck() {}
+    CBlockChunkCheck(const std::function<bool(size_t)> &check, size_t begin,
+                     size_t end)
+        : m_check(&check), m_begin(begin), m_end(end) {}
+
+    bool operator()() {
+        for (size_t i = m_begin; i < m_end; i++) {
+            if (!(*m_check)(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void swap(CBlockChunkCheck &check) noexcept {
+        std::swap(m_check, check.m_check);
+        std::swap(m_begin, check.m_begin);
+        std::swap(m_end, check.m_end);
+    }
+};
+
+/**
+ * The block checks get their own queue, since CheckBlock is also called from
+ * the network threads while ConnectBlock holds the script check queue.
+ */
+static CCheckQueue<CBlockChunkCheck> blockcheckqueue(1);
+
+//! Blocks are checked in parallel in chunks of 2^BLOCK_CHECK_CHUNK_HEIGHT
+//! transactions, which is also the height of the merkle subtrees.
+static constexpr size_t BLOCK_CHECK_CHUNK_HEIGHT = 12;
+static constexpr size_t BLOCK_CHECK_CHUNK_SIZE = size_t(1)
+                                                 << BLOCK_CHECK_CHUNK_HEIGHT;
+
 void StartScriptCheckWorkerThreads(int threads_num) {
     scriptcheckqueue.StartWorkerThreads(threads_num);
+    blockcheckqueue.StartWorkerThreads(threads_num);
 }
 
 void StopScriptCheckWorkerThreads() {
     scriptcheckqueue.StopWorkerThreads();
+    blockcheckqueue.StopWorkerThreads();
+}
+
+/**
+ * Run check over the [begin, end) range of transaction indexes of a block on
+ * the script check threads.
+ *
+ * Returns true if the range is large enough to be worth splitting and check
+ * passed for all the indexes. Otherwise the caller is expected to run its
+ * serial checks, which also report the first failure with its reason.
+ */
+static bool ParallelBlockCheckPasses(size_t begin, size_t end,
+                                     const std::function<bool(size_t)> &check) {
+    if (end <= begin || end - begin <= BLOCK_CHECK_CHUNK_SIZE) {
+        return false;
+    }
+
+    std::vector<CBlockChunkCheck> checks;
+    checks.reserve((end - begin) / BLOCK_CHECK_CHUNK_SIZE + 1);
+    for (size_t i = begin; i < end; i += BLOCK_CHECK_CHUNK_SIZE) {
+        checks.emplace_back(check, i,
+                            std::min(end, i + BLOCK_CHECK_CHUNK_SIZE));
+    }
+
+    CCheckQueueControl<CBlockChunkCheck> control(&blockcheckqueue);
+    control.Add(checks);
+    return control.Wait();
+}
+
+/**
+ * Compute the merkle root of a block, hashing the subtrees of large blocks on
+ * the script check threads.
+ */
+static uint256 ParallelBlockMerkleRoot(const CBlock &block, bool *mutated) {
+    const size_t chunks = (block.vtx.size() + BLOCK_CHECK_CHUNK_SIZE - 1) /
+                          BLOCK_CHECK_CHUNK_SIZE;
+    if (chunks <= 1) {
+        return BlockMerkleRoot(block, mutated);
+    }
+
+    std::vector<uint256> subtree_roots(chunks);
+    std::vector<uint8_t> subtree_mutated(chunks);
+    const std::function<bool(size_t)> hash_subtree = [&](size_t chunk) {
+        const size_t begin = chunk * BLOCK_CHECK_CHUNK_SIZE;
+        const size_t end =
+            std::min(block.vtx.size(), begin + BLOCK_CHECK_CHUNK_SIZE);
+        std::vector<uint256> leaves;
+        leaves.reserve(end - begin);
+        for (size_t i = begin; i < end; i++) {
+            leaves.push_back(block.vtx[i]->GetId());
+        }
+        bool mutation;
+        subtree_roots[chunk] = ComputeMerkleSubtreeRoot(
+            std::move(leaves), BLOCK_CHECK_CHUNK_HEIGHT, &mutation);
+        subtree_mutated[chunk] = mutation;
+        return true;
+    };
+
+    std::vector<CBlockChunkCheck> checks;
+    checks.reserve(chunks);
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        checks.emplace_back(hash_subtree, chunk, chunk + 1);
+    }
+    {
+        CCheckQueueControl<CBlockChunkCheck> control(&blockcheckqueue);
+        control.Add(checks);
+        control.Wait();
+    }
+
+    const uint256 root = ComputeMerkleRoot(std::move(subtree_roots), mutated);
+    if (mutated) {
+        *mutated |= std::any_of(subtree_mutated.begin(), subtree_mutated.end(),
+                                [](uint8_t mutation) { return mutation; });
+    }
+    return root;
 }
 
 // Returns the script flags which should be checked for the block after
@@ -2012,6 +2135,10 @@ bool CChainState::ConnectBlock(const CBlock &block, BlockValidationState &state,
     CBlockUndo blockundo;
     blockundo.vtxundo.resize(block.vtx.size() - 1);
 
+    // The script checks of a transaction all refer to its precomputed data,
+    // which must therefore outlive the check queue control below.
+    std::vector<PrecomputedTransactionData> txsdata(block.vtx.size() - 1);
+
     CCheckQueueControl<CScriptCheck> control(fScriptChecks ? &scriptcheckqueue
                                                            : nullptr);
 
@@ -2038,6 +2165,8 @@ bool CChainState::ConnectBlock(const CBlock &block, BlockValidationState &state,
     // nSigChecksRet may be accurate (found in cache) or 0 (checks were
     // deferred into vChecks).
     int nSigChecksRet;
+    // Reused for every transaction so its buffer is only grown, never freed.
+    std::vector<CScriptCheck> vChecks;
     for (const auto &ptx : block.vtx) {
         const CTransaction &tx = *ptx;
         const bool isCoinBase = tx.IsCoinBase();
@@ -2100,12 +2229,14 @@ bool CChainState::ConnectBlock(const CBlock &block, BlockValidationState &state,
             nSigChecksTxLimiters[txIndex] = TxSigCheckLimiter::getDisabled();
         }
 
-        std::vector<CScriptCheck> vChecks;
         TxValidationState tx_state;
+        if (fScriptChecks) {
+            txsdata[txIndex] = PrecomputedTransactionData(tx);
+        }
         if (fScriptChecks &&
             !CheckInputScripts(tx, tx_state, view, flags, fCacheResults,
-                               fCacheResults, PrecomputedTransactionData(tx),
-                               nSigChecksRet, nSigChecksTxLimiters[txIndex],
+                               fCacheResults, txsdata[txIndex], nSigChecksRet,
+                               nSigChecksTxLimiters[txIndex],
                                &nSigChecksBlockLimiter, &vChecks)) {
             // Any transaction validation failure in ConnectBlock is a block
             // consensus failure
@@ -2118,6 +2249,7 @@ bool CChainState::ConnectBlock(const CBlock &block, BlockValidationState &state,
         }
 
         control.Add(vChecks);
+        vChecks.clear();
 
         // Note: this must execute in the same iteration as CheckTxInputs (not
         // in a separate loop) in order to detect double spends. However,
@@ -2509,6 +2641,10 @@ bool CChainState::DisconnectTip(BlockValidationState &state,
 
     assert(pindexDelete);
 
+    // The block being prefetched was a descendant of the tip, it won't be
+    // connected next.
+    m_block_prefetcher.Cancel();
+
     // Read block from disk.
     std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
     CBlock &block = *pblock;
@@ -2698,9 +2834,130 @@ const CBlockIndex *CChainState::FindBlockToFinalize(CBlockIndex *pindexNew) {
     return nullptr;
 }
 
+BlockPrefetcher::~BlockPrefetcher() {
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void BlockPrefetcher::Prefetch(
+    const BlockHash &hash, const FlatFilePos &pos,
+    const Consensus::Params &params,
+    const BlockValidationOptions &validationOptions) {
+    {
+        LOCK(m_mutex);
+        if (m_job && m_job->hash == hash) {
+            return;
+        }
+        m_job = Job{hash, pos, &params, validationOptions};
+        m_job_pending = true;
+        ++m_job_id;
+        m_job_done = false;
+        m_block.reset();
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(&util::TraceThread, "prefetch",
+                                   [this] { ThreadPrefetch(); });
+        }
+    }
+    m_cv.notify_all();
+}
+
+std::shared_ptr<const CBlock> BlockPrefetcher::Take(const BlockHash &hash) {
+    WAIT_LOCK(m_mutex, lock);
+    std::shared_ptr<const CBlock> block;
+    if (m_job && m_job->hash == hash) {
+        lock.Wait(m_cv, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return m_job_done;
+        });
+        block = std::move(m_block);
+    }
+    // A prefetched block for another index is released here as well, so it
+    // does not stay in memory once the tip has moved past it.
+    m_job.reset();
+    m_job_pending = false;
+    ++m_job_id;
+    m_job_done = false;
+    m_block.reset();
+    return block;
+}
+
+void BlockPrefetcher::Cancel() {
+    LOCK(m_mutex);
+    m_job.reset();
+    m_job_pending = false;
+    ++m_job_id;
+    m_job_done = false;
+    m_block.reset();
+}
+
+void BlockPrefetcher::ThreadPrefetch() {
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        lock.Wait(m_cv, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return m_stop || m_job_pending;
+        });
+        if (m_stop) {
+            return;
+        }
+        const Job job = *m_job;
+        const uint64_t job_id = m_job_id;
+        m_job_pending = false;
+
+        std::shared_ptr<CBlock> block;
+        {
+            REVERSE_LOCK(lock);
+            block = std::make_shared<CBlock>();
+            if (!ReadBlockFromDisk(*block, job.pos, *job.params) ||
+                block->GetHash() != job.hash) {
+                block.reset();
+            } else {
+                // On success this marks the block as checked, so ConnectBlock
+                // does not have to repeat the merkle root and transaction
+                // checks. On failure they are simply repeated and reported
+                // from ConnectBlock.
+                BlockValidationState dummy;
+                CheckBlock(*block, dummy, *job.params, job.validationOptions);
+            }
+        }
+
+        // The job was replaced or cancelled while the block was being read
+        if (job_id != m_job_id) {
+            continue;
+        }
+        m_block = std::move(block);
+        m_job_done = true;
+        m_cv.notify_all();
+    }
+}
+
+void CChainState::PrefetchBlock(const Config &config,
+                                const CBlockIndex *pindex) {
+    AssertLockHeld(cs_main);
+    if (!pindex->nStatus.hasData()) {
+        m_block_prefetcher.Cancel();
+        return;
+    }
+
+    // Everything the worker needs is copied out while cs_main is held, so
+    // it never has to take the lock itself.
+    m_block_prefetcher.Prefetch(pindex->GetBlockHash(), pindex->GetBlockPos(),
+                                m_params.GetConsensus(),
+                                BlockValidationOptions(config));
+}
+
+std::shared_ptr<const CBlock>
+CChainState::TakePrefetchedBlock(const CBlockIndex *pindex) {
+    AssertLockHeld(cs_main);
+    return m_block_prefetcher.Take(pindex->GetBlockHash());
+}
+
 /**
  * Connect a new block to m_chain. pblock is either nullptr or a pointer to
  * a CBlock corresponding to pindexNew, to bypass loading it again from disk.
+ * If pindexNext is not nullptr, its block is read from disk in the background
+ * while pindexNew is being connected.
  *
  * The block is always added to connectTrace (either after loading from disk or
  * by copying pblock) - if that is not intended, care must be taken to remove
@@ -2710,7 +2967,8 @@ bool CChainState::ConnectTip(const Config &config, BlockValidationState &state,
                              CBlockIndex *pindexNew,
                              const std::shared_ptr<const CBlock> &pblock,
                              ConnectTrace &connectTrace,
-                             DisconnectedBlockTransactions &disconnectpool) {
+                             DisconnectedBlockTransactions &disconnectpool,
+                             const CBlockIndex *pindexNext) {
     AssertLockHeld(cs_main);
     if (m_mempool) {
         AssertLockHeld(m_mempool->cs);
@@ -2719,17 +2977,26 @@ bool CChainState::ConnectTip(const Config &config, BlockValidationState &state,
     const Consensus::Params &consensusParams = m_params.GetConsensus();
 
     assert(pindexNew->pprev == m_chain.Tip());
-    // Read block from disk.
+    // Read block from disk, unless it was already prefetched.
     int64_t nTime1 = GetTimeMicros();
     std::shared_ptr<const CBlock> pthisBlock;
     if (!pblock) {
-        std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
-        if (!ReadBlockFromDisk(*pblockNew, pindexNew, consensusParams)) {
-            return AbortNode(state, "Failed to read block");
+        pthisBlock = TakePrefetchedBlock(pindexNew);
+        if (!pthisBlock) {
+            std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
+            if (!ReadBlockFromDisk(*pblockNew, pindexNew, consensusParams)) {
+                return AbortNode(state, "Failed to read block");
+            }
+            pthisBlock = pblockNew;
         }
-        pthisBlock = pblockNew;
     } else {
         pthisBlock = pblock;
+        // Only releases a prefetched block that is not needed anymore
+        m_block_prefetcher.Cancel();
+    }
+
+    if (pindexNext) {
+        PrefetchBlock(config, pindexNext);
     }
 
     const CBlock &blockConnecting = *pthisBlock;
@@ -3089,11 +3356,23 @@ bool CChainState::ActivateBestChainStep(
 
         // Connect new blocks.
         for (CBlockIndex *pindexConnect : reverse_iterate(vpindexToConnect)) {
+            // Let the block after this one be read while this one connects,
+            // unless it is the one we were handed already.
+            const CBlockIndex *pindexNext = nullptr;
+            if (pindexConnect != pindexMostWork) {
+                pindexNext =
+                    pindexMostWork->GetAncestor(pindexConnect->nHeight + 1);
+                if (pindexNext == pindexMostWork && pblock) {
+                    pindexNext = nullptr;
+                }
+            }
             if (!ConnectTip(config, state, pindexConnect,
                             pindexConnect == pindexMostWork
                                 ? pblock
                                 : std::shared_ptr<const CBlock>(),
-                            connectTrace, disconnectpool)) {
+                            connectTrace, disconnectpool, pindexNext)) {
+                // The next block won't be connected after this one.
+                m_block_prefetcher.Cancel();
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
                     if (state.GetResult() !=
@@ -3882,7 +4161,7 @@ bool CheckBlock(const CBlock &block, BlockValidationState &state,
     // Check the merkle root.
     if (validationOptions.shouldValidateMerkleRoot()) {
         bool mutated;
-        uint256 hashMerkleRoot2 = BlockMerkleRoot(block, &mutated);
+        uint256 hashMerkleRoot2 = ParallelBlockMerkleRoot(block, &mutated);
         if (block.hashMerkleRoot != hashMerkleRoot2) {
             return state.Invalid(BlockValidationResult::BLOCK_MUTATED,
                                  "bad-txnmrklroot", "hashMerkleRoot mismatch");
@@ -3934,14 +4213,23 @@ bool CheckBlock(const CBlock &block, BlockValidationState &state,
 
     // Check transactions for regularity, skipping the first. Note that this
     // is the first time we check that all after the first are !IsCoinBase.
-    for (size_t i = 1; i < block.vtx.size(); i++) {
-        auto *tx = block.vtx[i].get();
-        if (!CheckRegularTransaction(*tx, tx_state)) {
-            return state.Invalid(
-                BlockValidationResult::BLOCK_CONSENSUS,
-                tx_state.GetRejectReason(),
-                strprintf("Transaction check failed (txid %s) %s",
-                          tx->GetId().ToString(), tx_state.GetDebugMessage()));
+    // Large blocks are checked in parallel first, and only go through the loop
+    // below to report the first failure.
+    const std::function<bool(size_t)> check_tx = [&block](size_t i) {
+        TxValidationState state;
+        return CheckRegularTransaction(*block.vtx[i], state);
+    };
+    if (!ParallelBlockCheckPasses(1, block.vtx.size(), check_tx)) {
+        for (size_t i = 1; i < block.vtx.size(); i++) {
+            auto *tx = block.vtx[i].get();
+            if (!CheckRegularTransaction(*tx, tx_state)) {
+                return state.Invalid(
+                    BlockValidationResult::BLOCK_CONSENSUS,
+                    tx_state.GetRejectReason(),
+                    strprintf("Transaction check failed (txid %s) %s",
+                              tx->GetId().ToString(),
+                              tx_state.GetDebugMessage()));
+            }
         }
     }
 
@@ -4103,37 +4391,54 @@ static bool ContextualCheckBlock(const CBlock &block,
     // - canonical ordering
     // - ensure they are finalized
     // - check they have the minimum size
-    const CTransaction *prevTx = nullptr;
-    for (const auto &ptx : block.vtx) {
-        const CTransaction &tx = *ptx;
-        if (fIsMagneticAnomalyEnabled) {
-            if (prevTx && (tx.GetId() <= prevTx->GetId())) {
-                if (tx.GetId() == prevTx->GetId()) {
-                    return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
-                                         "tx-duplicate",
-                                         strprintf("Duplicated transaction %s",
-                                                   tx.GetId().ToString()));
+    // Large blocks are checked in parallel first, and only go through the loop
+    // below to report the first failure. The ordering is checked against the
+    // previous transaction, except for the one following the coinbase.
+    const std::function<bool(size_t)> check_tx = [&](size_t i) {
+        const CTransaction &tx = *block.vtx[i];
+        if (fIsMagneticAnomalyEnabled && i > 0 &&
+            (i > 1 || !block.vtx[0]->IsCoinBase()) &&
+            tx.GetId() <= block.vtx[i - 1]->GetId()) {
+            return false;
+        }
+        TxValidationState tx_state;
+        return ContextualCheckTransaction(params, tx, tx_state, nHeight,
+                                          nLockTimeCutoff);
+    };
+    if (!ParallelBlockCheckPasses(0, block.vtx.size(), check_tx)) {
+        const CTransaction *prevTx = nullptr;
+        for (const auto &ptx : block.vtx) {
+            const CTransaction &tx = *ptx;
+            if (fIsMagneticAnomalyEnabled) {
+                if (prevTx && (tx.GetId() <= prevTx->GetId())) {
+                    if (tx.GetId() == prevTx->GetId()) {
+                        return state.Invalid(
+                            BlockValidationResult::BLOCK_CONSENSUS,
+                            "tx-duplicate",
+                            strprintf("Duplicated transaction %s",
+                                      tx.GetId().ToString()));
+                    }
+
+                    return state.Invalid(
+                        BlockValidationResult::BLOCK_CONSENSUS, "tx-ordering",
+                        strprintf("Transaction order is invalid (%s < %s)",
+                                  tx.GetId().ToString(),
+                                  prevTx->GetId().ToString()));
                 }
 
-                return state.Invalid(
-                    BlockValidationResult::BLOCK_CONSENSUS, "tx-ordering",
-                    strprintf("Transaction order is invalid (%s < %s)",
-                              tx.GetId().ToString(),
-                              prevTx->GetId().ToString()));
+                if (prevTx || !tx.IsCoinBase()) {
+                    prevTx = &tx;
+                }
             }
 
-            if (prevTx || !tx.IsCoinBase()) {
-                prevTx = &tx;
+            TxValidationState tx_state;
+            if (!ContextualCheckTransaction(params, tx, tx_state, nHeight,
+                                            nLockTimeCutoff)) {
+                return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
+                                     tx_state.GetRejectReason(),
+                                     tx_state.GetDebugMessage());
             }
         }
-
-        TxValidationState tx_state;
-        if (!ContextualCheckTransaction(params, tx, tx_state, nHeight,
-                                        nLockTimeCutoff)) {
-            return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
-                                 tx_state.GetRejectReason(),
-                                 tx_state.GetDebugMessage());
-        }
     }
 
     // Enforce rule that the coinbase starts with serialized block height
@@ -5579,6 +5884,38 @@ bool CChainState::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size) {
 
 static const uint64_t MEMPOOL_DUMP_VERSION = 1;
 
+/**
+ * Populate the signature and script execution caches with the result of
+ * checking the scripts of a transaction against the next block's consensus
+ * flags. Used for persisted transactions that could not be accepted back into
+ * the mempool for policy reasons, as they are still likely to be mined soon.
+ */
+static bool WarmValidationCaches(const Config &config, CChainState &chainstate,
+                                 const CTxMemPool &pool,
+                                 const CTransaction &tx)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+    AssertLockHeld(cs_main);
+    if (tx.IsCoinBase()) {
+        return false;
+    }
+
+    LOCK(pool.cs);
+    CCoinsViewMemPool view_mempool(&chainstate.CoinsTip(), pool);
+    CCoinsViewCache view(&view_mempool);
+    if (!view.HaveInputs(tx)) {
+        return false;
+    }
+
+    const uint32_t flags =
+        GetNextBlockScriptFlags(config.GetChainParams().GetConsensus(),
+                                chainstate.m_chain.Tip());
+    PrecomputedTransactionData txdata(tx);
+    TxValidationState state;
+    int nSigChecks;
+    return CheckInputScripts(tx, state, view, flags, /*sigCacheStore=*/true,
+                             /*scriptCacheStore=*/true, txdata, nSigChecks);
+}
+
 bool LoadMempool(const Config &config, CTxMemPool &pool,
                  CChainState &active_chainstate) {
     int64_t nExpiryTimeout =
@@ -5597,6 +5934,7 @@ bool LoadMempool(const Config &config, CTxMemPool &pool,
     int64_t failed = 0;
     int64_t already_there = 0;
     int64_t unbroadcast = 0;
+    int64_t warmed = 0;
     int64_t nNow = GetTime();
 
     try {
@@ -5639,6 +5977,15 @@ bool LoadMempool(const Config &config, CTxMemPool &pool,
                         ++already_there;
                     } else {
                         ++failed;
+                        // The transaction might still be mined, e.g. if it
+                        // was only rejected because the mempool is now
+                        // smaller, so make sure its scripts are cached.
+                        if (accepted.m_state.GetResult() !=
+                                TxValidationResult::TX_CONSENSUS &&
+                            WarmValidationCaches(config, active_chainstate,
+                                                 pool, *tx)) {
+                            ++warmed;
+                        }
                     }
                 }
             } else {
@@ -5674,9 +6021,9 @@ bool LoadMempool(const Config &config, CTxMemPool &pool,
     }
 
     LogPrintf("Imported mempool transactions from disk: %i succeeded, %i "
-              "failed, %i expired, %i already there, %i waiting for initial "
-              "broadcast\n",
-              count, failed, expired, already_there, unbroadcast);
+              "failed (%i still cached for block validation), %i expired, %i "
+              "already there, %i waiting for initial broadcast\n",
+              count, failed, warmed, expired, already_there, unbroadcast);
     return true;
 }
 
@@ -5973,6 +6320,35 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
               base_blockhash.ToString());
     int64_t coins_processed{0};
 
+    // Snapshots list the coins in database order, so their content hash can
+    // be computed on a separate thread while they are being loaded instead of
+    // walking the whole coins database once they have been written. If the
+    // snapshot turns out not to be in that order, the database walk is used.
+    SerializedCoinsHasher streaming_hasher{base_blockhash};
+    bool streaming_hash_usable{true};
+    std::vector<std::pair<COutPoint, Coin>> hash_batch;
+    std::future<bool> hash_batch_result;
+    auto hash_pending_coins = [&]() {
+        if (hash_batch_result.valid() && !hash_batch_result.get()) {
+            streaming_hash_usable = false;
+        }
+        if (!streaming_hash_usable) {
+            hash_batch.clear();
+            return;
+        }
+        hash_batch_result = std::async(
+            std::launch::async,
+            [&streaming_hasher, batch = std::move(hash_batch)]() {
+                for (const auto &[batch_outpoint, batch_coin] : batch) {
+                    if (!streaming_hasher.Add(batch_outpoint, batch_coin)) {
+                        return false;
+                    }
+                }
+                return true;
+            });
+        hash_batch.clear();
+    };
+
     while (coins_left > 0) {
         try {
             coins_file >> outpoint;
@@ -5992,6 +6368,12 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
                 coins_count - coins_left);
             return false;
         }
+        if (streaming_hash_usable) {
+            hash_batch.emplace_back(outpoint, coin);
+            if (hash_batch.size() >= 100000) {
+                hash_pending_coins();
+            }
+        }
         coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint),
                                               std::move(coin));
 
@@ -6063,16 +6445,30 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     assert(coins_cache.GetBestBlock() == base_blockhash);
 
     CCoinsStats stats{CoinStatsHashType::HASH_SERIALIZED};
-    auto breakpoint_fnc = [] { /* TODO insert breakpoint here? */ };
 
-    // As above, okay to immediately release cs_main here since no other context
-    // knows about the snapshot_chainstate.
-    CCoinsViewDB *snapshot_coinsdb =
-        WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
+    hash_pending_coins();
+    if (hash_batch_result.valid() && !hash_batch_result.get()) {
+        streaming_hash_usable = false;
+    }
 
-    if (!GetUTXOStats(snapshot_coinsdb, m_blockman, stats, breakpoint_fnc)) {
-        LogPrintf("[snapshot] failed to generate coins stats\n");
-        return false;
+    if (streaming_hash_usable) {
+        stats.hashSerialized = streaming_hasher.Finalize();
+    } else {
+        LogPrintf("[snapshot] coins are not in database order, hashing the "
+                  "coins database instead\n");
+
+        auto breakpoint_fnc = [] { /* TODO insert breakpoint here? */ };
+
+        // As above, okay to immediately release cs_main here since no other
+        // context knows about the snapshot_chainstate.
+        CCoinsViewDB *snapshot_coinsdb =
+            WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
+
+        if (!GetUTXOStats(snapshot_coinsdb, m_blockman, stats,
+                          breakpoint_fnc)) {
+            LogPrintf("[snapshot] failed to generate coins stats\n");
+            return false;
+        }
     }
 
     // Assert that the deserialized chainstate contents match the expected
@@ -33,6 +33,7 @@
 #include <util/translation.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -507,15 +508,16 @@ private:
     bool cacheStore;
     ScriptError error;
     ScriptExecutionMetrics metrics;
-    PrecomputedTransactionData txdata;
+    //! Shared by all the checks of a transaction, must outlive them.
+    const PrecomputedTransactionData *txdata;
     TxSigCheckLimiter *pTxLimitSigChecks;
     CheckInputsLimiter *pBlockLimitSigChecks;
 
 public:
     CScriptCheck()
         : ptxTo(nullptr), nIn(0), nFlags(0), cacheStore(false),
-          error(ScriptError::UNKNOWN), txdata(), pTxLimitSigChecks(nullptr),
-          pBlockLimitSigChecks(nullptr) {}
+          error(ScriptError::UNKNOWN), txdata(nullptr),
+          pTxLimitSigChecks(nullptr), pBlockLimitSigChecks(nullptr) {}
 
     CScriptCheck(const CTxOut &outIn, const CTransaction &txToIn,
                  unsigned int nInIn, uint32_t nFlagsIn, bool cacheIn,
@@ -523,10 +525,17 @@ public:
                  TxSigCheckLimiter *pTxLimitSigChecksIn = nullptr,
                  CheckInputsLimiter *pBlockLimitSigChecksIn = nullptr)
         : m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn),
-          cacheStore(cacheIn), error(ScriptError::UNKNOWN), txdata(txdataIn),
+          cacheStore(cacheIn), error(ScriptError::UNKNOWN), txdata(&txdataIn),
           pTxLimitSigChecks(pTxLimitSigChecksIn),
           pBlockLimitSigChecks(pBlockLimitSigChecksIn) {}
 
+    //! The txdata is not copied, so it can't be a temporary.
+    CScriptCheck(const CTxOut &outIn, const CTransaction &txToIn,
+                 unsigned int nInIn, uint32_t nFlagsIn, bool cacheIn,
+                 PrecomputedTransactionData &&txdataIn,
+                 TxSigCheckLimiter *pTxLimitSigChecksIn = nullptr,
+                 CheckInputsLimiter *pBlockLimitSigChecksIn = nullptr) = delete;
+
     bool operator()();
 
     void swap(CScriptCheck &check) {
@@ -636,6 +645,61 @@ public:
     void InitCache() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 };
 
+/**
+ * Reads a block from disk and checks it for context-free validity on a
+ * background thread, while the block before it is being connected. A single
+ * worker thread is started on the first prefetch and serves all of them.
+ *
+ * Only the latest requested block is kept. Replacing or cancelling a prefetch
+ * never waits for the worker: a read in progress completes in the background
+ * and its result is discarded.
+ */
+class BlockPrefetcher {
+public:
+    ~BlockPrefetcher();
+
+    /**
+     * Start reading the block at pos, replacing any prefetched block. Nothing
+     * is done if hash is already being prefetched.
+     */
+    void Prefetch(const BlockHash &hash, const FlatFilePos &pos,
+                  const Consensus::Params &params,
+                  const BlockValidationOptions &validationOptions)
+        LOCKS_EXCLUDED(m_mutex);
+    /**
+     * Return the prefetched block if it is hash, waiting for it to be read if
+     * needed, or nullptr. Any prefetched block is released.
+     */
+    std::shared_ptr<const CBlock> Take(const BlockHash &hash)
+        LOCKS_EXCLUDED(m_mutex);
+    /** Release the prefetched block, if any, without waiting for it */
+    void Cancel() LOCKS_EXCLUDED(m_mutex);
+
+private:
+    struct Job {
+        BlockHash hash;
+        FlatFilePos pos;
+        const Consensus::Params *params;
+        BlockValidationOptions validationOptions;
+    };
+
+    void ThreadPrefetch() LOCKS_EXCLUDED(m_mutex);
+
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! The requested block, until it is taken or replaced
+    std::optional<Job> m_job GUARDED_BY(m_mutex);
+    //! Whether the worker has to read m_job
+    bool m_job_pending GUARDED_BY(m_mutex){false};
+    //! Incremented when m_job changes, so a stale result is discarded
+    uint64_t m_job_id GUARDED_BY(m_mutex){0};
+    //! Whether m_block holds the result of m_job
+    bool m_job_done GUARDED_BY(m_mutex){false};
+    std::shared_ptr<const CBlock> m_block GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+};
+
 enum class CoinsCacheSizeState {
     //! The coins cache is in immediate need of a flush.
     CRITICAL = 2,
@@ -708,6 +772,9 @@ private:
     const CBlockIndex *m_avalancheFinalizedBlockIndex
         GUARDED_BY(cs_avalancheFinalizedBlockIndex) = nullptr;
 
+    //! Reads the block to be connected next while the tip is connected
+    BlockPrefetcher m_block_prefetcher;
+
 public:
     //! Reference to a BlockManager instance which itself is shared across all
     //! CChainState instances.
@@ -1008,8 +1075,22 @@ private:
                     CBlockIndex *pindexNew,
                     const std::shared_ptr<const CBlock> &pblock,
                     ConnectTrace &connectTrace,
-                    DisconnectedBlockTransactions &disconnectpool)
+                    DisconnectedBlockTransactions &disconnectpool,
+                    const CBlockIndex *pindexNext = nullptr)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
+    /**
+     * Start reading pindex's block from disk in the background, replacing
+     * any block that was previously being prefetched.
+     */
+    void PrefetchBlock(const Config &config, const CBlockIndex *pindex)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /**
+     * Return the prefetched block for pindex, waiting for it if needed, or
+     * nullptr if it was not prefetched or could not be read. Any prefetched
+     * block is released.
+     */
+    std::shared_ptr<const CBlock> TakePrefetchedBlock(const CBlockIndex *pindex)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     void InvalidBlockFound(CBlockIndex *pindex,
                            const BlockValidationState &state)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -215,7 +215,7 @@ void UnloadWallet(std::shared_ptr<CWallet> &&wallet) {
     {
         WAIT_LOCK(g_wallet_release_mutex, lock);
         while (g_unloading_wallet_set.count(name) == 1) {
-            g_wallet_release_cv.wait(lock);
+            lock.Wait(g_wallet_release_cv);
         }
     }
 }
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+# Copyright (c) 2022 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""
+Test that reloading the persisted mempool on startup populates the script
+execution cache, so the first block connected after a restart does not need
+to execute the scripts of the transactions again.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+NUM_TXS = 10
+
+
+class MempoolPersistValidationCacheTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+
+    def send_txs(self):
+        return [self.wallet.send_self_transfer(from_node=self.nodes[0])
+                for _ in range(NUM_TXS)]
+
+    def restart_and_wait_for_mempool(self, extra_args=None):
+        node = self.nodes[0]
+        self.restart_node(0, extra_args=extra_args)
+        self.wait_until(lambda: node.getmempoolinfo()['loaded'])
+
+    def check_first_block_hits_cache(self, mine_block):
+        node = self.nodes[0]
+        before = node.getvalidationcacheinfo()['script']
+        mine_block()
+        after = node.getvalidationcacheinfo()['script']
+
+        hits = after['hits'] - before['hits']
+        misses = after['misses'] - before['misses']
+        self.log.info(
+            f"First block after restart: {hits} script cache hits, {misses} "
+            f"misses")
+        assert_equal(misses, 0)
+        assert hits >= NUM_TXS
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.wallet = MiniWallet(node)
+        # Independent coinbase outputs so the transactions do not depend on
+        # each other.
+        self.wallet.generate(NUM_TXS)
+        self.generate(node, 100)
+
+        self.log.info("Check the caches are warmed by the reloaded mempool")
+        self.send_txs()
+        self.restart_and_wait_for_mempool()
+        assert_equal(node.getmempoolinfo()['size'], NUM_TXS)
+        self.check_first_block_hits_cache(lambda: self.generate(node, 1))
+        assert_equal(node.getmempoolinfo()['size'], 0)
+
+        self.log.info(
+            "Check the caches are warmed by transactions rejected by policy "
+            "during the reload")
+        self.wallet.rescan_utxos()
+        txs = self.send_txs()
+        with node.assert_debug_log([f"{NUM_TXS} failed ({NUM_TXS} still "
+                                    f"cached for block validation)"]):
+            self.restart_and_wait_for_mempool(
+                extra_args=["-minrelaytxfee=10000"])
+        assert_equal(node.getmempoolinfo()['size'], 0)
+        self.check_first_block_hits_cache(
+            lambda: self.generateblock(
+                node, output=f"raw({self.wallet.get_scriptPubKey().hex()})",
+                transactions=[tx['hex'] for tx in txs]))
+
+
+if __name__ == '__main__':
+    MempoolPersistValidationCacheTest().main()
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+# Copyright (c) 2022 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""
+Test the adaptive block download (-adaptiveblockdownload): during IBD from a
+fast and a slow peer, the blocks held back by the slow peer are requested
+again from the fast one, while with fixed block download windows each block is
+only requested once.
+"""
+
+from test_framework.blocktools import create_block, create_coinbase
+from test_framework.messages import (
+    MSG_BLOCK,
+    MSG_TYPE_MASK,
+    CBlockHeader,
+    CTxOut,
+    msg_block,
+    msg_headers,
+)
+from test_framework.p2p import NetworkThread, P2PInterface, p2p_lock
+from test_framework.script import OP_RETURN, CScript
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+NUM_BLOCKS = 100
+# Size of the data pushed to the coinbase of each block
+BLOCK_PADDING = 10000
+FAST_PEER_DELAY = 0.01
+SLOW_PEER_DELAY = 0.5
+
+
+class ThrottledPeer(P2PInterface):
+    """Serve the blocks, one every `delay` seconds at most."""
+
+    def __init__(self, blocks, delay):
+        super().__init__()
+        self.blocks = {block.sha256: block for block in blocks}
+        self.delay = delay
+        self.next_send_time = 0
+        self.requested = []
+
+    def on_getdata(self, message):
+        loop = NetworkThread.network_event_loop
+        for inv in message.inv:
+            if inv.type & MSG_TYPE_MASK != MSG_BLOCK or \
+                    inv.hash not in self.blocks:
+                continue
+            self.requested.append(inv.hash)
+            self.next_send_time = max(
+                self.next_send_time, loop.time()) + self.delay
+            loop.call_at(self.next_send_time, self.send_message,
+                         msg_block(self.blocks[inv.hash]))
+
+    def on_getheaders(self, message):
+        pass
+
+
+class AdaptiveBlockDownloadTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.setup_clean_chain = True
+        self.extra_args = [
+            ["-adaptiveblockdownload=1"],
+            ["-adaptiveblockdownload=0"],
+        ]
+
+    def setup_network(self):
+        # The nodes sync from the python peers only
+        self.setup_nodes()
+
+    def build_chain(self):
+        node = self.nodes[0]
+        tip = int(node.getbestblockhash(), 16)
+        block_time = node.getblock(node.getbestblockhash())['time'] + 1
+        blocks = []
+        for height in range(1, NUM_BLOCKS + 1):
+            coinbase = create_coinbase(height)
+            coinbase.vout.append(
+                CTxOut(0, CScript([OP_RETURN, b'\x00' * BLOCK_PADDING])))
+            coinbase.rehash()
+            block = create_block(tip, coinbase, block_time)
+            block.solve()
+            blocks.append(block)
+            tip = block.sha256
+            block_time += 1
+        return blocks
+
+    def sync_from_peers(self, node, blocks):
+        """Sync node from a fast and a slow peer, and return the lists of the
+        blocks requested from each of them."""
+        fast_peer = node.add_p2p_connection(
+            ThrottledPeer(blocks, FAST_PEER_DELAY))
+        slow_peer = node.add_p2p_connection(
+            ThrottledPeer(blocks, SLOW_PEER_DELAY))
+
+        for peer in [fast_peer, slow_peer]:
+            peer.send_message(
+                msg_headers([CBlockHeader(block) for block in blocks]))
+        self.wait_until(lambda: node.getbestblockhash() == blocks[-1].hash)
+        with p2p_lock:
+            return list(fast_peer.requested), list(slow_peer.requested)
+
+    def run_test(self):
+        blocks = self.build_chain()
+
+        self.log.info(
+            "Check late blocks are requested again from the faster peer")
+        with self.nodes[0].assert_debug_log(["is late from peer"]):
+            fast, slow = self.sync_from_peers(self.nodes[0], blocks)
+        # No block is requested twice from the same peer
+        assert_equal(len(fast), len(set(fast)))
+        assert_equal(len(slow), len(set(slow)))
+        # Some of the blocks requested from the slow peer are requested again
+        # from the fast one, which serves most of the chain
+        reassigned = set(fast) & set(slow)
+        assert len(reassigned) > 0
+        assert_equal(set(fast) | set(slow), {b.sha256 for b in blocks})
+        assert len(fast) > len(slow)
+
+        self.log.info("Check blocks are not reassigned with fixed windows")
+        fast, slow = self.sync_from_peers(self.nodes[1], blocks)
+        assert_equal(set(fast) & set(slow), set())
+        assert_equal(len(fast) + len(slow), NUM_BLOCKS)
+
+
+if __name__ == '__main__':
+    AdaptiveBlockDownloadTest().main()
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+# Copyright (c) 2022 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""
+Test block relay by set reconciliation (-reconblockrelay): blocks are rebuilt
+from the mempool with a reconblock message, and fall back to compact block
+relay when some transactions are missing.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+NUM_TXS = 100
+
+
+class ReconBlockRelayTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.setup_clean_chain = True
+        self.extra_args = [["-reconblockrelay"]] * self.num_nodes
+
+    def send_txs(self):
+        txs = [self.wallet.send_self_transfer(from_node=self.nodes[0])
+               for _ in range(NUM_TXS)]
+        self.sync_mempools()
+        return txs
+
+    def run_test(self):
+        node0, node1 = self.nodes
+        self.wallet = MiniWallet(node0)
+        self.generate(self.wallet, 2 * NUM_TXS + 1)
+        self.generate(node0, 100)
+
+        self.log.info(
+            "Check blocks with all the transactions in the mempool are "
+            "reconciled")
+        self.send_txs()
+        with node1.assert_debug_log(["Successfully reconciled block"]):
+            blockhash = self.generate(node0, 1)[0]
+        assert_equal(node1.getbestblockhash(), blockhash)
+        assert_equal(node1.getmempoolinfo()['size'], 0)
+        assert 'reconblock' in node1.getpeerinfo()[0]['bytesrecv_per_msg']
+        assert 'getreconblk' in node0.getpeerinfo()[0]['bytesrecv_per_msg']
+
+        self.log.info(
+            "Check blocks with unknown transactions fall back to compact "
+            "blocks")
+        txs = self.send_txs()
+        txs.append(self.wallet.create_self_transfer(from_node=node0))
+        # The block transactions must be in canonical order
+        txs.sort(key=lambda tx: tx['txid'])
+        with node1.assert_debug_log(["Failed to reconcile block",
+                                     "Successfully reconstructed block"]):
+            blockhash = self.generateblock(
+                node0, output=f"raw({self.wallet.get_scriptPubKey().hex()})",
+                transactions=[tx['hex'] for tx in txs])['hash']
+        assert_equal(node1.getbestblockhash(), blockhash)
+        assert_equal(
+            len(node1.getblock(blockhash)['tx']), NUM_TXS + 2)
+
+
+if __name__ == '__main__':
+    ReconBlockRelayTest().main()
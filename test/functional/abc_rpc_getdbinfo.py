@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+# Copyright (c) 2022 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""
+Test the getdbinfo and compactdb RPCs and the -dboption setting.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.test_node import ErrorMatch
+from test_framework.util import assert_equal, assert_raises_rpc_error
+
+
+class GetDBInfoTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [[
+            "-txindex",
+            "-dboption=chainstate:writebuffer=1",
+            "-dboption=chainstate:compression=1",
+        ]]
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.generate(node, 10)
+
+        dbs = {db['name']: db for db in node.getdbinfo()}
+        for name in ['chainstate', 'blockindex', 'txindex']:
+            assert name in dbs
+            assert dbs[name]['bytes_written'] > 0
+            assert 0 <= dbs[name]['cache_hit_rate'] <= 1
+
+        assert_equal(node.compactdb('chainstate'), 1)
+        chainstate = [db for db in node.getdbinfo()
+                      if db['name'] == 'chainstate'][0]
+        assert len(chainstate['levels']) > 0
+
+        assert_raises_rpc_error(-8, "Unknown database foo",
+                                node.compactdb, "foo")
+
+        self.log.info("Check that invalid -dboption values are rejected")
+        self.stop_node(0)
+        for arg, error in [
+            ("-dboption=chainstate", "Invalid -dboption 'chainstate'"),
+            ("-dboption=chainstate:foo=1", "Unknown -dboption option 'foo'"),
+            ("-dboption=chainstate:compression=2",
+             "-dboption value for chainstate:compression is out of range"),
+        ]:
+            node.assert_start_raises_init_error(
+                [arg], f"Error: {error}", match=ErrorMatch.PARTIAL_REGEX)
+
+
+if __name__ == '__main__':
+    GetDBInfoTest().main()
@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+# Copyright (c) 2022 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""
+Test the getvalidationcacheinfo RPC.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+
+class GetValidationCacheInfoTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+
+    def run_test(self):
+        node = self.nodes[0]
+        wallet = MiniWallet(node)
+        wallet.generate(1)
+        self.generate(node, 100)
+
+        info = node.getvalidationcacheinfo()
+        for name in ['signature', 'script']:
+            assert info[name]['max_entries'] > 0
+            assert 0 <= info[name]['hit_rate'] <= 1
+            assert info[name]['evictions'] <= info[name]['inserts']
+
+        self.log.info(
+            "Check the script cache is filled by the mempool and hit by the "
+            "block")
+        before = info['script']
+        wallet.send_self_transfer(from_node=node)
+        after_mempool = node.getvalidationcacheinfo()['script']
+        assert_equal(after_mempool['inserts'], before['inserts'] + 1)
+        assert after_mempool['misses'] > before['misses']
+
+        self.generate(node, 1)
+        after_block = node.getvalidationcacheinfo()['script']
+        assert after_block['hits'] > after_mempool['hits']
+
+
+if __name__ == '__main__':
+    GetValidationCacheInfoTest().main()
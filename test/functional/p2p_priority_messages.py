@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# Copyright (c) 2022 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the processing order of the messages with -prioritymessages.
+
+A peer sends a burst of pings followed by the headers of a new block. With the
+prioritization, the headers are processed ahead of the pings still waiting and
+the block is requested before all the pongs are sent. Without it, the messages
+are processed in the order they were received.
+"""
+
+from test_framework.blocktools import create_block, create_coinbase
+from test_framework.messages import CBlockHeader, msg_headers, msg_ping
+from test_framework.p2p import P2PInterface, p2p_lock
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_greater_than
+
+NUM_PINGS = 1000
+# Don't collide with the nonces of sync_with_ping
+PING_NONCE_OFFSET = 1 << 32
+
+
+class MessageOrderTracker(P2PInterface):
+    def __init__(self):
+        super().__init__()
+        self.pongs_received = 0
+        self.pongs_before_getdata = None
+
+    def on_pong(self, message):
+        super().on_pong(message)
+        if message.nonce >= PING_NONCE_OFFSET:
+            self.pongs_received += 1
+
+    def on_getdata(self, message):
+        super().on_getdata(message)
+        if self.pongs_before_getdata is None:
+            self.pongs_before_getdata = self.pongs_received
+
+
+class PriorityMessagesTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [["-prioritymessages=1"], ["-prioritymessages=0"]]
+
+    def setup_network(self):
+        # The nodes are not connected, each one gets its own block
+        self.setup_nodes()
+
+    def send_pings_and_headers(self, node):
+        # The tip needs to be recent for the block to be requested right away
+        self.generate(node, 1, sync_fun=self.no_op)
+        tip = node.getblock(node.getbestblockhash())
+        block = create_block(int(tip["hash"], 16),
+                             create_coinbase(tip["height"] + 1),
+                             tip["time"] + 1)
+        block.solve()
+
+        peer = node.add_p2p_connection(MessageOrderTracker())
+        # Send everything at once so the messages are queued together
+        raw_messages = b"".join(
+            peer.build_message(msg_ping(PING_NONCE_OFFSET + i))
+            for i in range(NUM_PINGS))
+        raw_messages += peer.build_message(
+            msg_headers([CBlockHeader(block)]))
+        peer.send_raw_message(raw_messages)
+
+        def all_received():
+            return (peer.pongs_received == NUM_PINGS and
+                    peer.pongs_before_getdata is not None)
+        peer.wait_until(all_received)
+
+        with p2p_lock:
+            assert_equal(peer.last_message["getdata"].inv[0].hash,
+                         block.sha256)
+            return peer.pongs_before_getdata
+
+    def run_test(self):
+        self.log.info(
+            "Check the headers are processed ahead of the pings with "
+            "-prioritymessages=1")
+        assert_greater_than(
+            NUM_PINGS, self.send_pings_and_headers(self.nodes[0]))
+
+        self.log.info(
+            "Check the messages are processed in order with "
+            "-prioritymessages=0")
+        assert_equal(
+            self.send_pings_and_headers(self.nodes[1]), NUM_PINGS)
+
+
+if __name__ == '__main__':
+    PriorityMessagesTest().main()
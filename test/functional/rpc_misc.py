@@ -41,6 +41,9 @@ class RpcMiscTest(BitcoinTestFramework):
         assert_greater_than(memory['chunks_used'], 0)
         assert_greater_than(memory['chunks_free'], 0)
         assert_equal(memory['used'] + memory['free'], memory['total'])
+        # The node logs synchronously by default
+        assert_equal(node.getmemoryinfo()['logging'],
+                     {'queued': 0, 'dropped': 0})
 
         self.log.info("test mallocinfo")
         try:
@@ -81,13 +84,32 @@ class RpcMiscTest(BitcoinTestFramework):
         logging_help = self.nodes[0].help('logging')
         assert f"valid logging categories are: {categories}" in logging_help
 
+        self.log.info("test getlockprofile and setlockprofile")
+        assert_equal(node.getlockprofile(), {"samplerate": 0, "sites": []})
+        node.setlockprofile(1)
+        node.getblockcount()
+        profile = node.getlockprofile(reset=True)
+        assert_equal(profile["samplerate"], 1)
+        cs_main = [site for site in profile["sites"]
+                   if site["mutex"] == "cs_main"]
+        assert_greater_than(len(cs_main), 0)
+        for site in cs_main:
+            assert_greater_than(site["samples"], 0)
+            assert_equal(sum(site["wait_histogram"]), site["samples"])
+            assert_equal(sum(site["hold_histogram"]), site["samples"])
+        node.setlockprofile(0)
+        assert_equal(node.getlockprofile()["samplerate"], 0)
+        assert_raises_rpc_error(-8, "samplerate out of range",
+                                node.setlockprofile, -1)
+
         self.log.info("test getindexinfo")
         # Without any indices running the RPC returns an empty object
         assert_equal(node.getindexinfo(), {})
 
         # Restart the node with indices and wait for them to sync
         self.restart_node(
-            0, ["-txindex", "-blockfilterindex", "-coinstatsindex"])
+            0, ["-txindex", "-blockfilterindex", "-coinstatsindex",
+                "-lockprofile=1000"])
         self.wait_until(
             lambda: all(i["synced"] for i in node.getindexinfo().values()))
 
@@ -108,6 +130,9 @@ class RpcMiscTest(BitcoinTestFramework):
         # Specifying an unknown index name returns an empty result
         assert_equal(node.getindexinfo("foo"), {})
 
+        # The lock profiler can be enabled at startup
+        assert_equal(node.getlockprofile()["samplerate"], 1000)
+
 
 if __name__ == '__main__':
     RpcMiscTest().main()
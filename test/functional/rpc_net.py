@@ -64,6 +64,7 @@ class NetTest(BitcoinTestFramework):
         self.test_connection_count()
         self.test_getpeerinfo()
         self.test_getnettotals()
+        self.test_getmessagestats()
         self.test_getnetworkinfo()
         self.test_getaddednodeinfo()
         self.test_service_flags()
@@ -112,6 +113,34 @@ class NetTest(BitcoinTestFramework):
                     >= peer_before['bytessent_per_msg'].get('ping', 0) + 32,
                 timeout=10)
 
+    def test_getmessagestats(self):
+        self.log.info("Test getmessagestats")
+        stats = self.nodes[0].getmessagestats()
+        # Only the processed message types are listed
+        assert 'version' in stats['messages']
+        assert 'reject' not in stats['messages']
+        for msg_stats in stats['messages'].values():
+            assert_greater_than(msg_stats['count'], 0)
+            assert_equal(sum(msg_stats['histogram']), msg_stats['count'])
+            assert msg_stats['max_time'] <= msg_stats['total_time']
+            assert msg_stats['cs_main_time'] <= msg_stats['total_time']
+
+        # Processing the pongs is accounted for
+        pongs = stats['messages']['pong']['count']
+        self.nodes[0].ping()
+        self.wait_until(
+            lambda: self.nodes[0].getmessagestats()['messages']['pong'][
+                'count'] >= pongs + 2,
+            timeout=10)
+
+        peer_ids = sorted(p['id'] for p in self.nodes[0].getpeerinfo())
+        assert_equal(sorted(p['id'] for p in stats['peers']), peer_ids)
+        for peer in stats['peers']:
+            for field in ['process_queue_msgs', 'process_queue_bytes',
+                          'process_queue_age', 'send_queue_bytes',
+                          'send_queue_age']:
+                assert peer[field] >= 0
+
     def test_getnetworkinfo(self):
         self.log.info("Test getnetworkinfo")
         info = self.nodes[0].getnetworkinfo()